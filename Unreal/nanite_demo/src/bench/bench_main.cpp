@@ -0,0 +1,786 @@
+// NaniteBench: headless benchmarks for the loading / build / runtime stages.
+// Each command runs one stage on a mesh and prints timings and memory use.
+
+#include "core/mesh_loader.h"
+#include "core/mesh_cleanup.h"
+#include "core/procedural_mesh.h"
+#include "core/radix_sort.h"
+#include "core/mapped_file.h"
+#include "core/obj_parser.h"
+#include "core/flat_hash_map.h"
+#include "build/cluster.h"
+#include "build/cluster_dag.h"
+#include "build/cluster_encoding.h"
+#include "build/stream_clusters.h"
+#include "build/async_build.h"
+#include "runtime/dag_traversal.h"
+#include "runtime/rasterizer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace nanite;
+
+// ---------- Helpers ----------
+
+// Heap allocations made by this process (operator new calls), to compare how
+// allocation-heavy the stages are. Every replaceable form is replaced, so no
+// allocation reaches a delete it was not made for (std::stable_sort uses the
+// nothrow form, over-aligned types the align_val_t forms).
+static std::atomic<uint64_t> gNumAllocations{ 0 };
+
+static void* countedAlloc(size_t size) noexcept {
+    gNumAllocations++;
+    return malloc(size ? size : 1);
+}
+
+static void* countedAlignedAlloc(size_t size, std::align_val_t alignment) noexcept {
+    gNumAllocations++;
+    size_t align = (size_t)alignment;
+    size = (size + align - 1) / align * align; // aligned_alloc wants a multiple of the alignment
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : align, align);
+#else
+    return aligned_alloc(align, size ? size : align);
+#endif
+}
+
+static void alignedFree(void* p) noexcept {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+void* operator new(size_t size) {
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new(size_t size, std::align_val_t align) {
+    if (void* p = countedAlignedAlloc(size, align)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size, std::align_val_t align) {
+    if (void* p = countedAlignedAlloc(size, align)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return countedAlignedAlloc(size, align);
+}
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return countedAlignedAlloc(size, align);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(p); }
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Peak resident set size of this process, in MB.
+static double getPeakRSSMB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return pmc.PeakWorkingSetSize / (1024.0 * 1024.0);
+    return 0.0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);  // bytes
+#else
+    return usage.ru_maxrss / 1024.0;             // kilobytes
+#endif
+#endif
+}
+
+static bool parseOBJFile(const std::string& path, ObjParseResult& obj) {
+    MappedFile file;
+    if (!file.open(path)) {
+        fprintf(stderr, "Cannot open '%s'\n", path.c_str());
+        return false;
+    }
+    parseOBJParallel(file.begin(), file.end(), obj);
+    validateOBJIndices(obj);
+    return true;
+}
+
+// ---------- load: end-to-end mesh loading ----------
+
+static int benchLoad(int argc, char** argv) {
+    if (argc < 1) return -1;
+    RawMesh mesh;
+    auto start = Clock::now();
+    if (!loadMesh(argv[0], mesh)) return 1;
+    double ms = msSince(start);
+    printf("load: %zu vertices, %u triangles in %.1f ms | peak RSS %.1f MB\n",
+           mesh.vertices.size(), mesh.numTris(), ms, getPeakRSSMB());
+    return 0;
+}
+
+// ---------- gen: procedural mesh generation ----------
+
+static int benchGen(int argc, char** argv) {
+    if (argc < 1) return -1;
+    ProceduralMeshOptions options;
+    if (!parseProceduralMeshSpec(argv[0], options)) return 1;
+    if (argc > 1) options.numThreads = (uint32_t)atoi(argv[1]);
+
+    RawMesh mesh;
+    auto start = Clock::now();
+    if (!generateProceduralMesh(options, mesh)) return 1;
+    double ms = msSince(start);
+    printf("gen: %zu vertices, %u triangles in %.1f ms (%.1f Mtris/s) | bounds (%.2f %.2f %.2f)-(%.2f %.2f %.2f) | peak RSS %.1f MB\n",
+           mesh.vertices.size(), mesh.numTris(), ms, mesh.numTris() / (ms * 1e3),
+           mesh.bounds.min.x, mesh.bounds.min.y, mesh.bounds.min.z,
+           mesh.bounds.max.x, mesh.bounds.max.y, mesh.bounds.max.z, getPeakRSSMB());
+    return 0;
+}
+
+// ---------- sort: Morton key sort of triangle centroids ----------
+
+static int benchSort(int argc, char** argv) {
+    if (argc < 1) return -1;
+    uint32_t numThreads = (argc > 1) ? (uint32_t)atoi(argv[1]) : 0;
+    RawMesh mesh;
+    if (!loadMesh(argv[0], mesh)) return 1;
+
+    // Same keys as buildLeafClusters
+    uint32_t numTris = mesh.numTris();
+    auto centroid = [&](uint32_t t) {
+        return (mesh.vertices[mesh.indices[t * 3 + 0]].position +
+                mesh.vertices[mesh.indices[t * 3 + 1]].position +
+                mesh.vertices[mesh.indices[t * 3 + 2]].position) / 3.0f;
+    };
+    AABB centroidBounds;
+    for (uint32_t t = 0; t < numTris; t++) centroidBounds.expand(centroid(t));
+    MortonFrame frame(centroidBounds, numTris);
+    std::vector<RadixSortItem<uint64_t>> keys(numTris);
+    for (uint32_t t = 0; t < numTris; t++) keys[t] = { frame.encode(centroid(t)), t };
+    auto byKey = [](const RadixSortItem<uint64_t>& a, const RadixSortItem<uint64_t>& b) { return a.key < b.key; };
+
+    double best[3] = { 1e30, 1e30, 1e30 };
+    std::vector<RadixSortItem<uint64_t>> reference, sorted;
+    for (int run = 0; run < 5; run++) {
+        sorted = keys;
+        auto start = Clock::now();
+        std::sort(sorted.begin(), sorted.end(), byKey);
+        best[0] = std::min(best[0], msSince(start));
+
+        reference = keys;
+        start = Clock::now();
+        std::stable_sort(reference.begin(), reference.end(), byKey);
+        best[1] = std::min(best[1], msSince(start));
+
+        sorted = keys;
+        start = Clock::now();
+        radixSort(sorted, numThreads);
+        best[2] = std::min(best[2], msSince(start));
+    }
+    bool identical = true;
+    uint32_t tied = 0; // triangles whose key equals the previous one: order among them is arbitrary
+    for (uint32_t i = 0; i < numTris; i++) {
+        identical &= (sorted[i].key == reference[i].key && sorted[i].index == reference[i].index);
+        tied += (i > 0 && sorted[i].key == sorted[i - 1].key);
+    }
+    printf("sort: %u keys (%u tied) | std::sort %.2f ms | std::stable_sort %.2f ms | radixSort %.2f ms (best of 5) | %s stable order\n",
+           numTris, tied, best[0], best[1], best[2], identical ? "matches" : "DIFFERS from");
+    return identical ? 0 : 1;
+}
+
+// ---------- leaf / stream: in-memory vs out-of-core leaf clusters ----------
+
+// "morton" (default) or "graph"; false if the name is unknown.
+static bool parseLeafClustering(const char* name, LeafClusterOptions& options) {
+    if (strcmp(name, "morton") == 0) options.mode = LeafClustering::MortonRuns;
+    else if (strcmp(name, "graph") == 0) options.mode = LeafClustering::GraphPartition;
+    else return false;
+    return true;
+}
+
+static int benchLeaf(int argc, char** argv) {
+    if (argc < 1) return -1;
+    LeafClusterOptions options;
+    if (argc > 1 && !parseLeafClustering(argv[1], options)) return -1;
+    if (argc > 2) options.numThreads = (uint32_t)atoi(argv[2]);
+    auto start = Clock::now();
+    RawMesh mesh;
+    if (!loadMesh(argv[0], mesh)) return 1;
+    auto buildStart = Clock::now();
+    std::vector<Cluster> clusters;
+    ClusterGeometryPool geometry;
+    buildLeafClusters(mesh, geometry, clusters, options);
+    double buildMs = msSince(buildStart);
+    uint32_t minTris = ~0u, maxTris = 0;
+    for (const Cluster& c : clusters) {
+        minTris = std::min(minTris, c.numTris);
+        maxTris = std::max(maxTris, c.numTris);
+    }
+    // The pool holds only these clusters, so its flags are theirs
+    uint64_t edges = geometry.boundaryEdges.size(), boundaryEdges = geometry.boundaryEdges.count();
+    printf("leaf: %zu clusters (%u..%u triangles) from %u triangles in %.1f ms (clustering %.1f ms) | boundary edges %.1f%% | peak RSS %.1f MB\n",
+           clusters.size(), minTris, maxTris, mesh.numTris(), msSince(start), buildMs,
+           100.0 * boundaryEdges / std::max<uint64_t>(edges, 1), getPeakRSSMB());
+    return 0;
+}
+
+static int benchStream(int argc, char** argv) {
+    if (argc < 1) return -1;
+    StreamBuildOptions options;
+    if (argc > 1) options.memoryBudget = (size_t)atof(argv[1]) * (1u << 20);
+
+    ClusterFileWriter writer;
+    bool writeFile = argc > 2;
+    if (writeFile && !writer.open(argv[2])) return 1;
+    uint64_t numTris = 0;
+    auto start = Clock::now();
+    StreamBuildStats stats;
+    bool ok = buildLeafClustersStreaming(argv[0], [&](const Cluster& c, const ClusterGeometryPool& geometry) {
+        numTris += c.numTris;
+        if (writeFile) writer.write(c, geometry);
+    }, options, &stats);
+    if (writeFile) ok = writer.close() && ok;
+    if (!ok) return 1;
+    printf("stream: %llu clusters from %llu triangles in %.1f ms | budget %.0f MB | peak RSS %.1f MB\n",
+           (unsigned long long)stats.numClusters, (unsigned long long)numTris, msSince(start),
+           options.memoryBudget / (1024.0 * 1024.0), getPeakRSSMB());
+    return 0;
+}
+
+// ---------- dag: full build, cluster quality ----------
+
+// Boundary edges of the leaves: more means less compact clusters, more
+// locked edges and worse simplification higher up.
+static int benchDAG(int argc, char** argv) {
+    if (argc < 1) return -1;
+    LeafClusterOptions options;
+    if (argc > 1 && !parseLeafClustering(argv[1], options)) return -1;
+    RawMesh mesh;
+    if (!loadMesh(argv[0], mesh)) return 1;
+    auto start = Clock::now();
+    ClusterDAG dag;
+    dag.build(mesh, nullptr, options);
+    double ms = msSince(start);
+
+    std::vector<uint64_t> levelTris;
+    uint64_t leafEdges = 0, leafBoundaryEdges = 0;
+    for (const Cluster& c : dag.clusters) {
+        if ((size_t)c.mipLevel >= levelTris.size()) levelTris.resize(c.mipLevel + 1, 0);
+        levelTris[c.mipLevel] += c.numTris;
+        if (c.mipLevel != 0) continue;
+        leafEdges += c.numTris * 3;
+        for (uint32_t e = 0; e < c.numTris * 3; e++) leafBoundaryEdges += dag.geometry.isBoundaryEdge(c, e);
+    }
+    printf("dag: %u triangles in %.1f ms | leaf boundary edges %llu (%.1f%% of %llu) | level 1/0 triangles %.3f | %zu levels, root %llu triangles\n",
+           mesh.numTris(), ms, (unsigned long long)leafBoundaryEdges, 100.0 * leafBoundaryEdges / std::max<uint64_t>(leafEdges, 1),
+           (unsigned long long)leafEdges, levelTris.size() > 1 ? (double)levelTris[1] / levelTris[0] : 1.0,
+           levelTris.size(), (unsigned long long)levelTris.back());
+    return 0;
+}
+
+// ---------- raster: DAG traversal + software rasterization ----------
+
+static const int kViewWidth = 1280, kViewHeight = 720;
+
+// The viewer's initial camera, looking at the whole mesh.
+static void setupInitialView(const RawMesh& mesh, float maxPixelsPerEdge, PackedView& view) {
+    glm::vec3 center = mesh.bounds.center();
+    float radius = std::max(glm::length(mesh.bounds.extent()), 1e-3f);
+    glm::vec3 eye = center + glm::vec3(0, 0, radius * 1.2f);
+    view.setup(eye, glm::normalize(center - eye), glm::vec3(0, 1, 0), glm::radians(45.0f),
+               (float)kViewWidth / (float)kViewHeight, 0.01f, radius * 20.0f, kViewWidth, kViewHeight,
+               maxPixelsPerEdge);
+}
+
+// Frames rendered from the viewer's initial camera at 1280x720; the best
+// time of each stage is reported, rasterizing from the float geometry pool
+// and from its encoding. Also counts the heap allocations of the DAG build.
+static int benchRaster(int argc, char** argv) {
+    if (argc < 1) return -1;
+    int frames = (argc > 1) ? std::max(1, atoi(argv[1])) : 10;
+    float maxPixelsPerEdge = (argc > 2) ? (float)atof(argv[2]) : MAX_PIXELS_PER_EDGE;
+    RawMesh mesh;
+    if (!loadMesh(argv[0], mesh)) return 1;
+    uint64_t allocations = gNumAllocations;
+    auto start = Clock::now();
+    ClusterDAG dag;
+    dag.build(mesh);
+    double buildMs = msSince(start);
+    allocations = gNumAllocations - allocations;
+
+    PackedView view;
+    setupInitialView(mesh, maxPixelsPerEdge, view);
+
+    Framebuffer fb;
+    fb.resize(kViewWidth, kViewHeight);
+    std::vector<VisibleCluster> visible;
+    TraversalStats traversalStats;
+    RasterStats rasterStats;
+    auto packStart = Clock::now();
+    PackedDAG packed;
+    packed.pack(dag);
+    double packMs = msSince(packStart);
+    auto encodeStart = Clock::now();
+    EncodedGeometry encoded;
+    if (!encodeGeometry(dag.geometry, dag.clusters, encoded)) return 1;
+    double encodeMs = msSince(encodeStart);
+    int32_t maxMipLevel = packed.maxMipLevel;
+    double bestTraverse = 1e30, bestRaster = 1e30, bestEncodedRaster = 1e30;
+    for (int frame = 0; frame < frames; frame++) {
+        fb.clear();
+        auto frameStart = Clock::now();
+        traverseDAG(packed, view, visible, traversalStats);
+        bestTraverse = std::min(bestTraverse, msSince(frameStart));
+        frameStart = Clock::now();
+        rasterize(dag.geometry, dag.clusters, visible, view, fb, RenderMode::Solid, rasterStats, maxMipLevel);
+        bestRaster = std::min(bestRaster, msSince(frameStart));
+        fb.clear();
+        frameStart = Clock::now();
+        rasterize(encoded, visible, view, fb, RenderMode::Solid, rasterStats, maxMipLevel);
+        bestEncodedRaster = std::min(bestEncodedRaster, msSince(frameStart));
+    }
+    printf("raster: %zu clusters built in %.1f ms (%llu heap allocations) | geometry %.1f MB, encoded %.1f MB in %.1f ms | %u visible (%u backface culled), %u triangles (%u rasterized) | pack %.2f ms, traverse %.3f ms, raster %.2f ms, encoded %.2f ms (best of %d) | peak RSS %.1f MB\n",
+           dag.clusters.size(), buildMs, (unsigned long long)allocations, dag.geometry.memoryBytes() / (1024.0 * 1024.0),
+           encoded.memoryBytes() / (1024.0 * 1024.0), encodeMs, traversalStats.clustersSelected,
+           traversalStats.clustersBackfaceCulled, traversalStats.totalTriangles, rasterStats.trianglesRasterized, packMs, bestTraverse, bestRaster,
+           bestEncodedRaster, frames, getPeakRSSMB());
+    return 0;
+}
+
+// ---------- sizes: cluster size configurations ----------
+
+// Build and draw the mesh with each ClusterConfig: leaf fill, DAG depth,
+// build time, geometry size, and traversal and raster time (best of
+// `frames`, from the encoded geometry, as the viewer draws).
+static int benchSizes(int argc, char** argv) {
+    if (argc < 1) return -1;
+    int frames = (argc > 1) ? std::max(1, atoi(argv[1])) : 10;
+    float maxPixelsPerEdge = (argc > 2) ? (float)atof(argv[2]) : MAX_PIXELS_PER_EDGE;
+    RawMesh mesh;
+    if (!loadMesh(argv[0], mesh)) return 1;
+    PackedView view;
+    setupInitialView(mesh, maxPixelsPerEdge, view);
+    Framebuffer fb;
+    fb.resize(kViewWidth, kViewHeight);
+
+    struct SizeResult {
+        ClusterSize size;
+        size_t numClusters;
+        uint32_t numLeaves, numLevels;
+        double leafTris, leafVerts, buildMs, encodedMB, traverseMs, rasterMs;
+        uint32_t visible, triangles;
+    };
+    std::vector<SizeResult> results;
+    for (ClusterSize size : { ClusterSize::Tris64, ClusterSize::Tris128, ClusterSize::Tris256 }) {
+        LeafClusterOptions options;
+        options.size = size;
+        auto start = Clock::now();
+        ClusterDAG dag;
+        dag.build(mesh, nullptr, options);
+        double buildMs = msSince(start);
+        PackedDAG packed;
+        packed.pack(dag);
+        EncodedGeometry encoded;
+        if (!encodeGeometry(dag.geometry, dag.clusters, encoded)) return 1;
+
+        SizeResult r = { size, dag.clusters.size(), 0, (uint32_t)packed.maxMipLevel + 1, 0.0, 0.0, buildMs,
+                         encoded.memoryBytes() / (1024.0 * 1024.0), 1e30, 1e30, 0, 0 };
+        for (const Cluster& c : dag.clusters) {
+            if (c.mipLevel != 0) continue;
+            r.numLeaves++;
+            r.leafTris += c.numTris;
+            r.leafVerts += c.numVertices;
+        }
+        r.leafVerts /= std::max(r.leafTris, 1.0);
+        r.leafTris /= std::max(r.numLeaves, 1u);
+
+        std::vector<VisibleCluster> visible;
+        TraversalStats traversalStats;
+        RasterStats rasterStats;
+        for (int frame = 0; frame < frames; frame++) {
+            fb.clear();
+            auto frameStart = Clock::now();
+            traverseDAG(packed, view, visible, traversalStats);
+            r.traverseMs = std::min(r.traverseMs, msSince(frameStart));
+            frameStart = Clock::now();
+            rasterize(encoded, visible, view, fb, RenderMode::Solid, rasterStats, packed.maxMipLevel);
+            r.rasterMs = std::min(r.rasterMs, msSince(frameStart));
+        }
+        r.visible = traversalStats.clustersSelected;
+        r.triangles = traversalStats.totalTriangles;
+        results.push_back(r);
+    }
+
+    printf("sizes: %u triangles, best of %d frames\n", mesh.numTris(), frames);
+    for (const SizeResult& r : results) {
+        printf("  %3u tris/cluster: %zu clusters, %u levels | leaves %.1f tris, %.2f verts/tri | build %.1f ms | encoded %.1f MB | %u visible, %u triangles | traverse %.3f ms, raster %.2f ms\n",
+               (uint32_t)r.size, r.numClusters, r.numLevels, r.leafTris, r.leafVerts, r.buildMs, r.encodedMB,
+               r.visible, r.triangles, r.traverseMs, r.rasterMs);
+    }
+    return 0;
+}
+
+// ---------- encode: quantized cluster geometry ----------
+
+// Size and accuracy of the encoded DAG geometry: position error in grid
+// steps, normal error, and whether every position shared by several
+// clusters (seams, within and across levels) decodes to the same point.
+// Also reports the vertex locality of the triangle order: the average
+// cache miss ratio (misses per triangle) of a 16-entry FIFO, per cluster.
+static int benchEncode(int argc, char** argv) {
+    if (argc < 1) return -1;
+    RawMesh mesh;
+    if (!loadMesh(argv[0], mesh)) return 1;
+    ClusterDAG dag;
+    dag.build(mesh);
+    auto start = Clock::now();
+    EncodedGeometry encoded;
+    if (!encodeGeometry(dag.geometry, dag.clusters, encoded)) return 1;
+    double encodeMs = msSince(start);
+
+    start = Clock::now();
+    std::vector<glm::vec4> decoded(encoded.vertices.size());
+    for (const EncodedCluster& c : encoded.clusters) encoded.decodePositions(c, &decoded[c.vertexOffset]);
+    double decodeMs = msSince(start);
+
+    // Position error per axis, over all clusters and over the leaves alone,
+    // also relative to each leaf's own extent: the leaves are what is drawn
+    // up close, and a small leaf needs a fine grid
+    struct SharedPosition { glm::vec3 position; glm::vec3 decoded; };
+    std::vector<SharedPosition> positions(encoded.vertices.size());
+    float maxError = 0.0f, maxLeafError = 0.0f, maxLeafRelError = 0.0f, minNormalDot = 1.0f;
+    for (const Cluster& c : dag.clusters) {
+        if (c.mipLevel != 0) continue;
+        glm::vec3 extent = c.bounds.max - c.bounds.min;
+        float leafError = 0.0f;
+        const Vertex* src = dag.geometry.clusterVertices(c);
+        for (uint32_t v = 0; v < c.numVertices; v++) {
+            glm::vec3 error = glm::abs(glm::vec3(decoded[c.vertexOffset + v]) - src[v].position);
+            leafError = std::max(leafError, std::max(error.x, std::max(error.y, error.z)));
+        }
+        maxLeafError = std::max(maxLeafError, leafError);
+        float leafExtent = std::max(extent.x, std::max(extent.y, extent.z));
+        if (leafExtent > 0.0f) maxLeafRelError = std::max(maxLeafRelError, leafError / leafExtent);
+    }
+    for (size_t v = 0; v < positions.size(); v++) {
+        const Vertex& src = dag.geometry.vertices[v];
+        positions[v] = { src.position, glm::vec3(decoded[v]) };
+        glm::vec3 error = glm::abs(positions[v].decoded - src.position);
+        maxError = std::max(maxError, std::max(error.x, std::max(error.y, error.z)));
+        const EncodedVertex& ev = encoded.vertices[v];
+        if (glm::length(src.normal) > 0.5f) {
+            minNormalDot = std::min(minNormalDot, glm::dot(decodeOctahedral(ev.normalX, ev.normalY), src.normal));
+        }
+    }
+    auto less = [](const glm::vec3& a, const glm::vec3& b) {
+        return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+    };
+    std::sort(positions.begin(), positions.end(),
+              [&](const SharedPosition& a, const SharedPosition& b) { return less(a.position, b.position); });
+    uint64_t shared = 0, cracks = 0;
+    for (size_t v = 1; v < positions.size(); v++) {
+        if (positions[v].position != positions[v - 1].position) continue;
+        shared++;
+        if (positions[v].decoded != positions[v - 1].decoded) cracks++;
+    }
+
+    uint64_t cacheMisses = 0, numTris = 0;
+    for (const Cluster& c : dag.clusters) {
+        uint32_t fifo[16], fifoSize = 0, fifoHead = 0;
+        const uint32_t* indices = dag.geometry.clusterIndices(c);
+        for (uint32_t i = 0; i < c.numTris * 3; i++) {
+            if (std::find(fifo, fifo + fifoSize, indices[i]) != fifo + fifoSize) continue;
+            cacheMisses++;
+            fifo[fifoHead] = indices[i];
+            fifoHead = (fifoHead + 1) % 16;
+            fifoSize = std::min(fifoSize + 1, 16u);
+        }
+        numTris += c.numTris;
+    }
+
+    size_t floatBytes = dag.geometry.memoryBytes();
+    printf("encode: %zu clusters, %zu vertices | %.1f MB -> %.1f MB (%.2fx) in %.1f ms | decode %.1f Mverts/s | max error %.3g (leaves %.3g, 1/%.0f of their size), normals %.2f deg | %llu shared positions, %llu cracks | ACMR %.3f\n",
+           encoded.clusters.size(), encoded.vertices.size(), floatBytes / (1024.0 * 1024.0),
+           encoded.memoryBytes() / (1024.0 * 1024.0), (double)floatBytes / std::max<size_t>(encoded.memoryBytes(), 1),
+           encodeMs, encoded.vertices.size() / (decodeMs * 1e3), maxError, maxLeafError,
+           maxLeafRelError > 0.0f ? 1.0f / maxLeafRelError : 0.0f,
+           glm::degrees(std::acos(std::min(1.0f, minNormalDot))), (unsigned long long)shared, (unsigned long long)cracks,
+           (double)cacheMisses / std::max<uint64_t>(numTris, 1));
+    return 0;
+}
+
+// ---------- async: background load + DAG build ----------
+
+// Poll an AsyncMeshBuild like the render loop does and report when each kind
+// of content (bounds proxy, first preview level, full DAG) becomes available.
+static int benchAsync(int argc, char** argv) {
+    if (argc < 1) return -1;
+    auto start = Clock::now();
+    AsyncMeshBuild build;
+    build.start(argv[0], false);
+    double startMs = msSince(start), boundsMs = -1.0, previewMs = -1.0;
+    int32_t previewLevel = -1;
+    uint32_t previewTris = 0;
+    bool encoded = false;
+    while (true) {
+        AsyncBuildSnapshot s = build.snapshot();
+        if (s.state == AsyncBuildState::Failed) return 1;
+        encoded = s.geometry != nullptr;
+        if (boundsMs < 0.0 && s.bounds.valid()) boundsMs = msSince(start);
+        if (previewMs < 0.0 && s.preview) {
+            previewMs = msSince(start);
+            previewLevel = s.preview->mipLevel;
+            previewTris = s.preview->numTris;
+        }
+        if (s.dag) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    printf("async: start returned in %.2f ms | bounds at %.1f ms | first preview (level %d, %u tris) at %.1f ms | DAG at %.1f ms (%s geometry)\n",
+           startMs, boundsMs, previewLevel, previewTris, previewMs, msSince(start), encoded ? "encoded" : "float");
+    return 0;
+}
+
+// ---------- normals: vertex normal generation ----------
+
+// The previous serial loop: scatter-add of area-weighted face normals.
+static void computeVertexNormalsScatter(RawMesh& mesh) {
+    for (auto& v : mesh.vertices) v.normal = glm::vec3(0.0f);
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        const glm::vec3& p0 = mesh.vertices[mesh.indices[i + 0]].position;
+        const glm::vec3& p1 = mesh.vertices[mesh.indices[i + 1]].position;
+        const glm::vec3& p2 = mesh.vertices[mesh.indices[i + 2]].position;
+        glm::vec3 fn = glm::cross(p1 - p0, p2 - p0);
+        mesh.vertices[mesh.indices[i + 0]].normal += fn;
+        mesh.vertices[mesh.indices[i + 1]].normal += fn;
+        mesh.vertices[mesh.indices[i + 2]].normal += fn;
+    }
+    for (auto& v : mesh.vertices) {
+        float len = glm::length(v.normal);
+        if (len > 1e-8f) v.normal /= len;
+        else v.normal = glm::vec3(0, 1, 0);
+    }
+}
+
+static int benchNormals(int argc, char** argv) {
+    if (argc < 1) return -1;
+    std::string variant = (argc > 1) ? argv[1] : "area";
+    if (variant != "area" && variant != "angle" && variant != "scatter") return -1;
+    VertexNormalOptions options;
+    options.weighting = (variant == "angle") ? NormalWeighting::Angle : NormalWeighting::Area;
+    options.numThreads = (argc > 2) ? (uint32_t)atoi(argv[2]) : 0;
+
+    RawMesh mesh;
+    if (!loadMesh(argv[0], mesh)) return 1;
+    RawMesh reference = mesh;
+    computeVertexNormalsScatter(reference);
+
+    double best = 1e30;
+    for (int run = 0; run < 5; run++) {
+        auto start = Clock::now();
+        if (variant == "scatter") computeVertexNormalsScatter(mesh);
+        else computeVertexNormals(mesh, options);
+        best = std::min(best, msSince(start));
+    }
+
+    float maxDiff = 0.0f;
+    for (size_t i = 0; i < mesh.vertices.size(); i++)
+        maxDiff = std::max(maxDiff, glm::length(mesh.vertices[i].normal - reference.vertices[i].normal));
+    printf("normals[%s]: %zu vertices, %u triangles in %.2f ms (best of 5) | max diff vs scatter %g\n",
+           variant.c_str(), mesh.vertices.size(), mesh.numTris(), best, maxDiff);
+    return 0;
+}
+
+// ---------- cleanup: weld, degenerate and duplicate removal ----------
+
+static int benchCleanup(int argc, char** argv) {
+    if (argc < 1) return -1;
+    MeshCleanupOptions options;
+    if (argc > 1) options.weldDistance = (float)atof(argv[1]);
+    if (argc > 2) options.numThreads = (uint32_t)atoi(argv[2]);
+
+    RawMesh mesh;
+    if (!loadMesh(argv[0], mesh)) return 1;
+    MeshCleanupStats stats;
+    auto start = Clock::now();
+    cleanupMesh(mesh, options, &stats);
+    double ms = msSince(start);
+    printf("cleanup: weld distance %g | vertices %u -> %u (%u welded, %u unused) | triangles %u -> %u (%u degenerate, %u duplicate) in %.2f ms\n",
+           stats.weldDistance, stats.verticesIn, stats.verticesOut, stats.verticesWelded, stats.verticesUnused,
+           stats.trianglesIn, stats.trianglesOut, stats.degenerateRemoved, stats.duplicateRemoved, ms);
+    return 0;
+}
+
+// ---------- dedup: vertex deduplication table ----------
+
+// Allocator that tallies the bytes a container holds, to report table size.
+static size_t gCountedBytes = 0;
+static size_t gCountedPeakBytes = 0;
+
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+    CountingAllocator() = default;
+    template<typename U> CountingAllocator(const CountingAllocator<U>&) {}
+    T* allocate(size_t n) {
+        gCountedBytes += n * sizeof(T);
+        gCountedPeakBytes = std::max(gCountedPeakBytes, gCountedBytes);
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) {
+        gCountedBytes -= n * sizeof(T);
+        ::operator delete(p);
+    }
+    template<typename U> bool operator==(const CountingAllocator<U>&) const { return true; }
+    template<typename U> bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+// The previous loader's dedup: node-based std::unordered_map, no reserve,
+// find() followed by operator[] for every new vertex.
+static void triangulateOBJStdMap(const ObjParseResult& obj, RawMesh& outMesh) {
+    std::unordered_map<uint64_t, uint32_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                       CountingAllocator<std::pair<const uint64_t, uint32_t>>> vertMap;
+    outMesh.vertices.clear();
+    outMesh.indices.clear();
+    outMesh.bounds = {};
+
+    size_t faceStart = 0;
+    for (uint32_t faceSize : obj.faceSizes) {
+        const ObjFaceVert* face = obj.faceVerts.data() + faceStart;
+        faceStart += faceSize;
+        bool valid = true;
+        for (uint32_t i = 0; i < faceSize; i++) valid &= face[i].v != INVALID_INDEX;
+        if (!valid) continue; // skipped by triangulateOBJ as well
+        for (size_t i = 1; i + 1 < faceSize; i++) {
+            ObjFaceVert tri[3] = { face[0], face[i], face[i + 1] };
+            for (int j = 0; j < 3; j++) {
+                uint64_t key = ((uint64_t)tri[j].v << 32) | tri[j].vn;
+                auto it = vertMap.find(key);
+                if (it != vertMap.end()) {
+                    outMesh.indices.push_back(it->second);
+                } else {
+                    Vertex vert;
+                    vert.position = obj.positions[tri[j].v];
+                    vert.normal = (tri[j].vn != INVALID_INDEX && tri[j].vn < obj.normals.size())
+                                ? obj.normals[tri[j].vn] : glm::vec3(0, 1, 0);
+                    uint32_t idx = (uint32_t)outMesh.vertices.size();
+                    outMesh.vertices.push_back(vert);
+                    outMesh.bounds.expand(vert.position);
+                    vertMap[key] = idx;
+                    outMesh.indices.push_back(idx);
+                }
+            }
+        }
+    }
+    printf("  std::unordered_map: %zu entries, %zu buckets, %.1f MB at peak (+%zu node allocations)\n",
+           vertMap.size(), vertMap.bucket_count(), gCountedPeakBytes / 1e6, vertMap.size());
+}
+
+// Run one variant per process so the peak RSS figures are not mixed.
+static int benchDedup(int argc, char** argv) {
+    if (argc < 1) return -1;
+    std::string variant = (argc > 1) ? argv[1] : "flat";
+    if (variant != "flat" && variant != "std") return -1;
+
+    ObjParseResult obj;
+    if (!parseOBJFile(argv[0], obj)) return 1;
+    double rssAfterParse = getPeakRSSMB();
+
+    RawMesh mesh;
+    auto start = Clock::now();
+    if (variant == "flat") {
+        triangulateOBJ(obj, mesh);
+    } else {
+        triangulateOBJStdMap(obj, mesh);
+    }
+    double ms = msSince(start);
+    if (variant == "flat") {
+        // Same sizing rule as triangulateOBJ
+        FlatHashMap64 table(std::max(obj.positions.size(), obj.normals.size()));
+        printf("  FlatHashMap64: %zu slots, %.1f MB (1 allocation)\n",
+               table.capacity(), table.memoryBytes() / 1e6);
+    }
+
+    printf("dedup[%s]: %zu corners -> %zu vertices in %.1f ms | peak RSS %.1f MB (%.1f MB after parse)\n",
+           variant.c_str(), mesh.indices.size(), mesh.vertices.size(), ms,
+           getPeakRSSMB(), rssAfterParse);
+    return 0;
+}
+
+// ---------- Command table ----------
+
+struct BenchCommand {
+    const char* name;
+    const char* usage;
+    int (*run)(int argc, char** argv);
+};
+
+static const BenchCommand kCommands[] = {
+    { "load",  "load <mesh.obj|.ply|.stl|.glb> loader time and peak RSS", benchLoad },
+    { "gen",   "gen proc:<icosphere|terrain|city>:<tris>[:seed] [threads]  procedural mesh time, peak RSS", benchGen },
+    { "sort",  "sort <mesh> [threads]          Morton key sort: std::sort vs radixSort", benchSort },
+    { "leaf",  "leaf <mesh> [morton|graph] [threads]  in-memory load + buildLeafClusters, cluster sizes, boundary edges, peak RSS", benchLeaf },
+    { "stream", "stream <mesh.obj> [budgetMB] [out.nclusters]  out-of-core leaf clusters, peak RSS", benchStream },
+    { "normals", "normals <mesh> [area|angle|scatter] [threads]  vertex normal generation time", benchNormals },
+    { "cleanup", "cleanup <mesh> [weldDistance] [threads]  mesh cleanup time and what it removed", benchCleanup },
+    { "dag",   "dag <mesh> [morton|graph]      DAG build time, leaf boundary edges, simplification ratio", benchDAG },
+    { "raster", "raster <mesh> [frames] [maxPixelsPerEdge]  DAG build allocations, traversal and raster time, peak RSS", benchRaster },
+    { "sizes", "sizes <mesh> [frames] [maxPixelsPerEdge]  build and draw with 64/128/256-triangle clusters: DAG shape, build, raster time", benchSizes },
+    { "encode", "encode <mesh>                  quantized cluster geometry: size, position (all/leaf)/normal error, seam cracks", benchEncode },
+    { "async", "async <mesh>                   background load/build: time to bounds, preview, DAG", benchAsync },
+    { "dedup", "dedup <mesh.obj> [flat|std]   vertex dedup table time and peak RSS", benchDedup },
+};
+
+int main(int argc, char** argv) {
+    if (argc >= 2) {
+        for (const BenchCommand& cmd : kCommands) {
+            if (strcmp(argv[1], cmd.name) != 0) continue;
+            int rc = cmd.run(argc - 2, argv + 2);
+            if (rc >= 0) return rc;
+            fprintf(stderr, "Usage: NaniteBench %s\n", cmd.usage);
+            return 1;
+        }
+    }
+
+    fprintf(stderr, "Usage: NaniteBench <command> [args]\n");
+    for (const BenchCommand& cmd : kCommands) {
+        fprintf(stderr, "  %s\n", cmd.usage);
+    }
+    return 1;
+}
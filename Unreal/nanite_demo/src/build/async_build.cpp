@@ -0,0 +1,159 @@
+#include "async_build.h"
+#include "../core/mesh_cache.h"
+#include "../core/mesh_cleanup.h"
+#include "../core/procedural_mesh.h"
+#include <chrono>
+#include <cstdio>
+
+namespace nanite {
+
+const char* asyncBuildStateName(AsyncBuildState state) {
+    switch (state) {
+    case AsyncBuildState::Loading:  return "Loading";
+    case AsyncBuildState::Building: return "Building";
+    case AsyncBuildState::Ready:    return "Ready";
+    case AsyncBuildState::Failed:   return "Failed";
+    }
+    return "Unknown";
+}
+
+AsyncMeshBuild::~AsyncMeshBuild() {
+    cancel();
+}
+
+void AsyncMeshBuild::start(const std::string& meshPath, bool useMeshCache, const LeafClusterOptions& leafOptions) {
+    cancel();
+    cancel_ = false;
+    publish([](AsyncBuildSnapshot& s) { s = {}; });
+    worker_ = std::thread(&AsyncMeshBuild::run, this, meshPath, useMeshCache, leafOptions);
+}
+
+void AsyncMeshBuild::cancel() {
+    cancel_ = true;
+    if (worker_.joinable()) worker_.join();
+}
+
+AsyncBuildSnapshot AsyncMeshBuild::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_;
+}
+
+void AsyncMeshBuild::publish(const std::function<void(AsyncBuildSnapshot&)>& update) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    update(current_);
+}
+
+void AsyncMeshBuild::run(std::string meshPath, bool useMeshCache, LeafClusterOptions leafOptions) {
+    using Clock = std::chrono::high_resolution_clock;
+
+    // 1. Load and clean up the mesh (from the .nmesh cache when it is up to date)
+    printf("Loading mesh: %s\n", meshPath.c_str());
+    auto loadStart = Clock::now();
+    RawMesh mesh;
+    std::string cachePath = getMeshCachePath(meshPath);
+    // Procedural meshes are generated clean, and faster than a cache read
+    bool procedural = isProceduralMeshSpec(meshPath);
+    if (procedural || !useMeshCache || !loadMeshCache(cachePath, meshPath, mesh)) {
+        if (!loadMesh(meshPath, mesh)) {
+            publish([](AsyncBuildSnapshot& s) { s.state = AsyncBuildState::Failed; });
+            return;
+        }
+        if (cancel_) return;
+        if (!procedural) {
+            MeshCleanupStats cleanup;
+            cleanupMesh(mesh, {}, &cleanup);
+            printf("Cleanup: %u vertices welded, %u unused, %u degenerate and %u duplicate triangles removed\n",
+                   cleanup.verticesWelded, cleanup.verticesUnused, cleanup.degenerateRemoved, cleanup.duplicateRemoved);
+            if (useMeshCache) saveMeshCache(cachePath, meshPath, mesh);
+        }
+    }
+    if (cancel_) return;
+    printf("Load complete: %.1f ms\n",
+           std::chrono::duration<float, std::milli>(Clock::now() - loadStart).count());
+    printf("Mesh: %zu vertices, %u triangles\n", mesh.vertices.size(), mesh.numTris());
+
+    publish([&](AsyncBuildSnapshot& s) {
+        s.state = AsyncBuildState::Building;
+        s.bounds = mesh.bounds;
+        s.numTris = mesh.numTris();
+    });
+
+    // 2. Build Nanite DAG, publishing each level that is small enough to preview
+    printf("\n--- Building Cluster DAG ---\n");
+    auto buildStart = Clock::now();
+    auto dag = std::make_shared<ClusterDAG>();
+    bool complete = dag->build(mesh, [&](const ClusterDAG& d, const std::vector<uint32_t>& level) {
+        if (cancel_) return false;
+        uint32_t numTris = 0;
+        for (uint32_t ci : level) numTris += d.clusters[ci].numTris;
+        if (numTris > PREVIEW_MAX_TRIS) return true;
+
+        auto preview = std::make_shared<BuildPreview>();
+        preview->clusters.reserve(level.size());
+        for (uint32_t ci : level) {
+            Cluster c = d.clusters[ci];
+            preview->geometry.append(c, d.geometry);
+            preview->clusters.push_back(c);
+        }
+        preview->mipLevel = d.clusters[level[0]].mipLevel;
+        preview->numTris = numTris;
+        publish([&](AsyncBuildSnapshot& s) { s.preview = std::move(preview); });
+        return true;
+    }, leafOptions);
+    if (!complete) return;
+    printf("Build complete: %.1f ms\n",
+           std::chrono::duration<float, std::milli>(Clock::now() - buildStart).count());
+
+    // 3. Encode the geometry for drawing and drop the float copy. A DAG whose
+    // geometry cannot be encoded is still complete: it keeps the float copy
+    // and is drawn from that instead.
+    if (cancel_) return;
+    auto geometry = std::make_shared<EncodedGeometry>();
+    if (encodeGeometry(dag->geometry, dag->clusters, *geometry)) {
+        printf("Encoded geometry: %.1f MB -> %.1f MB\n",
+               dag->geometry.memoryBytes() / (1024.0 * 1024.0), geometry->memoryBytes() / (1024.0 * 1024.0));
+        dag->geometry = ClusterGeometryPool();
+    } else {
+        fprintf(stderr, "Warning: Drawing the cluster geometry unencoded\n");
+        geometry.reset();
+    }
+
+    publish([&](AsyncBuildSnapshot& s) {
+        s.state = AsyncBuildState::Ready;
+        s.dag = std::move(dag);
+        s.geometry = std::move(geometry);
+        s.preview.reset();
+    });
+}
+
+Cluster makeBoundsProxyCluster(const AABB& bounds, ClusterGeometryPool& outGeometry) {
+    // Per face: outward normal and its four corners, counter-clockwise seen from outside
+    static const int kFaces[6][4] = {
+        { 1, 3, 7, 5 }, { 0, 4, 6, 2 },   // +X, -X
+        { 2, 6, 7, 3 }, { 0, 1, 5, 4 },   // +Y, -Y
+        { 4, 5, 7, 6 }, { 0, 2, 3, 1 },   // +Z, -Z
+    };
+    static const glm::vec3 kNormals[6] = {
+        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+    };
+
+    ClusterGeometry box;
+    for (int f = 0; f < 6; f++) {
+        uint32_t base = (uint32_t)box.vertices.size();
+        for (int k = 0; k < 4; k++) {
+            int corner = kFaces[f][k]; // bit 0 = x, bit 1 = y, bit 2 = z
+            glm::vec3 p((corner & 1) ? bounds.max.x : bounds.min.x,
+                        (corner & 2) ? bounds.max.y : bounds.min.y,
+                        (corner & 4) ? bounds.max.z : bounds.min.z);
+            box.vertices.push_back({ p, kNormals[f] });
+        }
+        const uint32_t quad[6] = { 0, 1, 2, 0, 2, 3 };
+        for (uint32_t i : quad) box.indices.push_back(base + i);
+    }
+    Cluster proxy;
+    proxy.computeBoundsAndMetrics(box);
+    outGeometry.append(proxy, box);
+    return proxy;
+}
+
+} // namespace nanite
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "cluster_dag.h"
+#include "cluster_encoding.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace nanite {
+
+enum class AsyncBuildState {
+    Loading,    // reading the mesh (or its .nmesh cache)
+    Building,   // mesh bounds known, DAG levels being built
+    Ready,      // DAG complete
+    Failed,
+};
+
+const char* asyncBuildStateName(AsyncBuildState state);
+
+// Coarsest geometry available while the DAG is still being built: copies of
+// the clusters of the newest level that fits the preview triangle budget.
+struct BuildPreview {
+    std::vector<Cluster> clusters;
+    ClusterGeometryPool  geometry;
+    int32_t              mipLevel = 0;
+    uint32_t             numTris  = 0;
+};
+
+// What the render loop may draw right now. Fields are filled in as the build
+// progresses: bounds once the mesh is loaded, preview after each level that
+// fits the budget, dag and geometry when the build is complete. The dag's
+// own float geometry is released by then: its clusters are drawn from
+// `geometry` (same cluster indices). If encoding failed, `geometry` stays
+// null and the dag keeps its float geometry to draw from.
+struct AsyncBuildSnapshot {
+    AsyncBuildState                        state = AsyncBuildState::Loading;
+    AABB                                   bounds;
+    uint32_t                               numTris = 0;
+    std::shared_ptr<const BuildPreview>    preview;
+    std::shared_ptr<const ClusterDAG>      dag;
+    std::shared_ptr<const EncodedGeometry> geometry;
+};
+
+// Loads a mesh and builds its DAG on a background thread, so the window and
+// render loop start immediately regardless of the asset size.
+class AsyncMeshBuild {
+public:
+    // Levels above this many triangles are not copied out as previews
+    // (the first preview is usually an intermediate level, not the leaves).
+    static constexpr uint32_t PREVIEW_MAX_TRIS = 256 * 1024;
+
+    AsyncMeshBuild() = default;
+    ~AsyncMeshBuild();
+
+    AsyncMeshBuild(const AsyncMeshBuild&) = delete;
+    AsyncMeshBuild& operator=(const AsyncMeshBuild&) = delete;
+
+    // Start loading `meshPath` (through the .nmesh cache if `useMeshCache`).
+    void start(const std::string& meshPath, bool useMeshCache, const LeafClusterOptions& leafOptions = {});
+
+    // Stop at the next stage (load, cleanup, build, encode) or DAG level
+    // boundary and wait for the worker. The mesh loader itself is not
+    // interruptible.
+    void cancel();
+
+    // Current state; cheap (shared pointers are copied, geometry is not).
+    AsyncBuildSnapshot snapshot() const;
+
+private:
+    std::thread        worker_;
+    std::atomic<bool>  cancel_{ false };
+    mutable std::mutex mutex_;
+    AsyncBuildSnapshot current_;
+
+    void run(std::string meshPath, bool useMeshCache, LeafClusterOptions leafOptions);
+    void publish(const std::function<void(AsyncBuildSnapshot&)>& update);
+};
+
+// Box mesh of `bounds` (12 triangles, outward-facing), drawn as a stand-in
+// while no geometry is available. Its geometry is appended to outGeometry.
+Cluster makeBoundsProxyCluster(const AABB& bounds, ClusterGeometryPool& outGeometry);
+
+} // namespace nanite
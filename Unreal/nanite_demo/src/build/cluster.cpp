@@ -1,6 +1,13 @@
 #include "cluster.h"
-#include <unordered_map>
+#include "graph_partition.h"
+#include "edge_runs.h"
+#include "../core/radix_sort.h"
+#include "../core/flat_hash_map.h"
+#include "../core/parallel.h"
 #include <numeric>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 namespace nanite {
 
@@ -21,20 +28,106 @@ uint32_t mortonEncode(const glm::vec3& normalizedPos) {
     return expandBits(x) | (expandBits(y) << 1) | (expandBits(z) << 2);
 }
 
+// Spread the low 21 bits of v to every third bit.
+static uint64_t expandBits64(uint64_t v) {
+#if defined(__BMI2__)
+    return _pdep_u64(v, 0x1249249249249249ull);
+#else
+    v &= 0x1FFFFF;
+    v = (v | (v << 32)) & 0x001F00000000FFFFull;
+    v = (v | (v << 16)) & 0x001F0000FF0000FFull;
+    v = (v | (v <<  8)) & 0x100F00F00F00F00Full;
+    v = (v | (v <<  4)) & 0x10C30C30C30C30C3ull;
+    v = (v | (v <<  2)) & 0x1249249249249249ull;
+    return v;
+#endif
+}
+
+uint64_t mortonEncode64(const glm::vec3& normalizedPos, uint32_t bitsPerAxis) {
+    const float maxCoord = (float)((1u << bitsPerAxis) - 1);
+    glm::vec3 q = glm::clamp(normalizedPos * maxCoord, glm::vec3(0.0f), glm::vec3(maxCoord));
+    return expandBits64((uint64_t)q.x) | (expandBits64((uint64_t)q.y) << 1) | (expandBits64((uint64_t)q.z) << 2);
+}
+
+// Extra bits per axis beyond sqrt(numPoints) cells across the set.
+static constexpr uint32_t MORTON_SURFACE_MARGIN_BITS = 4;
+
+MortonFrame::MortonFrame(const AABB& pointBounds, uint32_t numPoints) {
+    uint32_t log2Points = 0;
+    while (log2Points < 32 && (1ull << log2Points) < numPoints) log2Points++;
+    bitsPerAxis = std::min(21u, std::max(10u, (log2Points + 1) / 2 + MORTON_SURFACE_MARGIN_BITS));
+    if (!pointBounds.valid()) return;
+    glm::vec3 size = pointBounds.max - pointBounds.min;
+    float extent = std::max(std::max(size.x, size.y), size.z);
+    origin = pointBounds.min;
+    scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+}
+
 // ---------- Cluster Methods ----------
 
-void Cluster::computeBoundsAndMetrics() {
+// Normal cone of a triangle set (the construction of meshoptimizer's
+// meshopt_computeClusterBounds). Zero-area triangles are never drawn and
+// do not count.
+static NormalCone computeNormalCone(const ClusterGeometry& geometry, uint32_t numTris, const glm::vec3& center) {
+    const std::vector<Vertex>& vertices = geometry.vertices;
+    const std::vector<uint32_t>& indices = geometry.indices;
+    auto unitNormal = [&](uint32_t tri, glm::vec3& normal) {
+        const glm::vec3& p0 = vertices[indices[tri * 3 + 0]].position;
+        glm::vec3 cross = glm::cross(vertices[indices[tri * 3 + 1]].position - p0,
+                                     vertices[indices[tri * 3 + 2]].position - p0);
+        float length = glm::length(cross);
+        if (length <= 0.0f) return false;
+        normal = cross / length;
+        return true;
+    };
+
+    NormalCone cone;
+    glm::vec3 normal, normalSum(0.0f);
+    for (uint32_t i = 0; i < numTris; i++) {
+        if (unitNormal(i, normal)) normalSum += normal;
+    }
+    float sumLength = glm::length(normalSum);
+    if (sumLength <= 0.0f) return cone;
+    glm::vec3 axis = normalSum / sumLength;
+
+    // The widest normal sets the opening. Past ~84 degrees the cone could
+    // only cull from right behind the cluster, so it is left empty.
+    float minDot = 1.0f;
+    for (uint32_t i = 0; i < numTris; i++) {
+        if (unitNormal(i, normal)) minDot = std::min(minDot, glm::dot(axis, normal));
+    }
+    if (minDot <= 0.1f) return cone;
+
+    // Apex: back along the axis from the center until it is behind every
+    // triangle's plane
+    float maxT = 0.0f;
+    for (uint32_t i = 0; i < numTris; i++) {
+        const glm::vec3& p0 = vertices[indices[i * 3 + 0]].position;
+        if (unitNormal(i, normal)) maxT = std::max(maxT, glm::dot(center - p0, normal) / glm::dot(axis, normal));
+    }
+    cone.apex = center - axis * maxT;
+    cone.axis = axis;
+    cone.cutoff = std::sqrt(1.0f - minDot * minDot);
+    return cone;
+}
+
+void Cluster::computeBoundsAndMetrics(const ClusterGeometry& geometry) {
+    const std::vector<Vertex>& vertices = geometry.vertices;
+    const std::vector<uint32_t>& indices = geometry.indices;
     bounds = {};
     surfaceArea = 0.0f;
     edgeLength = 0.0f;
-    numTris = (uint32_t)(indices.size() / 3);
+    numTris = geometry.numTris();
 
     if (vertices.empty() || indices.empty()) return;
 
     for (auto& v : vertices) {
         bounds.expand(v.position);
     }
-    sphereBounds = BoundingSphere::fromAABB(bounds);
+    // Ritter sphere of the vertices, unless the box's circumsphere is tighter
+    sphereBounds = BoundingSphere::fromPoints(&vertices[0].position, (uint32_t)vertices.size(), sizeof(Vertex));
+    BoundingSphere boxSphere = BoundingSphere::fromAABB(bounds);
+    if (boxSphere.radius < sphereBounds.radius) sphereBounds = boxSphere;
 
     float totalEdgeLen = 0.0f;
     uint32_t edgeCount = 0;
@@ -52,6 +145,7 @@ void Cluster::computeBoundsAndMetrics() {
         edgeCount += 3;
     }
     edgeLength = (edgeCount > 0) ? (totalEdgeLen / (float)edgeCount) : 0.0f;
+    normalCone = computeNormalCone(geometry, numTris, sphereBounds.center);
 
     // lodBounds defaults to sphereBounds at leaf level
     if (lodBounds.radius <= 0.0f) {
@@ -59,176 +153,525 @@ void Cluster::computeBoundsAndMetrics() {
     }
 }
 
-void Cluster::computeBoundaryEdges() {
-    boundaryEdges.resize(numTris * 3, false);
-
-    // Build edge -> triangle count map
-    // Edge key: sorted pair of vertex positions (quantized)
-    struct EdgeKey {
-        uint64_t a, b;
-        bool operator==(const EdgeKey& o) const { return a == o.a && b == o.b; }
-    };
-    struct EdgeHash {
-        size_t operator()(const EdgeKey& k) const {
-            return std::hash<uint64_t>()(k.a) ^ (std::hash<uint64_t>()(k.b) * 2654435761u);
+void ClusterGeometry::computeBoundaryEdges() {
+    uint32_t numEdges = numTris() * 3;
+    boundaryEdges.assign(numEdges, false);
+    if (numEdges == 0) return;
+
+    // An edge whose run has length 1 has only one adjacent triangle. The
+    // buffers are reused by every cluster built on this thread.
+    thread_local std::vector<uint32_t> bucketEnd;
+    thread_local std::vector<uint64_t> records;
+    auto forEachEdge = [&](auto&& fn) {
+        for (uint32_t edge = 0; edge < numEdges; edge++) {
+            uint32_t a = indices[edge], b = indices[edge - edge % 3 + (edge % 3 + 1) % 3];
+            fn(edge, std::min(a, b), std::max(a, b));
         }
     };
+    sortEdgeRuns((uint32_t)vertices.size(), numEdges, forEachEdge, bucketEnd, records, [&](uint32_t begin, uint32_t end) {
+        if (end - begin == 1) boundaryEdges.set((uint32_t)records[begin]);
+    });
+}
 
-    auto posToKey = [](const glm::vec3& p) -> uint64_t {
-        // Quantize to avoid floating point issues
-        int32_t x = (int32_t)(p.x * 10000.0f);
-        int32_t y = (int32_t)(p.y * 10000.0f);
-        int32_t z = (int32_t)(p.z * 10000.0f);
-        return ((uint64_t)(uint32_t)x << 40) | ((uint64_t)(uint32_t)y << 20) | (uint64_t)(uint32_t)z;
+// ---------- Geometry Pool ----------
+
+void ClusterGeometryPool::append(Cluster& c, const ClusterGeometry& geometry) {
+    c.vertexOffset = (uint32_t)vertices.size();
+    c.numVertices = (uint32_t)geometry.vertices.size();
+    c.indexOffset = (uint32_t)indices.size();
+    c.numTris = geometry.numTris();
+    vertices.insert(vertices.end(), geometry.vertices.begin(), geometry.vertices.end());
+    indices.insert(indices.end(), geometry.indices.begin(), geometry.indices.begin() + c.numTris * 3);
+    boundaryEdges.resize(indices.size());
+    for (uint32_t e = 0; e < c.numTris * 3 && e < geometry.boundaryEdges.size(); e++) {
+        if (geometry.boundaryEdges[e]) boundaryEdges.set(c.indexOffset + e);
+    }
+}
+
+void ClusterGeometryPool::append(Cluster& c, const ClusterGeometryPool& source) {
+    const Vertex* srcVertices = source.clusterVertices(c);
+    const uint32_t* srcIndices = source.clusterIndices(c);
+    uint32_t srcIndexOffset = c.indexOffset;
+    c.vertexOffset = (uint32_t)vertices.size();
+    c.indexOffset = (uint32_t)indices.size();
+    vertices.insert(vertices.end(), srcVertices, srcVertices + c.numVertices);
+    indices.insert(indices.end(), srcIndices, srcIndices + c.numTris * 3);
+    boundaryEdges.resize(indices.size());
+    for (uint32_t e = 0; e < c.numTris * 3; e++) {
+        if (source.boundaryEdges[srcIndexOffset + e]) boundaryEdges.set(c.indexOffset + e);
+    }
+}
+
+void ClusterGeometryPool::reserve(size_t numVertices, size_t numIndices) {
+    vertices.reserve(numVertices);
+    indices.reserve(numIndices);
+    boundaryEdges.reserve(numIndices);
+}
+
+void ClusterGeometryPool::clear() {
+    vertices.clear();
+    indices.clear();
+    boundaryEdges.clear();
+}
+
+size_t ClusterGeometryPool::memoryBytes() const {
+    return vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t) + boundaryEdges.words().size() * 8;
+}
+
+// ---------- Gather Cluster Triangles ----------
+
+// Source vertex -> local index in the cluster being gathered. Entries
+// stamped with an older epoch are unset, so starting a cluster costs one
+// increment rather than a clear of the whole table.
+struct LocalIndexMap {
+    struct Entry {
+        uint32_t epoch = 0;
+        uint32_t local = 0;
     };
+    std::vector<Entry> entries;     // one per source vertex
+    uint32_t           epoch = 0;
+
+    explicit LocalIndexMap(size_t numSourceVertices) : entries(numSourceVertices) {}
 
-    auto makeEdgeKey = [&](uint32_t i0, uint32_t i1) -> EdgeKey {
-        uint64_t a = posToKey(vertices[i0].position);
-        uint64_t b = posToKey(vertices[i1].position);
-        if (a > b) std::swap(a, b);
-        return { a, b };
+    void nextCluster() {
+        if (++epoch == 0) {
+            std::fill(entries.begin(), entries.end(), Entry());
+            epoch = 1;
+        }
+    }
+    bool contains(uint32_t source) const { return entries[source].epoch == epoch; }
+    uint32_t findOrInsert(uint32_t source, uint32_t local, bool& inserted) {
+        Entry& entry = entries[source];
+        inserted = entry.epoch != epoch;
+        if (inserted) {
+            entry.epoch = epoch;
+            entry.local = local;
+        }
+        return entry.local;
+    }
+};
+
+// LocalIndexMap for a large source (a whole mesh): an open-addressing
+// table of 4 * MAX_CLUSTER_VERTICES slots, which one cluster fills at most
+// a quarter of. Its 12 KB do not grow with the source, so every task can
+// own one.
+struct HashedLocalIndexMap {
+    static constexpr uint32_t SLOT_BITS = 10;
+    static_assert((1u << SLOT_BITS) >= MAX_CLUSTER_VERTICES * 4, "HashedLocalIndexMap is too small");
+    struct Slot {
+        uint32_t epoch  = 0;
+        uint32_t source = 0;
+        uint32_t local  = 0;
     };
+    std::vector<Slot> slots = std::vector<Slot>(1u << SLOT_BITS);
+    uint32_t          epoch = 0;
+
+    void nextCluster() {
+        if (++epoch == 0) {
+            std::fill(slots.begin(), slots.end(), Slot());
+            epoch = 1;
+        }
+    }
+    // First slot of the probe sequence (Fibonacci hashing)
+    static uint32_t home(uint32_t source) { return (source * 0x9E3779B1u) >> (32 - SLOT_BITS); }
+    bool contains(uint32_t source) const {
+        for (uint32_t s = home(source);; s = (s + 1) & ((1u << SLOT_BITS) - 1)) {
+            if (slots[s].epoch != epoch) return false;
+            if (slots[s].source == source) return true;
+        }
+    }
+    uint32_t findOrInsert(uint32_t source, uint32_t local, bool& inserted) {
+        for (uint32_t s = home(source);; s = (s + 1) & ((1u << SLOT_BITS) - 1)) {
+            Slot& slot = slots[s];
+            if (slot.epoch != epoch) {
+                slot = { epoch, source, local };
+                inserted = true;
+                return local;
+            }
+            if (slot.source == source) {
+                inserted = false;
+                return slot.local;
+            }
+        }
+    }
+};
+
+// Gather the triangles sourceTri(begin), sourceTri(begin + 1), ... (up to
+// `end`) of a source mesh into `geometry`, with local indices in first-use
+// order and no boundary edge flags. Stops before a triangle that would take
+// the cluster past Config::MAX_VERTICES. Returns the first triangle not taken.
+template<typename Config, typename SourceTri, typename IndexMap>
+static uint32_t gatherTriangles(const Vertex* srcVertices, const uint32_t* srcIndices,
+                                uint32_t begin, uint32_t end, const SourceTri& sourceTri,
+                                IndexMap& localIndex, ClusterGeometry& geometry)
+{
+    geometry.vertices.clear();
+    geometry.indices.clear();
+    geometry.boundaryEdges.clear();
+    localIndex.nextCluster();
+    uint32_t i = begin;
+    for (; i < end; i++) {
+        const uint32_t* tri = &srcIndices[(size_t)sourceTri(i) * 3];
+        uint32_t numNew = 0;
+        for (int v = 0; v < 3; v++) numNew += localIndex.contains(tri[v]) ? 0 : 1;
+        if (i > begin && geometry.vertices.size() + numNew > Config::MAX_VERTICES) break;
+        for (int v = 0; v < 3; v++) {
+            bool inserted;
+            uint32_t local = localIndex.findOrInsert(tri[v], (uint32_t)geometry.vertices.size(), inserted);
+            if (inserted) geometry.vertices.push_back(srcVertices[tri[v]]);
+            geometry.indices.push_back(local);
+        }
+    }
+    return i;
+}
+
+// ---------- Triangle Order ----------
+
+// FIFO post-transform cache size that optimizeClusterOrder targets
+static constexpr int32_t VERTEX_CACHE_SIZE = 16;
+
+template<typename Config>
+void optimizeClusterOrder(ClusterGeometry& geometry) {
+    constexpr uint32_t CLUSTER_SIZE = Config::CLUSTER_SIZE, MAX_VERTICES = Config::MAX_VERTICES;
+    uint32_t numTris = geometry.numTris();
+    uint32_t numVertices = (uint32_t)geometry.vertices.size();
+    if (numTris == 0 || numTris > CLUSTER_SIZE || numVertices > MAX_VERTICES) return;
+    const uint32_t* indices = geometry.indices.data();
+
+    // Triangles around each vertex: adjacentTris[adjacencyStart[v] ..+ liveTris[v])
+    uint32_t liveTris[MAX_VERTICES] = {};
+    uint32_t adjacencyStart[MAX_VERTICES + 1];
+    uint32_t adjacentTris[CLUSTER_SIZE * 3];
+    for (uint32_t i = 0; i < numTris * 3; i++) liveTris[indices[i]]++;
+    adjacencyStart[0] = 0;
+    for (uint32_t v = 0; v < numVertices; v++) adjacencyStart[v + 1] = adjacencyStart[v] + liveTris[v];
+    uint32_t fill[MAX_VERTICES];
+    std::copy(adjacencyStart, adjacencyStart + numVertices, fill);
+    for (uint32_t i = 0; i < numTris * 3; i++) adjacentTris[fill[indices[i]]++] = i / 3;
+
+    // Tipsify (Sander et al. 2007): emit every remaining triangle around a
+    // fanning vertex, then fan next around the vertex just emitted that
+    // stays cached longest while it still has triangles, falling back to
+    // recently emitted vertices (dead-end stack), then to input order
+    int32_t cacheTime[MAX_VERTICES] = {};
+    int32_t timestamp = VERTEX_CACHE_SIZE + 1;
+    bool emitted[CLUSTER_SIZE] = {};
+    uint32_t order[CLUSTER_SIZE], numOrdered = 0;
+    uint32_t deadEnd[CLUSTER_SIZE * 3], deadEndSize = 0;
+    uint32_t candidates[CLUSTER_SIZE * 3];
+    uint32_t cursor = 0;
+    for (int64_t fanning = 0; fanning >= 0; ) {
+        uint32_t numCandidates = 0;
+        for (uint32_t a = adjacencyStart[fanning]; a < adjacencyStart[fanning + 1]; a++) {
+            uint32_t t = adjacentTris[a];
+            if (emitted[t]) continue;
+            emitted[t] = true;
+            order[numOrdered++] = t;
+            for (int c = 0; c < 3; c++) {
+                uint32_t v = indices[t * 3 + c];
+                deadEnd[deadEndSize++] = v;
+                candidates[numCandidates++] = v;
+                liveTris[v]--;
+                if (timestamp - cacheTime[v] > VERTEX_CACHE_SIZE) cacheTime[v] = timestamp++;
+            }
+        }
 
-    std::unordered_map<EdgeKey, uint32_t, EdgeHash> edgeCount;
-    for (uint32_t t = 0; t < numTris; t++) {
-        for (int e = 0; e < 3; e++) {
-            uint32_t i0 = indices[t * 3 + e];
-            uint32_t i1 = indices[t * 3 + ((e + 1) % 3)];
-            edgeCount[makeEdgeKey(i0, i1)]++;
+        fanning = -1;
+        int32_t bestPriority = -1;
+        for (uint32_t i = 0; i < numCandidates; i++) {
+            uint32_t v = candidates[i];
+            if (liveTris[v] == 0) continue;
+            int32_t age = timestamp - cacheTime[v];
+            int32_t priority = age + 2 * (int32_t)liveTris[v] <= VERTEX_CACHE_SIZE ? age : 0;
+            if (priority > bestPriority) { bestPriority = priority; fanning = v; }
+        }
+        while (fanning < 0 && deadEndSize > 0) {
+            uint32_t v = deadEnd[--deadEndSize];
+            if (liveTris[v] > 0) fanning = v;
+        }
+        while (fanning < 0 && cursor < numVertices) {
+            if (liveTris[cursor] > 0) fanning = cursor;
+            cursor++;
         }
     }
 
-    for (uint32_t t = 0; t < numTris; t++) {
-        for (int e = 0; e < 3; e++) {
-            uint32_t i0 = indices[t * 3 + e];
-            uint32_t i1 = indices[t * 3 + ((e + 1) % 3)];
-            EdgeKey key = makeEdgeKey(i0, i1);
-            auto it = edgeCount.find(key);
-            // Boundary: edge has only one adjacent triangle
-            boundaryEdges[t * 3 + e] = (it == edgeCount.end() || it->second < 2);
+    // Renumber vertices in first-use order (unused ones are dropped); the
+    // boundary edge flags move with their triangles
+    uint32_t remap[MAX_VERTICES];
+    std::fill(remap, remap + numVertices, INVALID_INDEX);
+    Vertex vertices[MAX_VERTICES];
+    uint32_t reordered[CLUSTER_SIZE * 3];
+    uint32_t numUsed = 0;
+    bool hasBoundaryEdges = geometry.boundaryEdges.size() == numTris * 3;
+    BitSet boundaryEdges(hasBoundaryEdges ? numTris * 3 : 0);
+    for (uint32_t i = 0; i < numTris; i++) {
+        uint32_t t = order[i];
+        for (int c = 0; c < 3; c++) {
+            uint32_t v = indices[t * 3 + c];
+            if (remap[v] == INVALID_INDEX) {
+                remap[v] = numUsed;
+                vertices[numUsed++] = geometry.vertices[v];
+            }
+            reordered[i * 3 + c] = remap[v];
+            if (hasBoundaryEdges && geometry.boundaryEdges[t * 3 + c]) boundaryEdges.set(i * 3 + c);
         }
     }
+    geometry.vertices.assign(vertices, vertices + numUsed);
+    geometry.indices.assign(reordered, reordered + numTris * 3);
+    geometry.boundaryEdges = std::move(boundaryEdges);
 }
 
+template void optimizeClusterOrder<ClusterConfig<64>>(ClusterGeometry&);
+template void optimizeClusterOrder<ClusterConfig<128>>(ClusterGeometry&);
+template void optimizeClusterOrder<ClusterConfig<256>>(ClusterGeometry&);
+
 // ---------- Build Leaf Clusters ----------
 
-std::vector<uint32_t> buildLeafClusters(
+// Adjacency edges outweigh locality links, so a cut through the surface
+// costs far more than separating pieces that merely lie close together.
+static constexpr uint32_t ADJACENCY_EDGE_WEIGHT = 16;
+// Leaf clusters per task below which splitting the build does not pay off.
+static constexpr uint32_t MIN_TASK_CLUSTERS = 64;
+
+// Graph over the Morton-sorted triangles (node i = triInfos[i].index): edges
+// between triangles sharing a mesh edge (by vertex index, so the mesh should
+// be welded), and between consecutive triangles in Morton order.
+static void buildTriangleGraph(const RawMesh& mesh, const std::vector<RadixSortItem<uint64_t>>& triInfos,
+                               uint32_t numThreads, PartitionGraph& graph)
+{
+    uint32_t numTris = (uint32_t)triInfos.size();
+    std::vector<RadixSortItem<uint64_t>> edges((size_t)numTris * 3);
+    for (uint32_t i = 0; i < numTris; i++) {
+        const uint32_t* tri = &mesh.indices[(size_t)triInfos[i].index * 3];
+        for (uint32_t e = 0; e < 3; e++) {
+            uint64_t a = tri[e], b = tri[(e + 1) % 3];
+            if (a > b) std::swap(a, b);
+            edges[(size_t)i * 3 + e] = { (a << 32) | b, i };
+        }
+    }
+    radixSort(edges, numThreads);
+
+    auto forEachLink = [&](auto&& link) {
+        for (uint32_t i = 0; i + 1 < numTris; i++) link(i, i + 1, LOCALITY_EDGE_WEIGHT);
+        for (size_t begin = 0, end; begin < edges.size(); begin = end) {
+            for (end = begin + 1; end < edges.size() && edges[end].key == edges[begin].key; end++) {}
+            if (end - begin > MAX_EDGE_FAN) continue;
+            for (size_t x = begin; x < end; x++) {
+                for (size_t y = x + 1; y < end; y++) {
+                    if (edges[x].index != edges[y].index) link(edges[x].index, edges[y].index, ADJACENCY_EDGE_WEIGHT);
+                }
+            }
+        }
+    };
+    buildPartitionGraph(numTris, forEachLink, graph);
+}
+
+template<typename Config>
+static std::vector<uint32_t> buildLeafClustersImpl(
     const RawMesh& mesh,
-    std::vector<Cluster>& outClusters)
+    ClusterGeometryPool& outGeometry,
+    std::vector<Cluster>& outClusters,
+    const LeafClusterOptions& options)
 {
+    constexpr uint32_t CLUSTER_SIZE = Config::CLUSTER_SIZE;
     uint32_t numTris = mesh.numTris();
     if (numTris == 0) return {};
 
-    // Compute triangle centroids and Morton codes
-    struct TriInfo {
-        uint32_t triIndex;
-        uint32_t mortonCode;
+    // Morton codes of triangle centroids, quantized over the centroid bounds
+    auto centroid = [&](uint32_t t) {
+        return (mesh.vertices[mesh.indices[t * 3 + 0]].position +
+                mesh.vertices[mesh.indices[t * 3 + 1]].position +
+                mesh.vertices[mesh.indices[t * 3 + 2]].position) / 3.0f;
     };
-    std::vector<TriInfo> triInfos(numTris);
-    glm::vec3 boundsSize = mesh.bounds.max - mesh.bounds.min;
-    glm::vec3 boundsMin  = mesh.bounds.min;
-    // Avoid division by zero
-    for (int i = 0; i < 3; i++) {
-        if (boundsSize[i] < 1e-8f) boundsSize[i] = 1.0f;
-    }
+    AABB centroidBounds;
+    for (uint32_t t = 0; t < numTris; t++) centroidBounds.expand(centroid(t));
+    MortonFrame frame(centroidBounds, numTris);
+    std::vector<RadixSortItem<uint64_t>> triInfos(numTris);
+    for (uint32_t t = 0; t < numTris; t++) triInfos[t] = { frame.encode(centroid(t)), t };
 
-    for (uint32_t t = 0; t < numTris; t++) {
-        const glm::vec3& p0 = mesh.vertices[mesh.indices[t * 3 + 0]].position;
-        const glm::vec3& p1 = mesh.vertices[mesh.indices[t * 3 + 1]].position;
-        const glm::vec3& p2 = mesh.vertices[mesh.indices[t * 3 + 2]].position;
-        glm::vec3 centroid = (p0 + p1 + p2) / 3.0f;
-        glm::vec3 normalized = (centroid - boundsMin) / boundsSize;
-        triInfos[t] = { t, mortonEncode(normalized) };
+    // Sort by Morton code for spatial locality
+    radixSort(triInfos, options.numThreads);
+
+    // Cluster c holds triangles triInfos[clusterTris[partStarts[c] .. partStarts[c + 1])].index
+    std::vector<uint32_t> clusterTris, partStarts;
+    if (options.mode == LeafClustering::GraphPartition) {
+        PartitionGraph graph;
+        buildTriangleGraph(mesh, triInfos, options.numThreads, graph);
+        GraphPartitionOptions partitionOptions;
+        partitionOptions.minPartSize = Config::MIN_CLUSTER_SIZE;
+        partitionOptions.maxPartSize = CLUSTER_SIZE;
+        partitionOptions.numThreads = options.numThreads;
+        partitionGraph(graph, partitionOptions, clusterTris, partStarts);
+    } else {
+        // Cut into clusters of CLUSTER_SIZE
+        clusterTris.resize(numTris);
+        std::iota(clusterTris.begin(), clusterTris.end(), 0u);
+        for (uint32_t start = 0; start < numTris; start += CLUSTER_SIZE) partStarts.push_back(start);
+        partStarts.push_back(numTris);
     }
 
-    // Sort by Morton code for spatial locality
-    std::sort(triInfos.begin(), triInfos.end(),
-        [](const TriInfo& a, const TriInfo& b) { return a.mortonCode < b.mortonCode; });
+    // Clusters are built in two parallel passes over contiguous runs of
+    // parts. The first cuts the parts into clusters (a part with too many
+    // vertices becomes several); the second gathers each cluster again and
+    // builds it into its own slot of outClusters and outGeometry, so the
+    // result does not depend on the thread count.
+    uint32_t numParts = (uint32_t)partStarts.size() - 1;
+    uint32_t numThreads = options.numThreads ? options.numThreads : getNumWorkerThreads();
+    uint32_t numTasks = std::min(numThreads, std::max(1u, numParts / MIN_TASK_CLUSTERS));
+    auto sourceTri = [&](uint32_t i) { return triInfos[clusterTris[i]].index; };
+    struct LeafRun {
+        uint32_t begin, end;            // sourceTri(begin .. end)
+        uint32_t numVertices;
+    };
+    std::vector<std::vector<LeafRun>> taskRuns(numTasks);
+    parallelFor(numTasks, [&](uint32_t task) {
+        ClusterGeometry geometry;
+        geometry.vertices.reserve(Config::MAX_VERTICES);
+        geometry.indices.reserve(CLUSTER_SIZE * 3);
+        HashedLocalIndexMap globalToLocal;
+        uint32_t partBegin = (uint32_t)((uint64_t)numParts * task / numTasks);
+        uint32_t partEnd = (uint32_t)((uint64_t)numParts * (task + 1) / numTasks);
+        for (uint32_t part = partBegin; part < partEnd; part++) {
+            for (uint32_t i = partStarts[part]; i < partStarts[part + 1]; ) {
+                uint32_t end = gatherTriangles<Config>(mesh.vertices.data(), mesh.indices.data(), i, partStarts[part + 1],
+                                               sourceTri, globalToLocal, geometry);
+                taskRuns[task].push_back({ i, end, (uint32_t)geometry.vertices.size() });
+                i = end;
+            }
+        }
+    });
 
-    // Cut into clusters of CLUSTER_SIZE
+    // Slots: cluster r of task t follows those of tasks 0 .. t - 1
+    uint32_t firstCluster = (uint32_t)outClusters.size();
+    std::vector<uint32_t> taskFirstCluster(numTasks + 1, firstCluster);
+    size_t numVertices = outGeometry.vertices.size(), numIndices = outGeometry.indices.size();
     std::vector<uint32_t> newClusterIndices;
-    uint32_t baseCluster = (uint32_t)outClusters.size();
-
-    for (uint32_t start = 0; start < numTris; start += CLUSTER_SIZE) {
-        uint32_t end = std::min(start + CLUSTER_SIZE, numTris);
-        uint32_t clusterTriCount = end - start;
-
-        Cluster cluster;
-
-        // Gather unique vertices for this cluster
-        std::unordered_map<uint32_t, uint32_t> globalToLocal;
-        for (uint32_t i = start; i < end; i++) {
-            uint32_t origTri = triInfos[i].triIndex;
-            for (int v = 0; v < 3; v++) {
-                uint32_t globalIdx = mesh.indices[origTri * 3 + v];
-                if (globalToLocal.find(globalIdx) == globalToLocal.end()) {
-                    uint32_t localIdx = (uint32_t)cluster.vertices.size();
-                    cluster.vertices.push_back(mesh.vertices[globalIdx]);
-                    globalToLocal[globalIdx] = localIdx;
+    for (uint32_t task = 0; task < numTasks; task++) {
+        taskFirstCluster[task + 1] = taskFirstCluster[task] + (uint32_t)taskRuns[task].size();
+        for (const LeafRun& run : taskRuns[task]) {
+            Cluster cluster;
+            cluster.vertexOffset = (uint32_t)numVertices;
+            cluster.indexOffset = (uint32_t)numIndices;
+            numVertices += run.numVertices;
+            numIndices += (size_t)(run.end - run.begin) * 3;
+            newClusterIndices.push_back((uint32_t)outClusters.size());
+            outClusters.push_back(cluster);
+        }
+    }
+    outGeometry.vertices.resize(numVertices);
+    outGeometry.indices.resize(numIndices);
+    outGeometry.boundaryEdges.resize(numIndices);
+
+    // Boundary flags of neighbouring clusters can share a BitSet word, so
+    // each task lists its flagged edges and they are set afterwards
+    std::vector<std::vector<uint32_t>> taskBoundaryEdges(numTasks);
+    parallelFor(numTasks, [&](uint32_t task) {
+        ClusterGeometry geometry;
+        geometry.vertices.reserve(Config::MAX_VERTICES);
+        geometry.indices.reserve(CLUSTER_SIZE * 3);
+        HashedLocalIndexMap globalToLocal;
+        for (uint32_t r = 0; r < (uint32_t)taskRuns[task].size(); r++) {
+            const LeafRun& run = taskRuns[task][r];
+            gatherTriangles<Config>(mesh.vertices.data(), mesh.indices.data(), run.begin, run.end,
+                                    sourceTri, globalToLocal, geometry);
+            optimizeClusterOrder<Config>(geometry);
+
+            Cluster& cluster = outClusters[taskFirstCluster[task] + r];
+            cluster.mipLevel = 0;
+            cluster.lodError = 0.0f;
+            cluster.computeBoundsAndMetrics(geometry);
+            cluster.numVertices = (uint32_t)geometry.vertices.size();
+            std::copy(geometry.vertices.begin(), geometry.vertices.end(), outGeometry.vertices.begin() + cluster.vertexOffset);
+            std::copy(geometry.indices.begin(), geometry.indices.end(), outGeometry.indices.begin() + cluster.indexOffset);
+            if (options.computeBoundaryEdges) {
+                geometry.computeBoundaryEdges();
+                for (uint32_t e = 0; e < cluster.numTris * 3; e++) {
+                    if (geometry.boundaryEdges[e]) taskBoundaryEdges[task].push_back(cluster.indexOffset + e);
                 }
-                cluster.indices.push_back(globalToLocal[globalIdx]);
             }
+            cluster.edgeLength = -cluster.edgeLength; // negative = leaf marker
         }
-
-        cluster.mipLevel = 0;
-        cluster.lodError = 0.0f;
-        cluster.computeBoundsAndMetrics();
-        cluster.computeBoundaryEdges();
-        cluster.edgeLength = -cluster.edgeLength; // negative = leaf marker
-
-        uint32_t clusterIdx = (uint32_t)outClusters.size();
-        outClusters.push_back(std::move(cluster));
-        newClusterIndices.push_back(clusterIdx);
+    });
+    for (const std::vector<uint32_t>& edges : taskBoundaryEdges) {
+        for (uint32_t e : edges) outGeometry.boundaryEdges.set(e);
     }
 
     return newClusterIndices;
 }
 
+std::vector<uint32_t> buildLeafClusters(
+    const RawMesh& mesh,
+    ClusterGeometryPool& outGeometry,
+    std::vector<Cluster>& outClusters,
+    const LeafClusterOptions& options)
+{
+    return withClusterConfig(options.size, [&](auto config) {
+        return buildLeafClustersImpl<decltype(config)>(mesh, outGeometry, outClusters, options);
+    });
+}
+
 // ---------- Merge Clusters ----------
 
-Cluster mergeClusters(
+ClusterGeometry mergeClusters(
+    const ClusterGeometryPool& geometry,
     const std::vector<Cluster>& allClusters,
     const std::vector<uint32_t>& clusterIndices)
 {
-    Cluster merged;
+    ClusterGeometry merged;
+    uint32_t numVertices = 0, numIndices = 0;
+    for (uint32_t ci : clusterIndices) {
+        numVertices += allClusters[ci].numVertices;
+        numIndices += allClusters[ci].numTris * 3;
+    }
+    merged.vertices.reserve(numVertices);
+    merged.indices.reserve(numIndices);
 
-    // Vertex welding: merge by quantized position
+    // Vertex welding: merge by quantized position. The 96-bit cell is hashed
+    // to a 64-bit table key; a hit is confirmed against the cell of the
+    // vertex found, and a collision moves on to a rehashed key.
     struct PosKey {
         int32_t x, y, z;
         bool operator==(const PosKey& o) const { return x == o.x && y == o.y && z == o.z; }
     };
-    struct PosKeyHash {
-        size_t operator()(const PosKey& k) const {
-            return std::hash<int32_t>()(k.x) ^ (std::hash<int32_t>()(k.y) << 10) ^ (std::hash<int32_t>()(k.z) << 20);
-        }
-    };
-    std::unordered_map<PosKey, uint32_t, PosKeyHash> weldMap;
-
     auto toPosKey = [](const glm::vec3& p) -> PosKey {
         return { (int32_t)(p.x * 100000.0f), (int32_t)(p.y * 100000.0f), (int32_t)(p.z * 100000.0f) };
     };
+    auto tableKey = [](const PosKey& k) {
+        uint64_t h = FlatHashMap64::hash(((uint64_t)(uint32_t)k.x << 32) | (uint32_t)k.y);
+        h = FlatHashMap64::hash(h ^ (uint32_t)k.z);
+        return h == FlatHashMap64::EMPTY_KEY ? 0 : h;
+    };
+    FlatHashMap64 weldMap(numVertices);
 
+    std::vector<uint32_t> remap(MAX_CLUSTER_VERTICES);
     for (uint32_t ci : clusterIndices) {
         const Cluster& src = allClusters[ci];
-        std::vector<uint32_t> remap(src.vertices.size());
-
-        for (uint32_t v = 0; v < (uint32_t)src.vertices.size(); v++) {
-            PosKey key = toPosKey(src.vertices[v].position);
-            auto it = weldMap.find(key);
-            if (it != weldMap.end()) {
-                remap[v] = it->second;
-                // Average normals for welded vertices
-                merged.vertices[it->second].normal += src.vertices[v].normal;
-            } else {
-                uint32_t newIdx = (uint32_t)merged.vertices.size();
-                merged.vertices.push_back(src.vertices[v]);
-                weldMap[key] = newIdx;
-                remap[v] = newIdx;
+        const Vertex* srcVertices = geometry.clusterVertices(src);
+        const uint32_t* srcIndices = geometry.clusterIndices(src);
+        remap.resize(std::max<size_t>(remap.size(), src.numVertices));
+
+        for (uint32_t v = 0; v < src.numVertices; v++) {
+            PosKey cell = toPosKey(srcVertices[v].position);
+            uint32_t newIdx = (uint32_t)merged.vertices.size();
+            for (uint64_t key = tableKey(cell);; key = FlatHashMap64::hash(key) & ~1ull) {
+                bool inserted;
+                uint32_t idx = weldMap.findOrInsert(key, newIdx, inserted);
+                if (inserted) {
+                    merged.vertices.push_back(srcVertices[v]);
+                    remap[v] = newIdx;
+                    break;
+                }
+                if (toPosKey(merged.vertices[idx].position) == cell) {
+                    // Average normals for welded vertices
+                    merged.vertices[idx].normal += srcVertices[v].normal;
+                    remap[v] = idx;
+                    break;
+                }
             }
         }
 
-        for (uint32_t idx : src.indices) {
-            merged.indices.push_back(remap[idx]);
+        for (uint32_t i = 0; i < src.numTris * 3; i++) {
+            merged.indices.push_back(remap[srcIndices[i]]);
         }
     }
 
@@ -238,71 +681,63 @@ Cluster mergeClusters(
         if (len > 1e-8f) v.normal /= len;
     }
 
-    merged.computeBoundsAndMetrics();
-    merged.computeBoundaryEdges();
     return merged;
 }
 
 // ---------- Split Cluster ----------
 
-std::vector<Cluster> splitCluster(const Cluster& merged) {
-    uint32_t numTris = merged.numTris;
-    if (numTris <= CLUSTER_SIZE) {
-        return { merged };
+template<typename Config>
+std::vector<Cluster> splitCluster(const ClusterGeometry& merged, ClusterGeometryPool& outGeometry) {
+    constexpr uint32_t CLUSTER_SIZE = Config::CLUSTER_SIZE;
+    uint32_t numTris = merged.numTris();
+    if (numTris <= CLUSTER_SIZE && merged.vertices.size() <= Config::MAX_VERTICES) {
+        ClusterGeometry geometry;
+        geometry.vertices = merged.vertices;
+        geometry.indices = merged.indices;
+        optimizeClusterOrder<Config>(geometry);
+        Cluster cluster;
+        cluster.computeBoundsAndMetrics(geometry);
+        outGeometry.append(cluster, geometry);
+        return { cluster };
     }
 
     // Sort triangles by Morton code of centroid
-    struct TriInfo {
-        uint32_t triIndex;
-        uint32_t mortonCode;
+    auto centroid = [&](uint32_t t) {
+        return (merged.vertices[merged.indices[t * 3 + 0]].position +
+                merged.vertices[merged.indices[t * 3 + 1]].position +
+                merged.vertices[merged.indices[t * 3 + 2]].position) / 3.0f;
     };
-    std::vector<TriInfo> triInfos(numTris);
-    glm::vec3 bSize = merged.bounds.max - merged.bounds.min;
-    glm::vec3 bMin  = merged.bounds.min;
-    for (int i = 0; i < 3; i++) {
-        if (bSize[i] < 1e-8f) bSize[i] = 1.0f;
-    }
-
-    for (uint32_t t = 0; t < numTris; t++) {
-        const glm::vec3& p0 = merged.vertices[merged.indices[t * 3 + 0]].position;
-        const glm::vec3& p1 = merged.vertices[merged.indices[t * 3 + 1]].position;
-        const glm::vec3& p2 = merged.vertices[merged.indices[t * 3 + 2]].position;
-        glm::vec3 c = (p0 + p1 + p2) / 3.0f;
-        glm::vec3 norm = (c - bMin) / bSize;
-        triInfos[t] = { t, mortonEncode(norm) };
-    }
-    std::sort(triInfos.begin(), triInfos.end(),
-        [](const TriInfo& a, const TriInfo& b) { return a.mortonCode < b.mortonCode; });
-
+    AABB centroidBounds;
+    for (uint32_t t = 0; t < numTris; t++) centroidBounds.expand(centroid(t));
+    MortonFrame frame(centroidBounds, numTris);
+    std::vector<RadixSortItem<uint64_t>> triInfos(numTris);
+    for (uint32_t t = 0; t < numTris; t++) triInfos[t] = { frame.encode(centroid(t)), t };
+    radixSort(triInfos);
+
+    // Runs of CLUSTER_SIZE triangles, cut short at MAX_VERTICES
     std::vector<Cluster> result;
-    for (uint32_t start = 0; start < numTris; start += CLUSTER_SIZE) {
-        uint32_t end = std::min(start + CLUSTER_SIZE, numTris);
-
+    result.reserve((numTris + CLUSTER_SIZE - 1) / CLUSTER_SIZE);
+    ClusterGeometry geometry;
+    geometry.vertices.reserve(Config::MAX_VERTICES);
+    geometry.indices.reserve(CLUSTER_SIZE * 3);
+    LocalIndexMap remap(merged.vertices.size());
+    auto sourceTri = [&](uint32_t i) { return triInfos[i].index; };
+    for (uint32_t start = 0; start < numTris; ) {
         Cluster cluster;
-        std::unordered_map<uint32_t, uint32_t> remap;
-
-        for (uint32_t i = start; i < end; i++) {
-            uint32_t origTri = triInfos[i].triIndex;
-            for (int v = 0; v < 3; v++) {
-                uint32_t srcIdx = merged.indices[origTri * 3 + v];
-                auto it = remap.find(srcIdx);
-                if (it != remap.end()) {
-                    cluster.indices.push_back(it->second);
-                } else {
-                    uint32_t localIdx = (uint32_t)cluster.vertices.size();
-                    cluster.vertices.push_back(merged.vertices[srcIdx]);
-                    remap[srcIdx] = localIdx;
-                    cluster.indices.push_back(localIdx);
-                }
-            }
-        }
+        start = gatherTriangles<Config>(merged.vertices.data(), merged.indices.data(), start,
+                                        std::min(start + CLUSTER_SIZE, numTris), sourceTri, remap, geometry);
+        optimizeClusterOrder<Config>(geometry);
 
-        cluster.computeBoundsAndMetrics();
-        cluster.computeBoundaryEdges();
-        result.push_back(std::move(cluster));
+        cluster.computeBoundsAndMetrics(geometry);
+        outGeometry.append(cluster, geometry);
+        result.push_back(cluster);
     }
 
     return result;
 }
 
+template std::vector<Cluster> splitCluster<ClusterConfig<64>>(const ClusterGeometry&, ClusterGeometryPool&);
+template std::vector<Cluster> splitCluster<ClusterConfig<128>>(const ClusterGeometry&, ClusterGeometryPool&);
+template std::vector<Cluster> splitCluster<ClusterConfig<256>>(const ClusterGeometry&, ClusterGeometryPool&);
+
 } // namespace nanite
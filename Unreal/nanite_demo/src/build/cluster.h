@@ -2,19 +2,39 @@
 
 #include "../core/types.h"
 #include "../core/mesh_loader.h"
+#include "../core/bitset.h"
 
 namespace nanite {
 
-struct Cluster {
-    // --- Geometry ---
+// Geometry of one cluster while it is being built (gathered, merged,
+// simplified or split), before it is appended to a ClusterGeometryPool.
+struct ClusterGeometry {
     std::vector<Vertex>   vertices;
-    std::vector<uint32_t> indices;     // local indices into vertices[]
-    uint32_t              numTris = 0;
+    std::vector<uint32_t> indices;       // local indices into vertices[]
+
+    // --- Boundary edges (for simplification locking) ---
+    // Per-edge flag: true = boundary edge (shared with another cluster or open)
+    BitSet                boundaryEdges; // size = indices.size(), or empty
+
+    uint32_t numTris() const { return (uint32_t)(indices.size() / 3); }
+
+    // Identify boundary edges (edges with only one adjacent triangle). Edges
+    // are matched by vertex index, so coincident vertices must be welded.
+    void computeBoundaryEdges();
+};
+
+struct Cluster {
+    // --- Geometry (in a ClusterGeometryPool) ---
+    uint32_t vertexOffset = 0;
+    uint32_t numVertices  = 0;
+    uint32_t indexOffset  = 0;      // also the first boundary edge flag
+    uint32_t numTris      = 0;
 
     // --- Bounds ---
     AABB           bounds;
     BoundingSphere sphereBounds;
     BoundingSphere lodBounds;       // used for projected LOD error test
+    NormalCone     normalCone;      // for cluster backface culling
 
     // --- LOD metadata ---
     float    lodError    = 0.0f;    // max geometric error from simplification
@@ -26,36 +46,120 @@ struct Cluster {
     uint32_t groupIndex           = INVALID_INDEX; // parent group
     uint32_t generatingGroupIndex = INVALID_INDEX; // group that generated this cluster
 
-    // --- Boundary edges (for simplification locking) ---
-    // Per-edge flag: true = boundary edge (shared with another cluster or open)
-    std::vector<bool> boundaryEdges; // size = numTris * 3
+    // Recompute numTris, bounds, sphereBounds, normalCone, surfaceArea,
+    // edgeLength from geometry
+    void computeBoundsAndMetrics(const ClusterGeometry& geometry);
+};
 
-    // Recompute bounds, sphereBounds, surfaceArea, edgeLength from geometry
-    void computeBoundsAndMetrics();
+// Geometry of many clusters in three contiguous arrays, so a DAG holds three
+// allocations instead of three per cluster and the rasterizer reads one
+// linear buffer. Cluster c owns vertices[c.vertexOffset ..+ c.numVertices)
+// and indices and boundary edge flags [c.indexOffset ..+ c.numTris * 3);
+// its indices are local (relative to its first vertex).
+struct ClusterGeometryPool {
+    std::vector<Vertex>   vertices;
+    std::vector<uint32_t> indices;
+    BitSet                boundaryEdges;
 
-    // Identify boundary edges (edges with only one adjacent triangle)
-    void computeBoundaryEdges();
+    const Vertex*   clusterVertices(const Cluster& c) const { return vertices.data() + c.vertexOffset; }
+    const uint32_t* clusterIndices(const Cluster& c) const { return indices.data() + c.indexOffset; }
+    bool isBoundaryEdge(const Cluster& c, uint32_t edge) const { return boundaryEdges[c.indexOffset + edge]; }
+
+    // Copy `geometry` to the end of the pool and point `c` at it.
+    void append(Cluster& c, const ClusterGeometry& geometry);
+    // Copy the geometry of `c` from `source` to the end of this pool and
+    // point `c` at the copy.
+    void append(Cluster& c, const ClusterGeometryPool& source);
+
+    void reserve(size_t numVertices, size_t numIndices);
+    void clear();
+    size_t memoryBytes() const;
 };
 
-// Morton code for 3D spatial sorting
+// Morton code for 3D spatial sorting (10 bits per axis; coarse grids only)
 uint32_t mortonEncode(const glm::vec3& normalizedPos);
 
-// Build leaf clusters from a raw mesh using Morton-code spatial sorting.
+// Morton code with up to 21 bits per axis (63 bits; BMI2 pdep when
+// compiled for it). Coordinates are quantized to bitsPerAxis bits.
+uint64_t mortonEncode64(const glm::vec3& normalizedPos, uint32_t bitsPerAxis = 21);
+
+// Quantization for Morton-sorting one set of points, adapted to the set:
+// the grid is fitted to the bounds of the points themselves (not the mesh),
+// with cubic cells so flat or elongated sets keep compact runs, and with
+// enough bits per axis that points on a surface rarely share a cell
+// (cells across a surface ~ 2^(2*bits) >> numPoints). Fewer bits on small
+// sets mean shorter keys and fewer radix passes.
+struct MortonFrame {
+    glm::vec3 origin = glm::vec3(0.0f);
+    float     scale  = 1.0f;
+    uint32_t  bitsPerAxis = 21;
+
+    MortonFrame(const AABB& pointBounds, uint32_t numPoints);
+    uint64_t encode(const glm::vec3& p) const { return mortonEncode64((p - origin) * scale, bitsPerAxis); }
+};
+
+enum class LeafClustering {
+    // Morton-sorted runs of CLUSTER_SIZE triangles (see ClusterConfig): fast, but clusters ignore
+    // connectivity and often have long ragged (or disconnected) borders.
+    MortonRuns,
+    // Partition the triangle adjacency graph (shared edges, plus weak links
+    // between Morton-order neighbours so disconnected pieces still group by
+    // proximity) into MIN_CLUSTER_SIZE..CLUSTER_SIZE triangle parts with few
+    // cut edges. Fewer boundary edges get locked during simplification.
+    GraphPartition,
+};
+
+struct LeafClusterOptions {
+    LeafClustering mode = LeafClustering::MortonRuns;
+    // ClusterConfig of the asset; ClusterDAG::build keeps it for every level
+    ClusterSize    size = ClusterSize::Tris128;
+    // Threads: 0 = all worker threads. The result is identical for every count.
+    uint32_t       numThreads = 0;
+    // Flag each cluster's own boundary edges (ClusterGeometry::
+    // computeBoundaryEdges). ClusterDAG::build turns this off: it sets them
+    // from the level adjacency instead.
+    bool           computeBoundaryEdges = true;
+};
+
+// Build leaf clusters from a raw mesh (see LeafClustering), with their
+// geometry appended to outGeometry (boundary edge flags cleared unless
+// options.computeBoundaryEdges). Clusters are in spatial order and have
+// at most MAX_VERTICES vertices of their ClusterConfig (options.size; a
+// part with more is cut); their triangles are in optimizeClusterOrder order.
 // Returns indices of newly created clusters in outClusters.
 std::vector<uint32_t> buildLeafClusters(
     const RawMesh& mesh,
-    std::vector<Cluster>& outClusters
+    ClusterGeometryPool& outGeometry,
+    std::vector<Cluster>& outClusters,
+    const LeafClusterOptions& options = {}
 );
 
 // Merge multiple clusters into one combined cluster (geometry union).
-// Does NOT simplify - just concatenates and welds vertices.
-Cluster mergeClusters(
+// Does NOT simplify - just concatenates and welds vertices. Triangles keep
+// their order, so edge slots are the children's, concatenated. Boundary
+// edges are left empty: which edges to lock depends on the whole level (see
+// LevelAdjacency).
+ClusterGeometry mergeClusters(
+    const ClusterGeometryPool& geometry,
     const std::vector<Cluster>& allClusters,
     const std::vector<uint32_t>& clusterIndices
 );
 
-// Split a single cluster into multiple clusters of at most CLUSTER_SIZE triangles.
-// Uses Morton-code spatial partitioning.
-std::vector<Cluster> splitCluster(const Cluster& merged);
+// Reorder the triangles of a finished cluster for vertex reuse (Tipsify,
+// for a 16-entry FIFO cache), so consecutive triangles mostly share
+// vertices, then renumber its vertices in first-use order. Boundary edge
+// flags move with their triangles; unused vertices are dropped. Clusters
+// over Config::CLUSTER_SIZE triangles or Config::MAX_VERTICES vertices are
+// left as they are. Implemented for the ClusterSize configurations.
+template<typename Config = DefaultClusterConfig>
+void optimizeClusterOrder(ClusterGeometry& geometry);
+
+// Split a merged cluster into multiple clusters of at most
+// Config::CLUSTER_SIZE triangles and Config::MAX_VERTICES vertices, with
+// their geometry appended to outGeometry (in optimizeClusterOrder order).
+// Uses Morton-code spatial partitioning. Boundary edges are left unset.
+// Implemented for the ClusterSize configurations.
+template<typename Config = DefaultClusterConfig>
+std::vector<Cluster> splitCluster(const ClusterGeometry& merged, ClusterGeometryPool& outGeometry);
 
 } // namespace nanite
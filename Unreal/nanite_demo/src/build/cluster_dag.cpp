@@ -1,17 +1,46 @@
 #include "cluster_dag.h"
 #include "simplify.h"
+#include "graph_partition.h"
+#include "../core/radix_sort.h"
 #include <algorithm>
+#include <numeric>
 #include <cstdio>
 
 namespace nanite {
 
-void ClusterDAG::build(const RawMesh& mesh) {
+// Groups are partitioned for an eighth fewer than MAX_GROUP_SIZE clusters on
+// average, leaving room to move their borders to cheaper cuts.
+static constexpr uint32_t GROUP_PARTITION_SLACK_DIVISOR = 8;
+
+bool ClusterDAG::build(const RawMesh& mesh, const BuildLevelCallback& onLevel, const LeafClusterOptions& leafOptions) {
+    return withClusterConfig(leafOptions.size, [&](auto config) {
+        return buildLevels<decltype(config)>(mesh, onLevel, leafOptions);
+    });
+}
+
+template<typename Config>
+bool ClusterDAG::buildLevels(const RawMesh& mesh, const BuildLevelCallback& onLevel, const LeafClusterOptions& leafOptions) {
     totalBounds = mesh.bounds;
 
+    // Each level has about half the triangles of the one below, but levels
+    // that stop reducing early add more, and border vertices repeat in every
+    // cluster: DAGs measure ~2.2x the mesh indices and ~3.4x its vertices.
+    // Reserve above that, since untouched capacity costs no memory while
+    // outgrowing it copies the whole pool.
+    geometry.reserve(mesh.vertices.size() * 4, (size_t)mesh.numTris() * 3 * 3);
+    clusters.reserve((mesh.numTris() / Config::CLUSTER_SIZE + 1) * 2);
+
+    // Boundary edges of every level come from its adjacency (assignBoundaryEdges)
     printf("Building leaf clusters...\n");
-    std::vector<uint32_t> currentLevel = buildLeafClusters(mesh, clusters);
+    LeafClusterOptions options = leafOptions;
+    options.computeBoundaryEdges = false;
+    std::vector<uint32_t> currentLevel = buildLeafClusters(mesh, geometry, clusters, options);
     printf("  Level 0: %zu leaf clusters (%zu triangles)\n",
            currentLevel.size(), mesh.indices.size() / 3);
+    LevelAdjacency adjacency;
+    buildLevelAdjacency(geometry, clusters, currentLevel, adjacency);
+    assignBoundaryEdges(currentLevel, adjacency);
+    if (onLevel && !onLevel(*this, currentLevel)) return false;
 
     int32_t mipLevel = 0;
 
@@ -20,20 +49,45 @@ void ClusterDAG::build(const RawMesh& mesh) {
         mipLevel++;
 
         // Step 1: Group clusters at current level
-        std::vector<uint32_t> newGroupIndices = groupClusters(currentLevel);
+        std::vector<uint32_t> newGroupIndices = groupClusters<Config>(currentLevel, adjacency);
         printf("  Level %d: %zu groups from %zu clusters",
                mipLevel, newGroupIndices.size(), currentLevel.size());
 
-        // Step 2: Reduce each group to produce parent clusters
+        // Step 2: Reduce each group to produce parent clusters, locking the
+        // edges it does not share with another of its own clusters
+        std::vector<uint32_t> clusterGroup(currentLevel.size());
+        std::vector<uint32_t> levelPosition(clusters.size());
+        for (uint32_t i = 0; i < (uint32_t)currentLevel.size(); i++) {
+            clusterGroup[i] = clusters[currentLevel[i]].groupIndex;
+            levelPosition[currentLevel[i]] = i;
+        }
+        BitSet levelSeams;
+        findUnsharedEdges(adjacency, clusterGroup, levelSeams);
+
         std::vector<uint32_t> nextLevel;
         for (uint32_t gi : newGroupIndices) {
-            std::vector<uint32_t> parentClusters = reduceGroup(gi);
+            uint32_t numEdges = 0;
+            for (uint32_t ci : groups[gi].children) numEdges += clusters[ci].numTris * 3;
+            BitSet seamEdges(numEdges);
+            uint32_t edge = 0;
+            for (uint32_t ci : groups[gi].children) {
+                uint32_t p = levelPosition[ci];
+                for (uint32_t e = adjacency.edgeStarts[p]; e < adjacency.edgeStarts[p + 1]; e++) {
+                    seamEdges.set(edge++, levelSeams[e]);
+                }
+            }
+            std::vector<uint32_t> parentClusters = reduceGroup<Config>(gi, std::move(seamEdges));
             for (uint32_t pc : parentClusters) {
                 nextLevel.push_back(pc);
             }
         }
+        if (!nextLevel.empty()) {
+            buildLevelAdjacency(geometry, clusters, nextLevel, adjacency);
+            assignBoundaryEdges(nextLevel, adjacency);
+        }
 
         printf(" -> %zu parent clusters\n", nextLevel.size());
+        if (onLevel && !nextLevel.empty() && !onLevel(*this, nextLevel)) return false;
 
         if (nextLevel.empty()) {
             // Cannot reduce further, force remaining as roots
@@ -59,6 +113,17 @@ void ClusterDAG::build(const RawMesh& mesh) {
             break;
         }
 
+        // A level that did not shrink cannot make progress: its clusters are
+        // made of locked boundary edges (e.g. a triangle soup), and regrouping
+        // them yields the same clusters again, forever. Stop with this level
+        // as the roots.
+        if (nextLevel.size() >= currentLevel.size()) {
+            for (uint32_t gi : newGroupIndices) {
+                groups[gi].isRoot = true;
+            }
+            break;
+        }
+
         currentLevel = nextLevel;
     }
 
@@ -86,10 +151,27 @@ void ClusterDAG::build(const RawMesh& mesh) {
         }
         printf("  Level %zu: %u clusters, %u triangles\n", i, perLevel[i], tris);
     }
+    return true;
 }
 
+void ClusterDAG::assignBoundaryEdges(const std::vector<uint32_t>& levelClusterIndices,
+                                     const LevelAdjacency& adjacency)
+{
+    std::vector<uint32_t> clusterOwner(levelClusterIndices.size());
+    std::iota(clusterOwner.begin(), clusterOwner.end(), 0u);
+    BitSet boundaryEdges;
+    findUnsharedEdges(adjacency, clusterOwner, boundaryEdges);
+    for (uint32_t i = 0; i < (uint32_t)levelClusterIndices.size(); i++) {
+        const Cluster& c = clusters[levelClusterIndices[i]];
+        uint32_t first = adjacency.edgeStarts[i];
+        for (uint32_t e = 0; e < c.numTris * 3; e++) geometry.boundaryEdges.set(c.indexOffset + e, boundaryEdges[first + e]);
+    }
+}
+
+template<typename Config>
 std::vector<uint32_t> ClusterDAG::groupClusters(
-    const std::vector<uint32_t>& levelClusterIndices)
+    const std::vector<uint32_t>& levelClusterIndices,
+    const LevelAdjacency& adjacency)
 {
     std::vector<uint32_t> newGroupIndices;
     uint32_t count = (uint32_t)levelClusterIndices.size();
@@ -97,7 +179,7 @@ std::vector<uint32_t> ClusterDAG::groupClusters(
     if (count == 0) return newGroupIndices;
 
     // If few enough clusters, put them all in one group
-    if (count <= MAX_GROUP_SIZE) {
+    if (count <= Config::MAX_GROUP_SIZE) {
         uint32_t gi = (uint32_t)groups.size();
         ClusterGroup group;
         group.children = levelClusterIndices;
@@ -124,50 +206,35 @@ std::vector<uint32_t> ClusterDAG::groupClusters(
     }
 
     // Sort clusters by Morton code of their centroid
-    struct ClusterSort {
-        uint32_t clusterIndex;
-        uint32_t mortonCode;
-    };
-    std::vector<ClusterSort> sorted(count);
-
-    glm::vec3 bSize = totalBounds.max - totalBounds.min;
-    glm::vec3 bMin  = totalBounds.min;
-    for (int i = 0; i < 3; i++) {
-        if (bSize[i] < 1e-8f) bSize[i] = 1.0f;
-    }
-
+    AABB centerBounds;
+    for (uint32_t ci : levelClusterIndices) centerBounds.expand(clusters[ci].bounds.center());
+    MortonFrame frame(centerBounds, count);
+    std::vector<RadixSortItem<uint64_t>> sorted(count);
     for (uint32_t i = 0; i < count; i++) {
-        uint32_t ci = levelClusterIndices[i];
-        glm::vec3 center = clusters[ci].bounds.center();
-        glm::vec3 norm = (center - bMin) / bSize;
-        sorted[i] = { ci, mortonEncode(norm) };
+        sorted[i] = { frame.encode(clusters[levelClusterIndices[i]].bounds.center()), i };
     }
-    std::sort(sorted.begin(), sorted.end(),
-        [](const ClusterSort& a, const ClusterSort& b) { return a.mortonCode < b.mortonCode; });
-
-    // Cut into groups of MAX_GROUP_SIZE
-    uint32_t targetGroupSize = MAX_GROUP_SIZE;
-    // Adjust target so we don't get tiny groups at the end
-    uint32_t numFullGroups = count / targetGroupSize;
-    if (numFullGroups == 0) numFullGroups = 1;
-    uint32_t adjustedGroupSize = count / numFullGroups;
-    if (adjustedGroupSize < MIN_GROUP_SIZE) adjustedGroupSize = MIN_GROUP_SIZE;
-
-    for (uint32_t start = 0; start < count; ) {
-        uint32_t remaining = count - start;
-        uint32_t groupSize = adjustedGroupSize;
-        // If remaining is small, take them all
-        if (remaining <= MAX_GROUP_SIZE || remaining - groupSize < MIN_GROUP_SIZE) {
-            groupSize = remaining;
-        }
-
+    radixSort(sorted);
+
+    // Partition the clusters into groups that cut few shared edges
+    std::vector<uint32_t> nodeClusters(count);
+    for (uint32_t i = 0; i < count; i++) nodeClusters[i] = sorted[i].index;
+    PartitionGraph graph;
+    buildClusterGraph(adjacency, nodeClusters, graph);
+    GraphPartitionOptions partitionOptions;
+    partitionOptions.minPartSize = Config::MIN_GROUP_SIZE;
+    partitionOptions.maxPartSize = Config::MAX_GROUP_SIZE;
+    partitionOptions.slack = Config::MAX_GROUP_SIZE / GROUP_PARTITION_SLACK_DIVISOR;
+    std::vector<uint32_t> groupNodes, groupStarts;
+    partitionGraph(graph, partitionOptions, groupNodes, groupStarts);
+
+    for (size_t part = 0; part + 1 < groupStarts.size(); part++) {
         uint32_t gi = (uint32_t)groups.size();
         ClusterGroup group;
-        group.mipLevel = clusters[sorted[start].clusterIndex].mipLevel;
+        group.mipLevel = clusters[levelClusterIndices[nodeClusters[groupNodes[groupStarts[part]]]]].mipLevel;
 
         std::vector<BoundingSphere> childSpheres, childLODSpheres;
-        for (uint32_t i = start; i < start + groupSize && i < count; i++) {
-            uint32_t ci = sorted[i].clusterIndex;
+        for (uint32_t i = groupStarts[part]; i < groupStarts[part + 1]; i++) {
+            uint32_t ci = levelClusterIndices[nodeClusters[groupNodes[i]]];
             group.children.push_back(ci);
             childSpheres.push_back(clusters[ci].sphereBounds);
             childLODSpheres.push_back(clusters[ci].lodBounds);
@@ -179,13 +246,13 @@ std::vector<uint32_t> ClusterDAG::groupClusters(
 
         groups.push_back(std::move(group));
         newGroupIndices.push_back(gi);
-        start += groupSize;
     }
 
     return newGroupIndices;
 }
 
-std::vector<uint32_t> ClusterDAG::reduceGroup(uint32_t groupIndex) {
+template<typename Config>
+std::vector<uint32_t> ClusterDAG::reduceGroup(uint32_t groupIndex, BitSet seamEdges) {
     ClusterGroup& group = groups[groupIndex];
     std::vector<uint32_t> result;
 
@@ -199,13 +266,14 @@ std::vector<uint32_t> ClusterDAG::reduceGroup(uint32_t groupIndex) {
 
     if (totalTris == 0) return result;
 
-    // Step 1: Merge all children into one cluster
-    Cluster merged = mergeClusters(clusters, group.children);
+    // Step 1: Merge all children into one cluster, locking the group's seams
+    ClusterGeometry merged = mergeClusters(geometry, clusters, group.children);
+    merged.boundaryEdges = std::move(seamEdges);
 
     // Step 2: Determine target triangle count (roughly half)
     uint32_t targetTris = std::max(1u, totalTris / 2);
     // Ensure we have enough tris to fill at least one cluster
-    targetTris = std::max(targetTris, (uint32_t)MIN_CLUSTER_SIZE);
+    targetTris = std::max(targetTris, Config::MIN_CLUSTER_SIZE);
 
     // Step 3: Simplify
     float simplifyError = simplifyCluster(merged, targetTris, true);
@@ -214,12 +282,14 @@ std::vector<uint32_t> ClusterDAG::reduceGroup(uint32_t groupIndex) {
     group.parentLODError = std::max(group.parentLODError, simplifyError);
     // Ensure non-zero error so traversal always has something to compare
     if (group.parentLODError <= 0.0f) {
-        group.parentLODError = merged.edgeLength * 0.01f;
+        Cluster simplified;
+        simplified.computeBoundsAndMetrics(merged);
+        group.parentLODError = simplified.edgeLength * 0.01f;
         if (group.parentLODError <= 0.0f) group.parentLODError = 1e-6f;
     }
 
     // Step 4: Split simplified mesh back into clusters
-    std::vector<Cluster> parentClusters = splitCluster(merged);
+    std::vector<Cluster> parentClusters = splitCluster<Config>(merged, geometry);
 
     // Step 5: Assign LOD metadata to parent clusters
     int32_t parentMip = group.mipLevel + 1;
@@ -2,6 +2,8 @@
 
 #include "../core/types.h"
 #include "cluster.h"
+#include "level_adjacency.h"
+#include <functional>
 
 namespace nanite {
 
@@ -18,9 +20,17 @@ struct ClusterGroup {
     std::vector<uint32_t> parentClusters;
 };
 
+class ClusterDAG;
+
+// Called by ClusterDAG::build after the leaf level and after each parent level,
+// with the indices of that level's clusters (the coarsest geometry built so
+// far). Returning false stops the build; the DAG is then incomplete.
+using BuildLevelCallback = std::function<bool(const ClusterDAG& dag, const std::vector<uint32_t>& levelClusters)>;
+
 class ClusterDAG {
 public:
     std::vector<Cluster>      clusters;
+    ClusterGeometryPool       geometry;    // vertices and indices of all clusters
     std::vector<ClusterGroup> groups;
     AABB                      totalBounds;
 
@@ -28,7 +38,13 @@ public:
     // 1. Create leaf clusters
     // 2. Iteratively group, merge, simplify, split to build parent levels
     // 3. Until single root
-    void build(const RawMesh& mesh);
+    // The edge adjacency of each level is computed once (LevelAdjacency) and
+    // gives its clusters' boundary edges, the grouping graph and the seams
+    // each group locks.
+    // Cluster and group sizes follow the ClusterConfig of leafOptions.size.
+    // Returns false if `onLevel` stopped the build.
+    bool build(const RawMesh& mesh, const BuildLevelCallback& onLevel = nullptr,
+               const LeafClusterOptions& leafOptions = {});
 
     // Get indices of root groups
     std::vector<uint32_t> getRootGroupIndices() const;
@@ -40,13 +56,26 @@ public:
     int32_t getMaxMipLevel() const;
 
 private:
-    // Group clusters at one level using Morton-code spatial partitioning.
+    // build() for one ClusterConfig
+    template<typename Config>
+    bool buildLevels(const RawMesh& mesh, const BuildLevelCallback& onLevel, const LeafClusterOptions& leafOptions);
+
+    // Set the boundary edges of one level's clusters from its adjacency.
+    void assignBoundaryEdges(const std::vector<uint32_t>& levelClusterIndices, const LevelAdjacency& adjacency);
+
+    // Group clusters at one level by partitioning the graph of shared edges
+    // between them (nodes in Morton order of the cluster centers).
     // Returns indices of newly created groups.
-    std::vector<uint32_t> groupClusters(const std::vector<uint32_t>& levelClusterIndices);
+    template<typename Config>
+    std::vector<uint32_t> groupClusters(const std::vector<uint32_t>& levelClusterIndices,
+                                        const LevelAdjacency& adjacency);
 
     // For one group: merge children, simplify, split into parent clusters.
+    // seamEdges flags the edges of the children (concatenated in child order)
+    // that the group shares with other groups or that are open.
     // Returns indices of newly created parent clusters.
-    std::vector<uint32_t> reduceGroup(uint32_t groupIndex);
+    template<typename Config>
+    std::vector<uint32_t> reduceGroup(uint32_t groupIndex, BitSet seamEdges);
 };
 
 } // namespace nanite
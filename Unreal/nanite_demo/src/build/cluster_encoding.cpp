@@ -0,0 +1,222 @@
+#include "cluster_encoding.h"
+#include "../core/parallel.h"
+#include "../core/flat_hash_map.h"
+#include "../core/radix_sort.h"
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NANITE_DECODE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace nanite {
+
+// ---------- Octahedral Normals ----------
+
+static float unpackOctahedral(uint8_t v) { return (float)v * (2.0f / 255.0f) - 1.0f; }
+
+glm::vec3 decodeOctahedral(uint8_t ex, uint8_t ey) {
+    float x = unpackOctahedral(ex), y = unpackOctahedral(ey);
+    float z = 1.0f - std::abs(x) - std::abs(y);
+    float t = std::max(-z, 0.0f);
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    return glm::normalize(glm::vec3(x, y, z));
+}
+
+void encodeOctahedral(const glm::vec3& n, uint8_t& outX, uint8_t& outY) {
+    float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (sum <= 0.0f) { outX = outY = 128; return; }
+    float x = n.x / sum, y = n.y / sum;
+    if (n.z < 0.0f) {
+        float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+    }
+    // Of the four surrounding grid points, keep the one that decodes closest
+    float gx = std::floor((x * 0.5f + 0.5f) * 255.0f), gy = std::floor((y * 0.5f + 0.5f) * 255.0f);
+    float bestDot = -2.0f;
+    for (int dy = 0; dy < 2; dy++) {
+        for (int dx = 0; dx < 2; dx++) {
+            uint8_t cx = (uint8_t)std::min(255.0f, std::max(0.0f, gx + dx));
+            uint8_t cy = (uint8_t)std::min(255.0f, std::max(0.0f, gy + dy));
+            float d = glm::dot(decodeOctahedral(cx, cy), n);
+            if (d > bestDot) { bestDot = d; outX = cx; outY = cy; }
+        }
+    }
+}
+
+// ---------- Encode ----------
+
+// Offsets span at most 16 bits; the largest cluster is given a few steps of
+// slack for rounding.
+static constexpr float MAX_GRID_SPAN     = 65535.0f;
+static constexpr float LARGEST_GRID_SPAN = 65530.0f;
+
+// 32-bit key for a grid point (fewer sort passes than 64 bits). Distinct
+// points rarely share a key; if they do, both are rounded to the coarser of
+// their grids, which every copy of each still agrees on.
+static inline uint32_t gridPointKey(const glm::ivec3& p) {
+    uint64_t h = FlatHashMap64::hash(((uint64_t)(uint32_t)p.x << 32) | (uint32_t)p.y);
+    return (uint32_t)FlatHashMap64::hash(h ^ (uint32_t)p.z);
+}
+
+bool encodeGeometry(const ClusterGeometryPool& geometry, const std::vector<Cluster>& clusters, EncodedGeometry& out) {
+    AABB bounds;
+    float minExtent = FLT_MAX, maxExtent = 0.0f;
+    out.clusters.resize(clusters.size());
+    uint32_t numVertices = 0, numIndices = 0;
+    for (size_t i = 0; i < clusters.size(); i++) {
+        const Cluster& c = clusters[i];
+        if (c.numVertices > MAX_CLUSTER_VERTICES || c.numTris > 0xFFFF) {
+            fprintf(stderr, "encodeGeometry: cluster %zu has %u vertices, %u triangles (max %u, %u)\n",
+                    i, c.numVertices, c.numTris, MAX_CLUSTER_VERTICES, 0xFFFF);
+            return false;
+        }
+        EncodedCluster& ec = out.clusters[i];
+        ec.vertexOffset = numVertices;
+        ec.indexOffset = numIndices;
+        ec.numVertices = (uint16_t)c.numVertices;
+        ec.numTris = (uint16_t)c.numTris;
+        numVertices += c.numVertices;
+        numIndices += c.numTris * 3;
+        if (c.numVertices == 0) continue;
+        bounds.expand(c.bounds);
+        glm::vec3 extent = c.bounds.max - c.bounds.min;
+        float maxAxis = std::max(extent.x, std::max(extent.y, extent.z));
+        if (maxAxis > 0.0f) minExtent = std::min(minExtent, maxAxis);
+        maxExtent = std::max(maxExtent, maxAxis);
+    }
+    out.vertices.resize(numVertices);
+    out.indices.resize(numIndices);
+    if (!bounds.valid()) return true;
+
+    // Base grid: the largest cluster spans 16 bits of the grid 2^maxShift
+    // times coarser, with maxShift the smallest for which the smallest cluster
+    // spans at least 15 bits of the base grid. The mesh spans at most 24 bits
+    // of it, so grid coordinates convert to float exactly (float positions
+    // are no finer).
+    glm::vec3 boundsExtent = bounds.max - bounds.min;
+    float meshExtent = std::max(boundsExtent.x, std::max(boundsExtent.y, boundsExtent.z));
+    float finestStep = std::max(minExtent / 32768.0f, meshExtent / 8388608.0f);
+    uint32_t maxShift = 0;
+    while (maxExtent / std::ldexp(LARGEST_GRID_SPAN, (int)maxShift) > finestStep) maxShift++;
+    out.gridOrigin = bounds.min;
+    out.gridStep = maxExtent > 0.0f ? maxExtent / std::ldexp(LARGEST_GRID_SPAN, (int)maxShift) : 1.0f;
+
+    // Each cluster stores its offsets in steps of gridStep << shift, with the
+    // smallest shift that fits 16 bits. A position is rounded to the coarsest
+    // grid of all clusters that contain it, so every copy of it decodes to
+    // the same point (the grids are nested). That rounding moves a point by
+    // up to half a step of the coarsest grid, 2^(maxShift - 1) base steps,
+    // which the shifts leave room for.
+    std::vector<uint8_t> shifts(clusters.size(), 0);
+    parallelFor((uint32_t)clusters.size(), [&](uint32_t i) {
+        glm::vec3 extent = clusters[i].bounds.max - clusters[i].bounds.min;
+        float maxAxis = std::max(extent.x, std::max(extent.y, extent.z));
+        uint32_t shift = 0;
+        while (shift < maxShift &&
+               maxAxis / std::ldexp(out.gridStep, (int)shift) + 2.0f + std::ldexp(1.0f, (int)(maxShift - shift)) > MAX_GRID_SPAN)
+            shift++;
+        shifts[i] = (uint8_t)shift;
+    });
+
+    double invStep = 1.0 / (double)out.gridStep;
+    glm::dvec3 origin(out.gridOrigin);
+    auto snap = [&](const glm::vec3& p) {
+        return glm::ivec3((int32_t)std::floor(((double)p.x - origin.x) * invStep + 0.5),
+                          (int32_t)std::floor(((double)p.y - origin.y) * invStep + 0.5),
+                          (int32_t)std::floor(((double)p.z - origin.z) * invStep + 0.5));
+    };
+
+    // Snap every vertex to the base grid and sort the points by key: the
+    // copies of one position form a run, and take the coarsest shift in it
+    std::vector<glm::ivec3> gridPos(numVertices);
+    std::vector<uint8_t> pointShifts(numVertices);
+    std::vector<RadixSortItem<uint32_t>> keys(numVertices);
+    parallelFor((uint32_t)clusters.size(), [&](uint32_t i) {
+        const EncodedCluster& ec = out.clusters[i];
+        const Vertex* vertices = geometry.clusterVertices(clusters[i]);
+        for (uint32_t v = ec.vertexOffset; v < ec.vertexOffset + ec.numVertices; v++) {
+            gridPos[v] = snap(vertices[v - ec.vertexOffset].position);
+            pointShifts[v] = shifts[i];
+            keys[v] = { gridPointKey(gridPos[v]), v };
+        }
+    });
+    radixSort(keys);
+    for (uint32_t begin = 0, end; begin < numVertices; begin = end) {
+        uint8_t shift = 0;
+        for (end = begin; end < numVertices && keys[end].key == keys[begin].key; end++)
+            shift = std::max(shift, pointShifts[keys[end].index]);
+        for (uint32_t k = begin; k < end; k++) pointShifts[keys[k].index] = shift;
+    }
+
+    parallelFor((uint32_t)clusters.size(), [&](uint32_t i) {
+        const Cluster& c = clusters[i];
+        EncodedCluster& ec = out.clusters[i];
+        const Vertex* vertices = geometry.clusterVertices(c);
+        const uint32_t* indices = geometry.clusterIndices(c);
+        EncodedVertex* encoded = out.vertices.data() + ec.vertexOffset;
+        ec.gridShift = shifts[i];
+
+        // Round to the point's coarsest grid (the same position always
+        // lands on the same point)
+        glm::ivec3* points = gridPos.data() + ec.vertexOffset;
+        for (int a = 0; a < 3; a++) ec.gridMin[a] = INT32_MAX;
+        for (uint32_t v = 0; v < c.numVertices; v++) {
+            uint32_t shift = pointShifts[ec.vertexOffset + v];
+            if (shift > 0) {
+                int32_t half = 1 << (shift - 1);
+                for (int a = 0; a < 3; a++) points[v][a] = ((points[v][a] + half) >> shift) << shift;
+            }
+            for (int a = 0; a < 3; a++) ec.gridMin[a] = std::min(ec.gridMin[a], points[v][a]);
+        }
+        for (uint32_t v = 0; v < c.numVertices; v++) {
+            encoded[v].x = (uint16_t)((points[v].x - ec.gridMin[0]) >> ec.gridShift);
+            encoded[v].y = (uint16_t)((points[v].y - ec.gridMin[1]) >> ec.gridShift);
+            encoded[v].z = (uint16_t)((points[v].z - ec.gridMin[2]) >> ec.gridShift);
+            encodeOctahedral(vertices[v].normal, encoded[v].normalX, encoded[v].normalY);
+        }
+        for (uint32_t j = 0; j < c.numTris * 3; j++) out.indices[ec.indexOffset + j] = (uint8_t)indices[j];
+    });
+    return true;
+}
+
+// ---------- Decode ----------
+
+void EncodedGeometry::decodePositions(const EncodedCluster& c, glm::vec4* out) const {
+    const EncodedVertex* src = clusterVertices(c);
+#if NANITE_DECODE_SSE2
+    // One vertex per iteration: widen x, y, z (and the packed normal) to
+    // 32 bits, shift to base steps, add the cluster corner, scale, then
+    // overwrite w with 1
+    const __m128i zero    = _mm_setzero_si128();
+    const __m128i shift   = _mm_cvtsi32_si128(c.gridShift);
+    const __m128i gridMin = _mm_setr_epi32(c.gridMin[0], c.gridMin[1], c.gridMin[2], 0);
+    const __m128  step    = _mm_set1_ps(gridStep);
+    const __m128  origin  = _mm_setr_ps(gridOrigin.x, gridOrigin.y, gridOrigin.z, 0.0f);
+    const __m128  xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    const __m128  wOne    = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    for (uint32_t v = 0; v < c.numVertices; v++) {
+        __m128i q = _mm_loadl_epi64((const __m128i*)&src[v]);
+        __m128i n = _mm_add_epi32(_mm_sll_epi32(_mm_unpacklo_epi16(q, zero), shift), gridMin);
+        __m128  p = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(n), step), origin);
+        _mm_storeu_ps(&out[v].x, _mm_or_ps(_mm_and_ps(p, xyzMask), wOne));
+    }
+#else
+    for (uint32_t v = 0; v < c.numVertices; v++) {
+        out[v] = glm::vec4(
+            gridOrigin.x + (float)(c.gridMin[0] + ((int32_t)src[v].x << c.gridShift)) * gridStep,
+            gridOrigin.y + (float)(c.gridMin[1] + ((int32_t)src[v].y << c.gridShift)) * gridStep,
+            gridOrigin.z + (float)(c.gridMin[2] + ((int32_t)src[v].z << c.gridShift)) * gridStep,
+            1.0f);
+    }
+#endif
+}
+
+size_t EncodedGeometry::memoryBytes() const {
+    return clusters.size() * sizeof(EncodedCluster) + vertices.size() * sizeof(EncodedVertex) + indices.size();
+}
+
+} // namespace nanite
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "cluster.h"
+
+namespace nanite {
+
+// Quantized vertex (8 bytes, a third of a Vertex): position as a 16-bit
+// offset from its cluster's corner in steps of its cluster's grid, and an
+// octahedral normal with 8 bits per axis.
+struct EncodedVertex {
+    uint16_t x, y, z;
+    uint8_t  normalX, normalY;
+};
+static_assert(sizeof(EncodedVertex) == 8, "EncodedVertex should stay 8 bytes");
+
+struct EncodedCluster {
+    int32_t  gridMin[3];        // cluster corner on the base grid
+    uint32_t vertexOffset = 0;  // into EncodedGeometry::vertices
+    uint32_t indexOffset  = 0;  // into EncodedGeometry::indices
+    uint16_t numVertices  = 0;  // at most MAX_CLUSTER_VERTICES
+    uint16_t numTris      = 0;
+    uint8_t  gridShift    = 0;  // vertex offsets are in steps of gridStep << gridShift
+};
+
+// Runtime encoding of a whole ClusterGeometryPool, about 3x smaller.
+// Positions are snapped to nested power-of-two grids on one base grid, whose
+// step is fine enough for the smallest cluster: each cluster uses the finest
+// of them (gridShift) that fits its extent in 16 bits, so leaves keep leaf
+// precision. A position shared by several clusters (of the same or of
+// different levels) is snapped to the coarsest of their grids in all of them
+// and decodes to the same float, so seams stay watertight. Indices are 8-bit
+// (clusters have at most MAX_CLUSTER_VERTICES vertices); boundary edge flags
+// are build-only and dropped.
+struct EncodedGeometry {
+    glm::vec3 gridOrigin = glm::vec3(0.0f);
+    float     gridStep   = 1.0f;     // base grid step, a power of two
+
+    std::vector<EncodedCluster> clusters;   // parallel to the source clusters
+    std::vector<EncodedVertex>  vertices;
+    std::vector<uint8_t>        indices;    // local indices
+
+    const EncodedVertex* clusterVertices(const EncodedCluster& c) const { return vertices.data() + c.vertexOffset; }
+    const uint8_t*       clusterIndices(const EncodedCluster& c) const { return indices.data() + c.indexOffset; }
+
+    // Decode the positions of cluster `c` into out[0 .. c.numVertices), with
+    // w = 1 (SSE2 when available).
+    void decodePositions(const EncodedCluster& c, glm::vec4* out) const;
+
+    size_t memoryBytes() const;
+};
+
+// Encode `clusters` (with geometry in `geometry`); out.clusters[i] is
+// clusters[i]. Returns false (after printing why) if a cluster exceeds
+// MAX_CLUSTER_VERTICES or 16-bit triangle counts.
+bool encodeGeometry(const ClusterGeometryPool& geometry, const std::vector<Cluster>& clusters, EncodedGeometry& out);
+
+// Octahedral unit vector encoding with 8 bits per axis (max error ~0.7 deg).
+void encodeOctahedral(const glm::vec3& normal, uint8_t& outX, uint8_t& outY);
+glm::vec3 decodeOctahedral(uint8_t x, uint8_t y);
+
+} // namespace nanite
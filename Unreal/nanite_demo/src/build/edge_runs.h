@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace nanite {
+
+// Buckets with more edges than this are sorted with std::sort: insertion sort
+// is quadratic in the vertex degree.
+static constexpr uint32_t EDGE_RUN_INSERTION_SORT_MAX = 16;
+
+// Sort edges into runs of edges between the same two vertices: the edges
+// adjacent to one triangle edge of a welded mesh, or to one seam.
+//
+// forEachEdge(fn) calls fn(edge, lo, hi) for every edge, with edge <
+// numEdges and lo <= hi < numVertices; it is called twice (count, then
+// fill) and must produce the same edges both times. The edges are counting-
+// sorted by lower vertex into records of (hi << 32 | edge); each bucket is
+// then sorted (insertion sort for the usual small vertex degree, std::sort
+// for fan or pole vertices), so records ends up ordered by (lo, hi, edge),
+// and onRun(begin, end) is called for every run records[begin .. end) of
+// equal (lo, hi). bucketEnd and records are
+// scratch, passed in so callers can reuse them.
+template<typename ForEachEdge, typename OnRun>
+void sortEdgeRuns(uint32_t numVertices, uint32_t numEdges, const ForEachEdge& forEachEdge,
+                  std::vector<uint32_t>& bucketEnd, std::vector<uint64_t>& records, const OnRun& onRun)
+{
+    bucketEnd.assign(numVertices + 1, 0);
+    records.resize(numEdges);
+    forEachEdge([&](uint32_t, uint32_t lo, uint32_t) { bucketEnd[lo + 1]++; });
+    for (uint32_t v = 0; v < numVertices; v++) bucketEnd[v + 1] += bucketEnd[v];
+    forEachEdge([&](uint32_t edge, uint32_t lo, uint32_t hi) {
+        records[bucketEnd[lo]++] = ((uint64_t)hi << 32) | edge;
+    });
+
+    for (uint32_t v = 0, begin = 0; v < numVertices; v++) {
+        uint32_t end = bucketEnd[v];
+        if (end - begin > EDGE_RUN_INSERTION_SORT_MAX) {
+            std::sort(records.begin() + begin, records.begin() + end);
+        } else {
+            for (uint32_t i = begin + 1; i < end; i++) {
+                uint64_t r = records[i];
+                uint32_t j = i;
+                for (; j > begin && records[j - 1] > r; j--) records[j] = records[j - 1];
+                records[j] = r;
+            }
+        }
+        for (uint32_t i = begin; i < end;) {
+            uint32_t run = i + 1;
+            while (run < end && (records[run] >> 32) == (records[i] >> 32)) run++;
+            onRun(i, run);
+            i = run;
+        }
+        begin = end;
+    }
+}
+
+} // namespace nanite
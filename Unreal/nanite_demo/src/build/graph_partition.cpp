@@ -0,0 +1,563 @@
+#include "graph_partition.h"
+#include "../core/parallel.h"
+#include "../core/types.h"
+#include <algorithm>
+
+namespace nanite {
+
+// Coarsening stops at this many nodes, or when a level barely shrinks.
+static constexpr uint32_t COARSEST_NODES = 96;
+static constexpr double   MIN_COARSEN_RATIO = 0.9;
+// Region-growing seeds tried on the coarsest graph (its first and last node).
+static constexpr uint32_t INITIAL_BISECTION_SEEDS = 2;
+static constexpr uint32_t MAX_REFINE_PASSES = 4;
+// A refinement pass gives up after n / 16 moves (clamped to this range)
+// without a better cut.
+static constexpr uint32_t MIN_MOVES_WITHOUT_GAIN = 16;
+static constexpr uint32_t MAX_MOVES_WITHOUT_GAIN = 64;
+
+// One level of a bisection's multilevel hierarchy, in local node ids.
+struct LevelGraph {
+    std::vector<uint32_t> offsets;      // numNodes + 1
+    std::vector<uint32_t> adjacency;
+    std::vector<uint32_t> edgeWeights;
+    std::vector<uint32_t> nodeWeights;
+    std::vector<uint32_t> coarseOf;     // node -> node of the next coarser level
+
+    uint32_t numNodes() const { return (uint32_t)nodeWeights.size(); }
+};
+
+// Allowed weight of side 0 and the weight it should ideally get.
+struct BisectionTarget {
+    int64_t minLeft, maxLeft, target;
+
+    int64_t violation(int64_t left) const {
+        return left < minLeft ? minLeft - left : (left > maxLeft ? left - maxLeft : 0);
+    }
+};
+
+// Max-heap entry; equal gains pop the lowest node first.
+struct GainEntry {
+    int64_t  gain;
+    uint32_t node;
+    bool operator<(const GainEntry& o) const { return gain != o.gain ? gain < o.gain : node > o.node; }
+};
+
+static void pushGain(std::vector<GainEntry>& heap, int64_t gain, uint32_t node) {
+    heap.push_back({ gain, node });
+    std::push_heap(heap.begin(), heap.end());
+}
+
+static void popGain(std::vector<GainEntry>& heap) {
+    std::pop_heap(heap.begin(), heap.end());
+    heap.pop_back();
+}
+
+// Buffers reused by all bisections of one task.
+struct BisectionScratch {
+    std::vector<LevelGraph> levels;
+    uint32_t                numLevels = 0;
+    std::vector<uint8_t>    side, trial, locked;
+    std::vector<int64_t>    gain;
+    std::vector<uint32_t>   moves, members, slot, sorted;
+    std::vector<GainEntry>  queues[2];
+
+    LevelGraph& addLevel() {
+        if (numLevels == levels.size()) levels.emplace_back();
+        LevelGraph& g = levels[numLevels++];
+        g.offsets.clear();
+        g.adjacency.clear();
+        g.edgeWeights.clear();
+        g.nodeWeights.clear();
+        return g;
+    }
+};
+
+// Cut weight and weight of side 0 of a bisection.
+struct BisectionState {
+    int64_t left = 0, cut = 0;
+};
+
+// The subgraph of `graph` induced by `nodes` (the nodes whose nodeRange is rangeId).
+static void extractSubgraph(const LevelGraph& graph, const uint32_t* nodes, uint32_t count,
+                            uint32_t rangeId, const uint32_t* nodeRange, uint32_t* localId, LevelGraph& out)
+{
+    for (uint32_t i = 0; i < count; i++) localId[nodes[i]] = i;
+    out.offsets.resize(count + 1);
+    out.nodeWeights.resize(count);
+    out.offsets[0] = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t node = nodes[i];
+        out.nodeWeights[i] = graph.nodeWeights[node];
+        for (uint32_t e = graph.offsets[node]; e < graph.offsets[node + 1]; e++) {
+            uint32_t neighbor = graph.adjacency[e];
+            if (nodeRange[neighbor] != rangeId) continue;
+            out.adjacency.push_back(localId[neighbor]);
+            out.edgeWeights.push_back(graph.edgeWeights[e]);
+        }
+        out.offsets[i + 1] = (uint32_t)out.adjacency.size();
+    }
+}
+
+// Heavy-edge matching: in node order, each unmatched node pairs with the
+// unmatched neighbour it shares the heaviest edge with, unless the pair
+// would outweigh maxNodeWeight. Returns false if the graph barely shrinks.
+static bool coarsen(LevelGraph& fine, LevelGraph& coarse, uint32_t maxNodeWeight, BisectionScratch& s) {
+    uint32_t n = fine.numNodes();
+    fine.coarseOf.assign(n, INVALID_INDEX);
+    s.members.clear();  // two per coarse node
+    uint32_t numCoarse = 0;
+    for (uint32_t v = 0; v < n; v++) {
+        if (fine.coarseOf[v] != INVALID_INDEX) continue;
+        uint32_t best = INVALID_INDEX, bestWeight = 0;
+        for (uint32_t e = fine.offsets[v]; e < fine.offsets[v + 1]; e++) {
+            uint32_t u = fine.adjacency[e];
+            if (fine.coarseOf[u] != INVALID_INDEX || fine.nodeWeights[v] + fine.nodeWeights[u] > maxNodeWeight) continue;
+            if (fine.edgeWeights[e] > bestWeight) {
+                best = u;
+                bestWeight = fine.edgeWeights[e];
+            }
+        }
+        fine.coarseOf[v] = numCoarse;
+        if (best != INVALID_INDEX) fine.coarseOf[best] = numCoarse;
+        s.members.push_back(v);
+        s.members.push_back(best);
+        numCoarse++;
+    }
+    if (numCoarse > n * MIN_COARSEN_RATIO) return false;
+
+    // Merge the members' edges; `slot` finds an existing edge to a coarse neighbour
+    coarse.offsets.push_back(0);
+    coarse.nodeWeights.assign(numCoarse, 0);
+    coarse.adjacency.reserve(fine.adjacency.size());
+    coarse.edgeWeights.reserve(fine.adjacency.size());
+    s.slot.assign(numCoarse, INVALID_INDEX);
+    for (uint32_t c = 0; c < numCoarse; c++) {
+        for (uint32_t m = 0; m < 2; m++) {
+            uint32_t v = s.members[c * 2 + m];
+            if (v == INVALID_INDEX) continue;
+            coarse.nodeWeights[c] += fine.nodeWeights[v];
+            for (uint32_t e = fine.offsets[v]; e < fine.offsets[v + 1]; e++) {
+                uint32_t cu = fine.coarseOf[fine.adjacency[e]];
+                if (cu == c) continue;
+                if (s.slot[cu] == INVALID_INDEX) {
+                    s.slot[cu] = (uint32_t)coarse.adjacency.size();
+                    coarse.adjacency.push_back(cu);
+                    coarse.edgeWeights.push_back(fine.edgeWeights[e]);
+                } else {
+                    coarse.edgeWeights[s.slot[cu]] += fine.edgeWeights[e];
+                }
+            }
+        }
+        for (uint32_t e = coarse.offsets[c]; e < (uint32_t)coarse.adjacency.size(); e++) s.slot[coarse.adjacency[e]] = INVALID_INDEX;
+        coarse.offsets.push_back((uint32_t)coarse.adjacency.size());
+    }
+    return true;
+}
+
+static int64_t cutWeight(const LevelGraph& g, const std::vector<uint8_t>& side) {
+    int64_t cut = 0;
+    for (uint32_t v = 0; v < g.numNodes(); v++) {
+        for (uint32_t e = g.offsets[v]; e < g.offsets[v + 1]; e++) {
+            if (side[g.adjacency[e]] != side[v]) cut += g.edgeWeights[e];
+        }
+    }
+    return cut / 2;
+}
+
+// Greedy graph growing: side 0 starts at `seed` and repeatedly takes the
+// frontier node that adds the least cut, until it reaches the target weight.
+// A region that runs out of frontier (disconnected graph) continues from
+// the next free node in node order. Returns the weight of side 0.
+static int64_t growRegion(const LevelGraph& g, uint32_t seed, const BisectionTarget& t,
+                          std::vector<uint8_t>& side, BisectionScratch& s)
+{
+    uint32_t n = g.numNodes();
+    side.assign(n, 1);
+    // gain[v]: cut change of moving v into the region, negated
+    std::vector<int64_t>& gain = s.gain;
+    gain.resize(n);
+    for (uint32_t v = 0; v < n; v++) {
+        int64_t degree = 0;
+        for (uint32_t e = g.offsets[v]; e < g.offsets[v + 1]; e++) degree += g.edgeWeights[e];
+        gain[v] = -degree;
+    }
+    std::vector<GainEntry>& frontier = s.queues[0];
+    frontier.clear();
+    pushGain(frontier, gain[seed], seed);
+    int64_t left = 0;
+    uint32_t nextFree = 0;
+    while (left < t.target) {
+        uint32_t v = INVALID_INDEX;
+        while (!frontier.empty()) {
+            GainEntry top = frontier.front();
+            popGain(frontier);
+            if (side[top.node] == 1 && top.gain == gain[top.node]) {
+                v = top.node;
+                break;
+            }
+        }
+        if (v == INVALID_INDEX) {
+            while (nextFree < n && side[nextFree] != 1) nextFree++;
+            if (nextFree == n) break;
+            v = nextFree;
+        }
+        if (left + g.nodeWeights[v] > t.maxLeft) {
+            side[v] = 2;  // too heavy to take; stays on side 1
+            continue;
+        }
+        side[v] = 0;
+        left += g.nodeWeights[v];
+        for (uint32_t e = g.offsets[v]; e < g.offsets[v + 1]; e++) {
+            uint32_t u = g.adjacency[e];
+            if (side[u] == 0) continue;
+            gain[u] += 2 * (int64_t)g.edgeWeights[e];
+            pushGain(frontier, gain[u], u);
+        }
+    }
+    for (uint8_t& x : side) x = x ? 1 : 0;
+    return left;
+}
+
+// Fiduccia-Mattheyses refinement. Each pass moves the best-gain node (any
+// node whose move keeps the bisection balanced, or brings it closer to
+// balance), locks it and updates its neighbours, then rolls back to the
+// best cut seen.
+static void refineBisection(const LevelGraph& g, const BisectionTarget& t, std::vector<uint8_t>& side,
+                            BisectionState& state, BisectionScratch& s)
+{
+    uint32_t n = g.numNodes();
+    std::vector<int64_t>& gain = s.gain;
+    std::vector<uint8_t>& locked = s.locked;
+    uint32_t maxMovesWithoutGain = std::min(MAX_MOVES_WITHOUT_GAIN, std::max(MIN_MOVES_WITHOUT_GAIN, n / 16));
+    gain.resize(n);
+    for (uint32_t pass = 0; pass < MAX_REFINE_PASSES; pass++) {
+        s.queues[0].clear();
+        s.queues[1].clear();
+        for (uint32_t v = 0; v < n; v++) {
+            int64_t external = 0, internal = 0;
+            for (uint32_t e = g.offsets[v]; e < g.offsets[v + 1]; e++) {
+                (side[g.adjacency[e]] != side[v] ? external : internal) += g.edgeWeights[e];
+            }
+            gain[v] = external - internal;
+            if (external > 0) s.queues[side[v]].push_back({ gain[v], v });
+        }
+        std::make_heap(s.queues[0].begin(), s.queues[0].end());
+        std::make_heap(s.queues[1].begin(), s.queues[1].end());
+        locked.assign(n, 0);
+        s.moves.clear();
+
+        int64_t left = state.left, cut = state.cut;
+        int64_t bestViolation = t.violation(left), bestCut = cut, bestLeft = left;
+        size_t bestMoves = 0;
+        uint32_t movesWithoutGain = 0;
+        while (movesWithoutGain < maxMovesWithoutGain) {
+            // Best valid candidate of each side, if moving it is allowed
+            uint32_t candidate[2] = { INVALID_INDEX, INVALID_INDEX };
+            for (uint8_t from = 0; from < 2; from++) {
+                std::vector<GainEntry>& queue = s.queues[from];
+                while (!queue.empty()) {
+                    const GainEntry& top = queue.front();
+                    if (!locked[top.node] && side[top.node] == from && top.gain == gain[top.node]) break;
+                    popGain(queue);
+                }
+                if (queue.empty()) continue;
+                uint32_t v = queue.front().node;
+                int64_t newLeft = left + (from == 0 ? -(int64_t)g.nodeWeights[v] : (int64_t)g.nodeWeights[v]);
+                if (t.violation(newLeft) == 0 || t.violation(newLeft) < t.violation(left)) candidate[from] = v;
+            }
+            uint8_t from;
+            if (candidate[0] == INVALID_INDEX && candidate[1] == INVALID_INDEX) break;
+            else if (candidate[0] == INVALID_INDEX) from = 1;
+            else if (candidate[1] == INVALID_INDEX) from = 0;
+            else if (gain[candidate[0]] != gain[candidate[1]]) from = gain[candidate[0]] > gain[candidate[1]] ? 0 : 1;
+            else from = left > t.target ? 0 : 1;
+
+            uint32_t v = candidate[from];
+            popGain(s.queues[from]);
+            locked[v] = 1;
+            side[v] = 1 - from;
+            left += from == 0 ? -(int64_t)g.nodeWeights[v] : (int64_t)g.nodeWeights[v];
+            cut -= gain[v];
+            s.moves.push_back(v);
+            for (uint32_t e = g.offsets[v]; e < g.offsets[v + 1]; e++) {
+                uint32_t u = g.adjacency[e];
+                if (locked[u]) continue;
+                gain[u] += (side[u] == side[v] ? -2 : 2) * (int64_t)g.edgeWeights[e];
+                pushGain(s.queues[side[u]], gain[u], u);
+            }
+
+            int64_t violation = t.violation(left);
+            if (violation < bestViolation || (violation == bestViolation && cut < bestCut)) {
+                bestViolation = violation;
+                bestCut = cut;
+                bestLeft = left;
+                bestMoves = s.moves.size();
+                movesWithoutGain = 0;
+            } else {
+                movesWithoutGain++;
+            }
+        }
+
+        for (size_t i = bestMoves; i < s.moves.size(); i++) side[s.moves[i]] ^= 1;
+        state.left = bestLeft;
+        state.cut = bestCut;
+        if (bestMoves == 0) break;
+    }
+}
+
+// Last resort for a bisection that refinement could not balance (few or
+// no edges between the sides): move nodes in node order.
+static void forceBalance(const LevelGraph& g, const BisectionTarget& t, std::vector<uint8_t>& side, int64_t left) {
+    for (uint32_t v = 0; v < g.numNodes() && t.violation(left) > 0; v++) {
+        uint8_t from = left > t.maxLeft ? 0 : 1;
+        if (side[v] != from) continue;
+        side[v] = 1 - from;
+        left += from == 0 ? -(int64_t)g.nodeWeights[v] : (int64_t)g.nodeWeights[v];
+    }
+}
+
+// Split s.levels[0] (of total weight `weight`) into s.side 0 and 1.
+static void bisect(const BisectionTarget& t, int64_t weight, BisectionScratch& s) {
+    uint32_t maxNodeWeight = std::max(1u, (uint32_t)(weight * 3 / (2 * COARSEST_NODES)));
+    while (s.levels[s.numLevels - 1].numNodes() > COARSEST_NODES) {
+        LevelGraph& coarse = s.addLevel();
+        if (!coarsen(s.levels[s.numLevels - 2], coarse, maxNodeWeight, s)) {
+            s.numLevels--;
+            break;
+        }
+    }
+
+    // Initial bisection of the coarsest graph: the best of a few seeds
+    const LevelGraph& coarsest = s.levels[s.numLevels - 1];
+    uint32_t n = coarsest.numNodes();
+    uint32_t seeds[INITIAL_BISECTION_SEEDS] = { 0, n - 1 };
+    BisectionState best;
+    int64_t bestViolation = 0;
+    for (uint32_t i = 0; i < INITIAL_BISECTION_SEEDS; i++) {
+        BisectionState state;
+        state.left = growRegion(coarsest, seeds[i], t, s.trial, s);
+        state.cut = cutWeight(coarsest, s.trial);
+        refineBisection(coarsest, t, s.trial, state, s);
+        int64_t violation = t.violation(state.left);
+        if (i == 0 || violation < bestViolation || (violation == bestViolation && state.cut < best.cut)) {
+            bestViolation = violation;
+            best = state;
+            s.side.swap(s.trial);
+        }
+    }
+
+    // Project back to the finest level, refining at each; projection keeps
+    // the cut and side weights
+    for (uint32_t l = s.numLevels - 1; l-- > 0;) {
+        const LevelGraph& fine = s.levels[l];
+        s.trial.resize(fine.numNodes());
+        for (uint32_t v = 0; v < fine.numNodes(); v++) s.trial[v] = s.side[fine.coarseOf[v]];
+        s.side.swap(s.trial);
+        refineBisection(fine, t, s.side, best, s);
+    }
+    forceBalance(s.levels[0], t, s.side, best.left);
+}
+
+// Greedy k-way refinement: in node order, move each node on a part border
+// to the neighbouring part it has the most edge weight to, if that lowers
+// the cut (or keeps it and evens out the two parts) and both parts stay
+// within minPartSize..maxPartSize.
+static void refineParts(const LevelGraph& g, const GraphPartitionOptions& options,
+                        std::vector<uint32_t>& part, std::vector<int64_t>& partWeights)
+{
+    std::vector<uint32_t> neighborParts;
+    std::vector<int64_t> connection;  // per entry of neighborParts
+    for (uint32_t pass = 0; pass < MAX_REFINE_PASSES; pass++) {
+        uint32_t numMoves = 0;
+        for (uint32_t v = 0; v < g.numNodes(); v++) {
+            uint32_t own = part[v];
+            int64_t internal = 0;
+            neighborParts.clear();
+            connection.clear();
+            for (uint32_t e = g.offsets[v]; e < g.offsets[v + 1]; e++) {
+                uint32_t p = part[g.adjacency[e]];
+                if (p == own) {
+                    internal += g.edgeWeights[e];
+                    continue;
+                }
+                size_t i = std::find(neighborParts.begin(), neighborParts.end(), p) - neighborParts.begin();
+                if (i == neighborParts.size()) {
+                    neighborParts.push_back(p);
+                    connection.push_back(0);
+                }
+                connection[i] += g.edgeWeights[e];
+            }
+            int64_t w = g.nodeWeights[v];
+            if (neighborParts.empty() || partWeights[own] - w < options.minPartSize) continue;
+
+            uint32_t best = INVALID_INDEX;
+            int64_t bestGain = 0;
+            for (size_t i = 0; i < neighborParts.size(); i++) {
+                uint32_t p = neighborParts[i];
+                if (partWeights[p] + w > options.maxPartSize) continue;
+                int64_t gain = connection[i] - internal;
+                bool evens = partWeights[p] + w < partWeights[own];
+                if (gain > bestGain || (gain == 0 && best == INVALID_INDEX && evens)) {
+                    best = p;
+                    bestGain = gain;
+                }
+            }
+            if (best == INVALID_INDEX) continue;
+            part[v] = best;
+            partWeights[own] -= w;
+            partWeights[best] += w;
+            numMoves++;
+        }
+        if (numMoves == 0) break;
+    }
+}
+
+struct PartRange {
+    uint32_t begin, end, numParts;
+    int64_t  weight;
+};
+
+// Recursive bisection of `graph` into numParts parts. Returns the part of
+// every node; parts are numbered in the order the recursion leaves them.
+static std::vector<uint32_t> bisectRecursively(const LevelGraph& graph, uint32_t numParts,
+                                               const GraphPartitionOptions& options, uint32_t numThreads)
+{
+    uint32_t n = graph.numNodes();
+    std::vector<uint32_t> order(n);
+    for (uint32_t i = 0; i < n; i++) order[i] = i;
+    int64_t totalWeight = 0;
+    for (uint32_t w : graph.nodeWeights) totalWeight += w;
+
+    // Most weight p parts may share: each bisection below keeps `slack` of
+    // room, so the windows never close up (which would leave refinement no
+    // freedom, and could not be met with nodes heavier than 1).
+    auto capacity = [&](uint32_t p) { return (int64_t)p * options.maxPartSize - (int64_t)(p - 1) * options.slack; };
+
+    // Bisect level by level; the ranges of one level are independent
+    std::vector<PartRange> ranges, nextRanges, finished;
+    (numParts > 1 ? ranges : finished).push_back({ 0, n, numParts, totalWeight });
+    // nodeRange: id of the range a node is in. Ids are unique over all levels,
+    // so nodes of finished parts never match a range being bisected.
+    std::vector<uint32_t> nodeRange(n, INVALID_INDEX), localId(n);
+    uint32_t firstRangeId = 0;
+    while (!ranges.empty()) {
+        uint32_t numRanges = (uint32_t)ranges.size();
+        uint32_t numTasks = std::min(numThreads, numRanges);
+        parallelFor(numTasks, [&](uint32_t task) {
+            for (uint32_t r = task; r < numRanges; r += numTasks) {
+                for (uint32_t i = ranges[r].begin; i < ranges[r].end; i++) nodeRange[order[i]] = firstRangeId + r;
+            }
+        });
+
+        std::vector<PartRange> children((size_t)numRanges * 2);
+        parallelFor(numTasks, [&](uint32_t task) {
+            BisectionScratch s;
+            for (uint32_t r = task; r < numRanges; r += numTasks) {
+                const PartRange& range = ranges[r];
+                uint32_t count = range.end - range.begin;
+                uint32_t* nodes = &order[range.begin];
+                s.numLevels = 0;
+                extractSubgraph(graph, nodes, count, firstRangeId + r, nodeRange.data(), localId.data(), s.addLevel());
+
+                // Side 0 gets leftParts parts: both sides must fit their parts
+                uint32_t leftParts = range.numParts / 2, rightParts = range.numParts - leftParts;
+                BisectionTarget t;
+                t.minLeft = std::max<int64_t>((int64_t)leftParts * options.minPartSize, range.weight - capacity(rightParts));
+                t.maxLeft = std::min<int64_t>(capacity(leftParts), range.weight - (int64_t)rightParts * options.minPartSize);
+                t.target = std::min(t.maxLeft, std::max(t.minLeft, range.weight * leftParts / range.numParts));
+                bisect(t, range.weight, s);
+
+                // The side holding the first node goes first; order within sides is kept
+                uint8_t first = s.side[0];
+                int64_t firstWeight = 0;
+                s.sorted.clear();
+                for (uint32_t i = 0; i < count; i++) {
+                    if (s.side[i] != first) continue;
+                    s.sorted.push_back(nodes[i]);
+                    firstWeight += s.levels[0].nodeWeights[i];
+                }
+                uint32_t split = range.begin + (uint32_t)s.sorted.size();
+                for (uint32_t i = 0; i < count; i++) if (s.side[i] != first) s.sorted.push_back(nodes[i]);
+                std::copy(s.sorted.begin(), s.sorted.end(), nodes);
+                uint32_t firstParts = first == 0 ? leftParts : rightParts;
+                children[r * 2 + 0] = { range.begin, split, firstParts, firstWeight };
+                children[r * 2 + 1] = { split, range.end, range.numParts - firstParts, range.weight - firstWeight };
+            }
+        });
+
+        firstRangeId += numRanges;
+        nextRanges.clear();
+        for (const PartRange& child : children) (child.numParts > 1 ? nextRanges : finished).push_back(child);
+        ranges.swap(nextRanges);
+    }
+
+    std::sort(finished.begin(), finished.end(), [](const PartRange& a, const PartRange& b) { return a.begin < b.begin; });
+    std::vector<uint32_t> part(n);
+    for (uint32_t p = 0; p < (uint32_t)finished.size(); p++) {
+        for (uint32_t i = finished[p].begin; i < finished[p].end; i++) part[order[i]] = p;
+    }
+    return part;
+}
+
+void partitionGraph(const PartitionGraph& graph, const GraphPartitionOptions& options,
+                    std::vector<uint32_t>& outOrder, std::vector<uint32_t>& outPartStarts)
+{
+    uint32_t n = graph.numNodes();
+    outOrder.resize(n);
+    for (uint32_t i = 0; i < n; i++) outOrder[i] = i;
+    outPartStarts.assign(1, 0);
+    if (n == 0) return;
+
+    uint32_t targetSize = std::max(options.minPartSize, options.maxPartSize - options.slack);
+    uint32_t numParts = std::max((n + options.maxPartSize - 1) / options.maxPartSize,
+                                 std::min((n + targetSize - 1) / targetSize, n / std::max(1u, options.minPartSize)));
+    numParts = std::max(1u, numParts);
+    if (numParts == 1) {
+        outPartStarts.push_back(n);
+        return;
+    }
+    uint32_t numThreads = options.numThreads ? options.numThreads : getNumWorkerThreads();
+
+    // Coarsen the whole graph once, to nodes light enough (half the slack)
+    // that every bisection can still meet its balance window. The recursion
+    // then runs on a graph a few times smaller.
+    std::vector<LevelGraph> levels(1);
+    LevelGraph& finest = levels[0];
+    finest.offsets = graph.adjacencyOffsets;
+    finest.adjacency = graph.adjacency;
+    finest.edgeWeights = graph.edgeWeights;
+    finest.nodeWeights.assign(n, 1);
+    BisectionScratch scratch;
+    uint32_t maxNodeWeight = std::max(1u, options.slack / 2);
+    while (true) {
+        LevelGraph coarse;
+        if (!coarsen(levels.back(), coarse, maxNodeWeight, scratch)) break;
+        levels.push_back(std::move(coarse));
+    }
+
+    // Partition the coarse graph, then project the parts back down, moving
+    // border nodes between parts at each level
+    std::vector<uint32_t> part = bisectRecursively(levels.back(), numParts, options, numThreads);
+    std::vector<int64_t> partWeights(numParts, 0);
+    for (uint32_t v = 0; v < levels.back().numNodes(); v++) partWeights[part[v]] += levels.back().nodeWeights[v];
+    std::vector<uint32_t> finePart;
+    for (size_t l = levels.size(); l-- > 0;) {
+        if (l + 1 < levels.size()) {
+            const LevelGraph& fine = levels[l];
+            finePart.resize(fine.numNodes());
+            for (uint32_t v = 0; v < fine.numNodes(); v++) finePart[v] = part[fine.coarseOf[v]];
+            part.swap(finePart);
+        }
+        refineParts(levels[l], options, part, partWeights);
+    }
+
+    // Group the nodes by part, keeping node order within each part
+    outPartStarts.assign(numParts + 1, 0);
+    for (uint32_t v = 0; v < n; v++) outPartStarts[part[v] + 1]++;
+    for (uint32_t p = 0; p < numParts; p++) outPartStarts[p + 1] += outPartStarts[p];
+    std::vector<uint32_t> fill(outPartStarts.begin(), outPartStarts.end() - 1);
+    for (uint32_t v = 0; v < n; v++) outOrder[fill[part[v]]++] = v;
+}
+
+} // namespace nanite
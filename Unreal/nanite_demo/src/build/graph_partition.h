@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace nanite {
+
+// Undirected graph with weighted edges in CSR form: the neighbours of node n
+// are adjacency[adjacencyOffsets[n] .. adjacencyOffsets[n + 1]). Every edge
+// is stored in both directions with the same weight; repeated edges are
+// allowed and simply add up.
+struct PartitionGraph {
+    std::vector<uint32_t> adjacencyOffsets;  // numNodes + 1
+    std::vector<uint32_t> adjacency;
+    std::vector<uint32_t> edgeWeights;       // parallel to adjacency
+
+    uint32_t numNodes() const { return adjacencyOffsets.empty() ? 0 : (uint32_t)adjacencyOffsets.size() - 1; }
+};
+
+// Fill `graph` from forEachLink(link), which calls link(a, b, weight) once
+// for every undirected edge. It is called twice (count, then fill) and must
+// produce the same links both times.
+template<typename ForEachLink>
+void buildPartitionGraph(uint32_t numNodes, const ForEachLink& forEachLink, PartitionGraph& graph) {
+    std::vector<uint32_t> degree(numNodes, 0);
+    forEachLink([&](uint32_t a, uint32_t b, uint32_t) { degree[a]++; degree[b]++; });
+    graph.adjacencyOffsets.resize(numNodes + 1);
+    graph.adjacencyOffsets[0] = 0;
+    for (uint32_t i = 0; i < numNodes; i++) graph.adjacencyOffsets[i + 1] = graph.adjacencyOffsets[i] + degree[i];
+    graph.adjacency.resize(graph.adjacencyOffsets[numNodes]);
+    graph.edgeWeights.resize(graph.adjacencyOffsets[numNodes]);
+    std::vector<uint32_t>& fill = degree;
+    for (uint32_t i = 0; i < numNodes; i++) fill[i] = graph.adjacencyOffsets[i];
+    forEachLink([&](uint32_t a, uint32_t b, uint32_t weight) {
+        graph.adjacency[fill[a]] = b;
+        graph.edgeWeights[fill[a]++] = weight;
+        graph.adjacency[fill[b]] = a;
+        graph.edgeWeights[fill[b]++] = weight;
+    });
+}
+
+// Weight of the links between neighbours in spatial (Morton) order, which
+// keep pieces that share no edges together by proximity.
+constexpr uint32_t LOCALITY_EDGE_WEIGHT = 1;
+// Elements sharing one (non-manifold) edge beyond this are not linked.
+constexpr uint32_t MAX_EDGE_FAN = 8;
+
+struct GraphPartitionOptions {
+    uint32_t minPartSize = 64;
+    uint32_t maxPartSize = 128;
+    // Parts are sized for maxPartSize - slack nodes on average, leaving
+    // each bisection that much room to move its cut to a cheaper place.
+    uint32_t slack = 8;
+    // Threads: 0 = all worker threads. The result is identical for every count.
+    uint32_t numThreads = 0;
+};
+
+// Partition the nodes into ceil(n / (maxPartSize - slack)) parts of
+// minPartSize..maxPartSize nodes (a graph smaller than that is one part)
+// while keeping the weight of cut edges low.
+//
+// Multilevel recursive bisection, in the spirit of METIS: the graph is first
+// coarsened by heavy-edge matching to nodes of at most slack / 2 nodes. Each
+// bisection then coarsens its own subgraph further, splits the coarsest one
+// by greedy region growing and refines the cut with Fiduccia-Mattheyses
+// passes while projecting it back. Sibling subgraphs are bisected in
+// parallel. Finally the parts are projected to the input graph, with greedy
+// moves of border nodes between neighbouring parts at each level.
+//
+// Node order matters: ties are resolved in node order and each part keeps
+// its nodes in the input order, so spatially sorted input gives spatially
+// coherent output. Parts are written to outOrder (node ids, grouped by
+// part) with part p at outOrder[outPartStarts[p] .. outPartStarts[p + 1]).
+void partitionGraph(const PartitionGraph& graph, const GraphPartitionOptions& options,
+                    std::vector<uint32_t>& outOrder, std::vector<uint32_t>& outPartStarts);
+
+} // namespace nanite
@@ -0,0 +1,135 @@
+#include "level_adjacency.h"
+#include "edge_runs.h"
+#include "../core/radix_sort.h"
+#include "../core/parallel.h"
+#include <algorithm>
+
+namespace nanite {
+
+// Shared edges outweigh locality links, so groups follow the surface and
+// only fall back to proximity for clusters with few or no neighbours.
+static constexpr uint32_t SHARED_EDGE_WEIGHT = 4;
+
+void buildLevelAdjacency(const ClusterGeometryPool& geometry, const std::vector<Cluster>& clusters,
+                         const std::vector<uint32_t>& levelClusters, LevelAdjacency& out)
+{
+    uint32_t numClusters = (uint32_t)levelClusters.size();
+    std::vector<uint32_t> vertexStarts(numClusters + 1, 0);
+    out.edgeStarts.assign(numClusters + 1, 0);
+    AABB bounds;
+    for (uint32_t i = 0; i < numClusters; i++) {
+        const Cluster& c = clusters[levelClusters[i]];
+        vertexStarts[i + 1] = vertexStarts[i] + c.numVertices;
+        out.edgeStarts[i + 1] = out.edgeStarts[i] + c.numTris * 3;
+        bounds.expand(c.bounds);
+    }
+    uint32_t numVerts = vertexStarts[numClusters];
+    uint32_t numEdges = out.edgeStarts[numClusters];
+
+    // Level vertex ids: Morton-sort all vertices, then number the distinct
+    // positions within each run of equal keys (equal positions have equal
+    // keys, and a run rarely holds more than one position)
+    MortonFrame frame(bounds, numVerts);
+    std::vector<glm::vec3> positions(numVerts);
+    std::vector<RadixSortItem<uint64_t>> sorted(numVerts);
+    parallelFor(numClusters, [&](uint32_t i) {
+        const Cluster& c = clusters[levelClusters[i]];
+        const Vertex* vertices = geometry.clusterVertices(c);
+        for (uint32_t v = 0, lv = vertexStarts[i]; v < c.numVertices; v++, lv++) {
+            positions[lv] = vertices[v].position;
+            sorted[lv] = { frame.encode(positions[lv]), lv };
+        }
+    });
+    radixSort(sorted);
+    std::vector<uint32_t> vertexIds(numVerts);
+    uint32_t numIds = 0;
+    for (uint32_t begin = 0, end; begin < numVerts; begin = end) {
+        for (end = begin + 1; end < numVerts && sorted[end].key == sorted[begin].key; end++) {}
+        for (uint32_t x = begin; x < end; x++) {
+            uint32_t y = begin;
+            while (y < x && positions[sorted[y].index] != positions[sorted[x].index]) y++;
+            vertexIds[sorted[x].index] = y < x ? vertexIds[sorted[y].index] : numIds++;
+        }
+    }
+    std::vector<glm::vec3>().swap(positions);
+    std::vector<RadixSortItem<uint64_t>>().swap(sorted);
+
+    // Runs of level edges between the same two vertex ids
+    out.edgeCluster.resize(numEdges);
+    for (uint32_t i = 0; i < numClusters; i++) {
+        std::fill(out.edgeCluster.begin() + out.edgeStarts[i], out.edgeCluster.begin() + out.edgeStarts[i + 1], i);
+    }
+    auto forEachEdge = [&](auto&& fn) {
+        for (uint32_t i = 0; i < numClusters; i++) {
+            const Cluster& c = clusters[levelClusters[i]];
+            const uint32_t* indices = geometry.clusterIndices(c);
+            const uint32_t* ids = vertexIds.data() + vertexStarts[i];
+            for (uint32_t s = 0; s < c.numTris * 3; s++) {
+                uint32_t a = ids[indices[s]], b = ids[indices[s - s % 3 + (s % 3 + 1) % 3]];
+                fn(out.edgeStarts[i] + s, std::min(a, b), std::max(a, b));
+            }
+        }
+    };
+    std::vector<uint32_t> bucketEnd;
+    std::vector<uint64_t> records;
+    out.runEdges.resize(numEdges);
+    out.runStarts.clear();
+    sortEdgeRuns(numIds, numEdges, forEachEdge, bucketEnd, records, [&](uint32_t begin, uint32_t end) {
+        out.runStarts.push_back(begin);
+        for (uint32_t i = begin; i < end; i++) out.runEdges[i] = (uint32_t)records[i];
+    });
+    out.runStarts.push_back(numEdges);
+}
+
+void findUnsharedEdges(const LevelAdjacency& adjacency, const std::vector<uint32_t>& clusterOwner,
+                       BitSet& outEdges)
+{
+    outEdges.assign(adjacency.numEdges(), false);
+    auto owner = [&](uint32_t x) { return clusterOwner[adjacency.edgeCluster[adjacency.runEdges[x]]]; };
+    for (size_t r = 0; r + 1 < adjacency.runStarts.size(); r++) {
+        uint32_t begin = adjacency.runStarts[r], end = adjacency.runStarts[r + 1];
+        for (uint32_t x = begin; x < end; x++) {
+            uint32_t y = begin;
+            while (y < end && (y == x || owner(y) != owner(x))) y++;
+            if (y == end) outEdges.set(adjacency.runEdges[x]);
+        }
+    }
+}
+
+void buildClusterGraph(const LevelAdjacency& adjacency, const std::vector<uint32_t>& nodeClusters,
+                       PartitionGraph& graph)
+{
+    uint32_t numNodes = (uint32_t)nodeClusters.size();
+    std::vector<uint32_t> clusterNode(adjacency.numClusters(), INVALID_INDEX);
+    for (uint32_t i = 0; i < numNodes; i++) clusterNode[nodeClusters[i]] = i;
+    auto node = [&](uint32_t x) { return clusterNode[adjacency.edgeCluster[adjacency.runEdges[x]]]; };
+
+    // One (lower node << 32 | higher node) key per shared edge; sorted, the
+    // length of each run of equal keys is the number of edges two nodes share
+    std::vector<RadixSortItem<uint64_t>> pairs;
+    for (size_t r = 0; r + 1 < adjacency.runStarts.size(); r++) {
+        uint32_t begin = adjacency.runStarts[r], end = adjacency.runStarts[r + 1];
+        if (end - begin < 2 || end - begin > MAX_EDGE_FAN) continue;
+        for (uint32_t x = begin; x < end; x++) {
+            for (uint32_t y = x + 1; y < end; y++) {
+                uint64_t a = node(x), b = node(y);
+                if (a == b || a == INVALID_INDEX || b == INVALID_INDEX) continue;
+                if (a > b) std::swap(a, b);
+                pairs.push_back({ (a << 32) | b, 0 });
+            }
+        }
+    }
+    radixSort(pairs);
+
+    auto forEachLink = [&](auto&& link) {
+        for (uint32_t i = 0; i + 1 < numNodes; i++) link(i, i + 1, LOCALITY_EDGE_WEIGHT);
+        for (size_t begin = 0, end; begin < pairs.size(); begin = end) {
+            for (end = begin + 1; end < pairs.size() && pairs[end].key == pairs[begin].key; end++) {}
+            link((uint32_t)(pairs[begin].key >> 32), (uint32_t)pairs[begin].key,
+                 (uint32_t)(end - begin) * SHARED_EDGE_WEIGHT);
+        }
+    };
+    buildPartitionGraph(numNodes, forEachLink, graph);
+}
+
+} // namespace nanite
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "cluster.h"
+#include "graph_partition.h"
+
+namespace nanite {
+
+// Edge adjacency between all clusters of one DAG level, built once per level
+// and shared by boundary detection, grouping and group-seam locking.
+//
+// The level's triangle edges are numbered cluster by cluster: edge slot s of
+// the i-th level cluster (triangle s / 3, from corner s % 3 to the next) is
+// level edge edgeStarts[i] + s. Vertices are matched across clusters by exact
+// position (simplification never moves a locked seam vertex), and the edges
+// between the same two positions form a run: run r is the level edges
+// runEdges[runStarts[r] .. runStarts[r + 1]).
+struct LevelAdjacency {
+    std::vector<uint32_t> edgeStarts;   // numClusters + 1
+    std::vector<uint32_t> edgeCluster;  // level edge -> level cluster
+    std::vector<uint32_t> runEdges;
+    std::vector<uint32_t> runStarts;    // numRuns + 1
+
+    uint32_t numClusters() const { return edgeStarts.empty() ? 0 : (uint32_t)edgeStarts.size() - 1; }
+    uint32_t numEdges() const { return (uint32_t)edgeCluster.size(); }
+};
+
+// Build the adjacency of clusters[levelClusters[i]] (level cluster i).
+void buildLevelAdjacency(const ClusterGeometryPool& geometry, const std::vector<Cluster>& clusters,
+                         const std::vector<uint32_t>& levelClusters, LevelAdjacency& out);
+
+// Flag the level edges that share their run with no other edge of the same
+// owner (clusterOwner[level cluster]). With every cluster its own owner
+// these are the clusters' boundary edges; with clusters owned by their
+// group, they are the seams a group keeps when it is simplified.
+void findUnsharedEdges(const LevelAdjacency& adjacency, const std::vector<uint32_t>& clusterOwner,
+                       BitSet& outEdges);
+
+// Graph over the level clusters for grouping (node i = level cluster
+// nodeClusters[i]): clusters are linked by the number of edges they share,
+// and consecutive nodes by a weak locality link, so clusters with no
+// neighbours still group by proximity when the nodes are spatially sorted.
+void buildClusterGraph(const LevelAdjacency& adjacency, const std::vector<uint32_t>& nodeClusters,
+                       PartitionGraph& graph);
+
+} // namespace nanite
@@ -76,11 +76,11 @@ struct EdgeCollapse {
     bool operator>(const EdgeCollapse& o) const { return cost > o.cost; }
 };
 
-float simplifyCluster(Cluster& cluster, uint32_t targetNumTris, bool lockBoundaryEdges) {
-    if (cluster.numTris <= targetNumTris) return 0.0f;
+float simplifyCluster(ClusterGeometry& cluster, uint32_t targetNumTris, bool lockBoundaryEdges) {
+    if (cluster.numTris() <= targetNumTris) return 0.0f;
 
     uint32_t numVerts = (uint32_t)cluster.vertices.size();
-    uint32_t numTris  = cluster.numTris;
+    uint32_t numTris  = cluster.numTris();
 
     // --- Step 1: Build per-vertex quadrics ---
     std::vector<Quadric> vertexQuadrics(numVerts);
@@ -370,8 +370,7 @@ float simplifyCluster(Cluster& cluster, uint32_t targetNumTris, bool lockBoundar
 
     cluster.vertices = std::move(newVerts);
     cluster.indices  = std::move(newIndices);
-    cluster.computeBoundsAndMetrics();
-    cluster.computeBoundaryEdges();
+    cluster.boundaryEdges.clear(); // no longer match the triangles
 
     // Convert quadric error to geometric distance
     return (float)std::sqrt(std::max(0.0, maxError));
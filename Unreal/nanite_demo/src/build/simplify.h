@@ -9,12 +9,13 @@ namespace nanite {
 // Returns the maximum geometric error introduced by the simplification.
 //
 // Parameters:
-//   cluster:            Modified in-place (vertices/indices reduced)
+//   cluster:            Modified in-place (vertices/indices reduced,
+//                       boundaryEdges cleared)
 //   targetNumTris:      Desired triangle count after simplification
 //   lockBoundaryEdges:  If true, boundary edges are never collapsed
 //                       (preserves cluster seams, matching UE5 behavior)
 float simplifyCluster(
-    Cluster& cluster,
+    ClusterGeometry& cluster,
     uint32_t targetNumTris,
     bool lockBoundaryEdges = true
 );
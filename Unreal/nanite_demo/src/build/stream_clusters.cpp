@@ -0,0 +1,594 @@
+#include "stream_clusters.h"
+#include "../core/mapped_file.h"
+#include "../core/obj_parser.h"
+#include "../core/flat_hash_map.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+
+namespace nanite {
+
+namespace fs = std::filesystem;
+
+// Rough heap cost of building one bucket triangle: its spill record, the
+// bucket RawMesh, sort keys, the dedup table and the clusters it ends up in.
+static constexpr size_t BUILD_BYTES_PER_TRI = 256;
+// Oversized buckets are split at most this many times (degenerate input
+// with coincident centroids cannot be split further).
+static constexpr int MAX_SPLIT_DEPTH = 12;
+
+// ---------- Temporary files ----------
+
+static bool seekFile(FILE* f, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(f, (long long)offset, SEEK_SET) == 0;
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// A spill file that is deleted when it goes out of scope.
+struct TempFile {
+    std::string path;
+    FILE*       file = nullptr;
+
+    bool create(const std::string& dir, const char* suffix) {
+        static std::atomic<uint32_t> counter{ 0 };
+        std::error_code ec;
+        fs::path base = dir.empty() ? fs::temp_directory_path(ec) : fs::path(dir);
+        auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        path = (base / ("nanite_stream_" + std::to_string(stamp) + "_" +
+                        std::to_string(counter++) + suffix)).string();
+        file = fopen(path.c_str(), "w+b");
+        if (!file) fprintf(stderr, "Error: Cannot create spill file '%s'\n", path.c_str());
+        return file != nullptr;
+    }
+    bool closeFile() {
+        bool ok = !file || fclose(file) == 0;
+        file = nullptr;
+        return ok;
+    }
+    ~TempFile() {
+        closeFile();
+        std::error_code ec;
+        if (!path.empty()) fs::remove(path, ec);
+    }
+};
+
+// ---------- OBJ windows ----------
+
+// Split the file into line-aligned windows of about `windowBytes`.
+static std::vector<const char*> splitWindows(const MappedFile& file, size_t windowBytes) {
+    std::vector<const char*> bounds = { file.begin() };
+    while (bounds.back() < file.end()) {
+        const char* p = bounds.back();
+        if ((size_t)(file.end() - p) <= windowBytes) {
+            bounds.push_back(file.end());
+            break;
+        }
+        const char* nl = static_cast<const char*>(memchr(p + windowBytes, '\n',
+                                                         (size_t)(file.end() - (p + windowBytes))));
+        bounds.push_back(nl ? nl + 1 : file.end());
+    }
+    return bounds;
+}
+
+// Parse one window. Absolute face indices are already global; relative ones
+// were resolved against the window's own elements and are shifted by the
+// positions / normals defined before the window.
+static void parseWindow(const char* begin, const char* end, uint64_t posBase, uint64_t normBase,
+                        uint32_t numThreads, ObjParseResult& out)
+{
+    out.clear();
+    parseOBJParallel(begin, end, out, numThreads);
+    for (uint32_t corner : out.relativePosCorners)  out.faceVerts[corner].v  += (uint32_t)posBase;
+    for (uint32_t corner : out.relativeNormCorners) out.faceVerts[corner].vn += (uint32_t)normBase;
+}
+
+// Call fn(a, b, c) for every fan triangle of the window's faces
+template<typename Fn>
+static void forEachTriangle(const ObjParseResult& obj, Fn&& fn) {
+    size_t faceStart = 0;
+    for (uint32_t faceSize : obj.faceSizes) {
+        const ObjFaceVert* face = &obj.faceVerts[faceStart];
+        faceStart += faceSize;
+        for (uint32_t i = 1; i + 1 < faceSize; i++) fn(face[0], face[i], face[i + 1]);
+    }
+}
+
+// ---------- Bucket spill ----------
+
+// One triangle with its final vertex data and dedup keys (v, vn) per corner
+struct TriRecord {
+    Vertex   corners[3];
+    uint64_t keys[3];
+
+    glm::vec3 centroid() const {
+        return (corners[0].position + corners[1].position + corners[2].position) / 3.0f;
+    }
+};
+
+struct BlockRef {
+    uint64_t offset;
+    uint32_t numTris;
+};
+
+struct Bucket {
+    std::vector<BlockRef> blocks;
+    uint64_t              numTris = 0;
+    AABB                  centroidBounds;
+};
+
+// Appends triangles to a set of buckets. Each bucket buffers up to
+// `blockTris` records, then writes them as one block at the end of the spill.
+class BucketWriter {
+public:
+    BucketWriter(FILE* spill, uint64_t& spillSize, size_t numBuckets, uint32_t blockTris)
+        : spill_(spill), spillSize_(spillSize), blockTris_(blockTris),
+          buckets_(numBuckets), buffers_(numBuckets) {}
+
+    void append(size_t bucket, const TriRecord& rec, const glm::vec3& centroid) {
+        std::vector<TriRecord>& buffer = buffers_[bucket];
+        if (buffer.capacity() == 0) buffer.reserve(blockTris_);
+        buffer.push_back(rec);
+        buckets_[bucket].numTris++;
+        buckets_[bucket].centroidBounds.expand(centroid);
+        if (buffer.size() == blockTris_) flush(bucket);
+    }
+
+    // Flush all partial blocks, release the buffers and hand out the buckets.
+    std::vector<Bucket> finish() {
+        for (size_t b = 0; b < buffers_.size(); b++) {
+            if (!buffers_[b].empty()) flush(b);
+            std::vector<TriRecord>().swap(buffers_[b]);
+        }
+        return std::move(buckets_);
+    }
+
+    bool ok() const { return ok_; }
+
+private:
+    FILE*                               spill_;
+    uint64_t&                           spillSize_;
+    uint32_t                            blockTris_;
+    std::vector<Bucket>                 buckets_;
+    std::vector<std::vector<TriRecord>> buffers_;
+    bool                                ok_ = true;
+
+    void flush(size_t bucket) {
+        std::vector<TriRecord>& buffer = buffers_[bucket];
+        ok_ = ok_ && seekFile(spill_, spillSize_) &&
+              fwrite(buffer.data(), sizeof(TriRecord), buffer.size(), spill_) == buffer.size();
+        buckets_[bucket].blocks.push_back({ spillSize_, (uint32_t)buffer.size() });
+        spillSize_ += buffer.size() * sizeof(TriRecord);
+        buffer.clear();
+    }
+};
+
+static bool readBlock(FILE* spill, const BlockRef& block, std::vector<TriRecord>& out) {
+    size_t base = out.size();
+    out.resize(base + block.numTris);
+    return seekFile(spill, block.offset) &&
+           fread(&out[base], sizeof(TriRecord), block.numTris, spill) == block.numTris;
+}
+
+// ---------- Streaming build ----------
+
+struct StreamContext {
+    const ClusterSink&        sink;
+    StreamBuildStats&         stats;
+    FILE*                     spill;
+    uint64_t&                 spillSize;
+    uint32_t                  blockTris;
+    uint64_t                  maxBucketTris;
+};
+
+// Deduplicate the bucket's corners into a RawMesh and cut it into clusters.
+static bool buildBucket(StreamContext& ctx, const Bucket& bucket) {
+    std::vector<TriRecord> recs;
+    recs.reserve((size_t)bucket.numTris);
+    for (const BlockRef& block : bucket.blocks) {
+        if (!readBlock(ctx.spill, block, recs)) return false;
+    }
+
+    RawMesh mesh;
+    FlatHashMap64 vertMap(recs.size());
+    mesh.indices.reserve(recs.size() * 3);
+    mesh.vertices.reserve(recs.size());
+    for (const TriRecord& rec : recs) {
+        for (int j = 0; j < 3; j++) {
+            bool inserted;
+            uint32_t idx = vertMap.findOrInsert(rec.keys[j], (uint32_t)mesh.vertices.size(), inserted);
+            mesh.indices.push_back(idx);
+            if (inserted) {
+                mesh.vertices.push_back(rec.corners[j]);
+                mesh.bounds.expand(rec.corners[j].position);
+            }
+        }
+    }
+    std::vector<TriRecord>().swap(recs);
+
+    std::vector<Cluster> clusters;
+    ClusterGeometryPool geometry;
+    buildLeafClusters(mesh, geometry, clusters);
+    for (const Cluster& c : clusters) ctx.sink(c, geometry);
+
+    ctx.stats.numClusters += clusters.size();
+    ctx.stats.numBuckets++;
+    ctx.stats.maxBucketTris = std::max<uint64_t>(ctx.stats.maxBucketTris, bucket.numTris);
+    return true;
+}
+
+// Build a bucket, first splitting it into octants of its centroid bounds
+// (children in Morton order) while it is larger than the budget allows.
+static bool processBucket(StreamContext& ctx, const Bucket& bucket, int depth) {
+    glm::vec3 extent = bucket.centroidBounds.max - bucket.centroidBounds.min;
+    bool canSplit = depth < MAX_SPLIT_DEPTH && (extent.x > 0.0f || extent.y > 0.0f || extent.z > 0.0f);
+    if (bucket.numTris <= ctx.maxBucketTris || !canSplit) {
+        if (bucket.numTris > ctx.maxBucketTris) {
+            fprintf(stderr, "Warning: Bucket of %llu triangles cannot be split below the memory budget\n",
+                    (unsigned long long)bucket.numTris);
+        }
+        return buildBucket(ctx, bucket);
+    }
+
+    glm::vec3 center = bucket.centroidBounds.center();
+    BucketWriter writer(ctx.spill, ctx.spillSize, 8, ctx.blockTris);
+    std::vector<TriRecord> block;
+    for (const BlockRef& ref : bucket.blocks) {
+        block.clear();
+        if (!readBlock(ctx.spill, ref, block)) return false;
+        for (const TriRecord& rec : block) {
+            glm::vec3 c = rec.centroid();
+            uint32_t octant = (c.x > center.x ? 1u : 0u) | (c.y > center.y ? 2u : 0u) | (c.z > center.z ? 4u : 0u);
+            writer.append(octant, rec, c);
+        }
+    }
+    std::vector<TriRecord>().swap(block);
+    std::vector<Bucket> children = writer.finish();
+    if (!writer.ok()) return false;
+    ctx.stats.numSplits++;
+
+    for (const Bucket& child : children) {
+        if (child.numTris > 0 && !processBucket(ctx, child, depth + 1)) return false;
+    }
+    return true;
+}
+
+bool buildLeafClustersStreaming(const std::string& objPath, const ClusterSink& sink,
+                                const StreamBuildOptions& options, StreamBuildStats* outStats)
+{
+    using Clock = std::chrono::high_resolution_clock;
+    auto secondsSince = [](Clock::time_point t) {
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    };
+
+    MappedFile file;
+    if (!file.open(objPath)) {
+        fprintf(stderr, "Error: Cannot open OBJ file '%s'\n", objPath.c_str());
+        return false;
+    }
+
+    StreamBuildStats stats;
+    size_t budget = std::max<size_t>(options.memoryBudget, 16u << 20);
+    size_t windowBytes = std::min<size_t>(std::max<size_t>(budget / 8, 1u << 20), 256u << 20);
+    std::vector<const char*> windows = splitWindows(file, windowBytes);
+    size_t numWindows = windows.size() - 1;
+    ObjParseResult obj;
+
+    // --- Pass 1: spill positions and normals, count triangles ---
+    auto passStart = Clock::now();
+    TempFile vertexSpill, normalSpill;
+    if (!vertexSpill.create(options.tempDir, ".vtx") || !normalSpill.create(options.tempDir, ".nrm"))
+        return false;
+
+    std::vector<uint64_t> posBase(numWindows + 1, 0), normBase(numWindows + 1, 0);
+    AABB bounds;
+    bool writeOk = true;
+    std::vector<Vertex> spillVerts;
+    for (size_t w = 0; w < numWindows; w++) {
+        parseWindow(windows[w], windows[w + 1], 0, 0, options.numThreads, obj);
+        posBase[w + 1]  = posBase[w]  + obj.positions.size();
+        normBase[w + 1] = normBase[w] + obj.normals.size();
+
+        spillVerts.resize(obj.positions.size());
+        for (size_t i = 0; i < obj.positions.size(); i++) {
+            spillVerts[i].position = obj.positions[i];
+            spillVerts[i].normal = glm::vec3(0.0f);
+            bounds.expand(obj.positions[i]);
+        }
+        // (fwrite must not be passed the null data() of an empty vector)
+        writeOk = writeOk && (spillVerts.empty() ||
+                  fwrite(spillVerts.data(), sizeof(Vertex), spillVerts.size(), vertexSpill.file) == spillVerts.size());
+        writeOk = writeOk && (obj.normals.empty() ||
+                  fwrite(obj.normals.data(), sizeof(glm::vec3), obj.normals.size(), normalSpill.file) == obj.normals.size());
+        for (uint32_t faceSize : obj.faceSizes) stats.numTriangles += faceSize - 2;
+        file.release(windows[w], windows[w + 1]);
+    }
+    std::vector<Vertex>().swap(spillVerts);
+    writeOk = vertexSpill.closeFile() && normalSpill.closeFile() && writeOk;
+
+    stats.numPositions = posBase[numWindows];
+    uint64_t numNormals = normBase[numWindows];
+    bool hasNormals = numNormals > 0;
+    if (!writeOk || stats.numPositions == 0 || stats.numTriangles == 0 ||
+        stats.numPositions >= INVALID_INDEX || numNormals >= INVALID_INDEX) {
+        fprintf(stderr, "Error: Cannot stream '%s' (%s)\n", objPath.c_str(),
+                !writeOk ? "spill write failed" : (stats.numPositions == 0 || stats.numTriangles == 0)
+                ? "no geometry" : "more than 2^32 vertices");
+        return false;
+    }
+    printf("  Stream scan: %llu positions, %llu normals, %llu triangles, %zu windows (%.2f s)\n",
+           (unsigned long long)stats.numPositions, (unsigned long long)numNormals,
+           (unsigned long long)stats.numTriangles, numWindows, secondsSince(passStart));
+
+    MappedFile vertexMap, normalMap;
+    if (!vertexMap.open(vertexSpill.path, hasNormals ? MapAccess::Random : MapAccess::ReadWrite) ||
+        (hasNormals && !normalMap.open(normalSpill.path, MapAccess::Random))) {
+        fprintf(stderr, "Error: Cannot map spill files for '%s'\n", objPath.c_str());
+        return false;
+    }
+    const Vertex*    spilled = reinterpret_cast<const Vertex*>(vertexMap.data());
+    const glm::vec3* normals = reinterpret_cast<const glm::vec3*>(normalMap.data());
+    uint32_t numPositions = (uint32_t)stats.numPositions;
+    uint64_t invalidTris = 0;
+
+    // --- Pass 2 (files without vn): accumulate smooth normals in the spill ---
+    // Same area-weighted sums, in the same order, as computeVertexNormals.
+    if (!hasNormals) {
+        passStart = Clock::now();
+        Vertex* verts = reinterpret_cast<Vertex*>(vertexMap.mutableData());
+        for (size_t w = 0; w < numWindows; w++) {
+            parseWindow(windows[w], windows[w + 1], posBase[w], normBase[w], options.numThreads, obj);
+            forEachTriangle(obj, [&](const ObjFaceVert& a, const ObjFaceVert& b, const ObjFaceVert& c) {
+                if (a.v >= numPositions || b.v >= numPositions || c.v >= numPositions) return;
+                const glm::vec3& p0 = verts[a.v].position;
+                glm::vec3 fn = glm::cross(verts[b.v].position - p0, verts[c.v].position - p0);
+                verts[a.v].normal += fn;
+                verts[b.v].normal += fn;
+                verts[c.v].normal += fn;
+            });
+            file.release(windows[w], windows[w + 1]);
+        }
+        printf("  Stream normals: accumulated in %.2f s\n", secondsSince(passStart));
+    }
+
+    // --- Pass 3: bucket triangles on a coarse grid ---
+    passStart = Clock::now();
+    TempFile bucketSpill;
+    if (!bucketSpill.create(options.tempDir, ".bkt")) return false;
+    uint64_t spillSize = 0;
+
+    // Surfaces cross about gridDim^2 cells of the grid; size the grid so those
+    // cells hold about half a bucket budget each.
+    uint64_t maxBucketTris = std::max<uint64_t>(budget / BUILD_BYTES_PER_TRI, DefaultClusterConfig::CLUSTER_SIZE * 16);
+    uint32_t gridDim = (uint32_t)std::ceil(std::sqrt(2.0 * (double)stats.numTriangles / (double)maxBucketTris));
+    gridDim = std::min(std::max(gridDim, 1u), 32u);
+    size_t numCells = (size_t)gridDim * gridDim * gridDim;
+    size_t occupiedCells = std::min<size_t>(numCells, (size_t)4 * gridDim * gridDim);
+    uint32_t blockTris = (uint32_t)std::min<size_t>(std::max<size_t>(
+        budget / 4 / occupiedCells / sizeof(TriRecord), 64), 65536);
+
+    glm::vec3 boundsMin = bounds.min;
+    glm::vec3 boundsSize = glm::max(bounds.max - bounds.min, glm::vec3(1e-8f));
+    BucketWriter grid(bucketSpill.file, spillSize, numCells, blockTris);
+    for (size_t w = 0; w < numWindows; w++) {
+        parseWindow(windows[w], windows[w + 1], posBase[w], normBase[w], options.numThreads, obj);
+        forEachTriangle(obj, [&](const ObjFaceVert& a, const ObjFaceVert& b, const ObjFaceVert& c) {
+            const ObjFaceVert tri[3] = { a, b, c };
+            if (a.v >= numPositions || b.v >= numPositions || c.v >= numPositions) {
+                invalidTris++;
+                return;
+            }
+            TriRecord rec;
+            for (int j = 0; j < 3; j++) {
+                const Vertex& sv = spilled[tri[j].v];
+                rec.corners[j].position = sv.position;
+                if (!hasNormals) {
+                    float len = glm::length(sv.normal);
+                    rec.corners[j].normal = (len > 1e-8f) ? sv.normal / len : glm::vec3(0, 1, 0);
+                } else if (tri[j].vn != INVALID_INDEX && tri[j].vn < numNormals) {
+                    rec.corners[j].normal = normals[tri[j].vn];
+                } else {
+                    rec.corners[j].normal = glm::vec3(0, 1, 0); // placeholder, as in triangulateOBJ
+                }
+                rec.keys[j] = ((uint64_t)tri[j].v << 32) | tri[j].vn;
+            }
+            glm::vec3 centroid = rec.centroid();
+            glm::vec3 cell = glm::clamp((centroid - boundsMin) / boundsSize * (float)gridDim,
+                                        glm::vec3(0.0f), glm::vec3((float)gridDim - 1.0f));
+            size_t cellIndex = ((size_t)cell.z * gridDim + (size_t)cell.y) * gridDim + (size_t)cell.x;
+            grid.append(cellIndex, rec, centroid);
+        });
+        file.release(windows[w], windows[w + 1]);
+    }
+    std::vector<Bucket> cells = grid.finish();
+    obj = ObjParseResult();
+    if (!grid.ok()) {
+        fprintf(stderr, "Error: Bucket spill write failed for '%s'\n", objPath.c_str());
+        return false;
+    }
+    if (invalidTris > 0) {
+        fprintf(stderr, "Warning: Skipped %llu triangles with out-of-range indices\n",
+                (unsigned long long)invalidTris);
+    }
+    printf("  Stream bucket: %u^3 grid, %u-triangle blocks, %.1f MB spilled (%.2f s)\n",
+           gridDim, blockTris, spillSize / 1e6, secondsSince(passStart));
+
+    // --- Pass 4: build buckets in Morton order of their cells ---
+    passStart = Clock::now();
+    std::vector<std::pair<uint32_t, uint32_t>> cellOrder; // (morton code, cell index)
+    for (uint32_t i = 0; i < (uint32_t)numCells; i++) {
+        if (cells[i].numTris == 0) continue;
+        glm::vec3 c((float)(i % gridDim), (float)((i / gridDim) % gridDim), (float)(i / (gridDim * gridDim)));
+        cellOrder.push_back({ mortonEncode((c + 0.5f) / (float)gridDim), i });
+    }
+    std::sort(cellOrder.begin(), cellOrder.end());
+
+    StreamContext ctx = { sink, stats, bucketSpill.file, spillSize, blockTris, maxBucketTris };
+    for (const auto& entry : cellOrder) {
+        if (!processBucket(ctx, cells[entry.second], 0)) {
+            fprintf(stderr, "Error: Bucket spill read failed for '%s'\n", objPath.c_str());
+            return false;
+        }
+        std::vector<BlockRef>().swap(cells[entry.second].blocks);
+    }
+    stats.spillBytes = spillSize;
+    printf("  Stream build: %llu clusters from %llu buckets (%llu splits, largest %llu triangles) (%.2f s)\n",
+           (unsigned long long)stats.numClusters, (unsigned long long)stats.numBuckets,
+           (unsigned long long)stats.numSplits, (unsigned long long)stats.maxBucketTris,
+           secondsSince(passStart));
+
+    if (outStats) *outStats = stats;
+    return true;
+}
+
+// ---------- Cluster file ----------
+
+struct NClustersHeader {
+    char     magic[4];          // "NCLS"
+    uint32_t version;
+    uint32_t vertexStride;      // sizeof(Vertex) when written
+    uint32_t reserved;
+    uint64_t clusterCount;      // patched by ClusterFileWriter::close
+};
+
+struct ClusterRecordHeader {
+    uint32_t       numVertices;
+    uint32_t       numTris;
+    int32_t        mipLevel;
+    float          lodError;
+    float          edgeLength;
+    float          surfaceArea;
+    AABB           bounds;
+    BoundingSphere sphereBounds;
+    BoundingSphere lodBounds;
+    NormalCone     normalCone;
+    uint32_t       groupIndex;
+    uint32_t       generatingGroupIndex;
+};
+
+static constexpr char NCLUSTERS_MAGIC[4] = { 'N', 'C', 'L', 'S' };
+
+ClusterFileWriter::~ClusterFileWriter() {
+    close();
+}
+
+bool ClusterFileWriter::open(const std::string& path) {
+    close();
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        fprintf(stderr, "Error: Cannot write cluster file '%s'\n", path.c_str());
+        return false;
+    }
+    NClustersHeader header = {};
+    memcpy(header.magic, NCLUSTERS_MAGIC, 4);
+    header.version = NCLUSTERS_VERSION;
+    header.vertexStride = sizeof(Vertex);
+    count_ = 0;
+    ok_ = fwrite(&header, sizeof(header), 1, file_) == 1;
+    return ok_;
+}
+
+bool ClusterFileWriter::write(const Cluster& c, const ClusterGeometryPool& geometry) {
+    if (!file_) return false;
+    ClusterRecordHeader rec = {};
+    rec.numVertices = c.numVertices;
+    rec.numTris = c.numTris;
+    rec.mipLevel = c.mipLevel;
+    rec.lodError = c.lodError;
+    rec.edgeLength = c.edgeLength;
+    rec.surfaceArea = c.surfaceArea;
+    rec.bounds = c.bounds;
+    rec.sphereBounds = c.sphereBounds;
+    rec.lodBounds = c.lodBounds;
+    rec.normalCone = c.normalCone;
+    rec.groupIndex = c.groupIndex;
+    rec.generatingGroupIndex = c.generatingGroupIndex;
+
+    std::vector<uint8_t> boundary(rec.numTris * 3, 0);
+    for (uint32_t i = 0; i < (uint32_t)boundary.size(); i++) boundary[i] = geometry.isBoundaryEdge(c, i);
+
+    ok_ = ok_ && fwrite(&rec, sizeof(rec), 1, file_) == 1;
+    ok_ = ok_ && fwrite(geometry.clusterVertices(c), sizeof(Vertex), c.numVertices, file_) == c.numVertices;
+    ok_ = ok_ && fwrite(geometry.clusterIndices(c), sizeof(uint32_t), rec.numTris * 3, file_) == rec.numTris * 3;
+    ok_ = ok_ && fwrite(boundary.data(), 1, boundary.size(), file_) == boundary.size();
+    count_++;
+    return ok_;
+}
+
+bool ClusterFileWriter::close() {
+    if (!file_) return ok_;
+    ok_ = ok_ && fseek(file_, offsetof(NClustersHeader, clusterCount), SEEK_SET) == 0 &&
+          fwrite(&count_, sizeof(count_), 1, file_) == 1;
+    ok_ = (fclose(file_) == 0) && ok_;
+    file_ = nullptr;
+    if (!ok_) fprintf(stderr, "Error: Failed to write cluster file\n");
+    return ok_;
+}
+
+bool readClusterFile(const std::string& path, ClusterGeometryPool& outGeometry,
+                     std::vector<Cluster>& outClusters)
+{
+    MappedFile file;
+    if (!file.open(path)) {
+        fprintf(stderr, "Error: Cannot open cluster file '%s'\n", path.c_str());
+        return false;
+    }
+    NClustersHeader header;
+    if (file.size() < sizeof(header)) return false;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, NCLUSTERS_MAGIC, 4) != 0 || header.version != NCLUSTERS_VERSION ||
+        header.vertexStride != sizeof(Vertex)) {
+        fprintf(stderr, "Error: '%s' is not a version %u cluster file\n", path.c_str(), NCLUSTERS_VERSION);
+        return false;
+    }
+
+    const char* p = file.data() + sizeof(header);
+    const char* end = file.end();
+    outClusters.reserve(outClusters.size() + (size_t)header.clusterCount);
+    for (uint64_t i = 0; i < header.clusterCount; i++) {
+        ClusterRecordHeader rec;
+        if ((size_t)(end - p) < sizeof(rec)) return false;
+        memcpy(&rec, p, sizeof(rec));
+        p += sizeof(rec);
+        size_t payload = (size_t)rec.numVertices * sizeof(Vertex) + (size_t)rec.numTris * 3 * (sizeof(uint32_t) + 1);
+        if ((size_t)(end - p) < payload) {
+            fprintf(stderr, "Error: Cluster file '%s' is truncated\n", path.c_str());
+            return false;
+        }
+
+        Cluster c;
+        uint32_t numIndices = rec.numTris * 3;
+        c.vertexOffset = (uint32_t)outGeometry.vertices.size();
+        c.numVertices = rec.numVertices;
+        c.indexOffset = (uint32_t)outGeometry.indices.size();
+        outGeometry.vertices.resize(c.vertexOffset + rec.numVertices);
+        outGeometry.indices.resize(c.indexOffset + numIndices);
+        outGeometry.boundaryEdges.resize(c.indexOffset + numIndices);
+        memcpy(&outGeometry.vertices[c.vertexOffset], p, rec.numVertices * sizeof(Vertex));
+        p += rec.numVertices * sizeof(Vertex);
+        memcpy(&outGeometry.indices[c.indexOffset], p, numIndices * sizeof(uint32_t));
+        p += numIndices * sizeof(uint32_t);
+        for (uint32_t e = 0; e < numIndices; e++) outGeometry.boundaryEdges.set(c.indexOffset + e, p[e] != 0);
+        p += numIndices;
+
+        c.numTris = rec.numTris;
+        c.mipLevel = rec.mipLevel;
+        c.lodError = rec.lodError;
+        c.edgeLength = rec.edgeLength;
+        c.surfaceArea = rec.surfaceArea;
+        c.bounds = rec.bounds;
+        c.sphereBounds = rec.sphereBounds;
+        c.lodBounds = rec.lodBounds;
+        c.normalCone = rec.normalCone;
+        c.groupIndex = rec.groupIndex;
+        c.generatingGroupIndex = rec.generatingGroupIndex;
+        outClusters.push_back(std::move(c));
+    }
+    return true;
+}
+
+} // namespace nanite
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "cluster.h"
+#include <cstdio>
+#include <functional>
+#include <string>
+
+namespace nanite {
+
+// Out-of-core leaf cluster construction for OBJ files too large for a RawMesh.
+//
+// 1. Scan: the file is parsed in bounded windows; positions (and normals) are
+//    spilled to temporary files that are memory-mapped for lookups.
+// 2. Bucket: triangles are streamed into a coarse spatial grid, each bucket a
+//    chain of fixed-size blocks in one spill file.
+// 3. Build: buckets are visited in Morton order. A bucket larger than the
+//    budget is split into octants (streamed, never loaded whole); the others
+//    are deduplicated into a small RawMesh and cut with buildLeafClusters.
+// 4. Emit: every finished cluster is handed to a sink and then dropped.
+//
+// Heap use is bounded by `memoryBudget`, not by mesh size. The vertex spill
+// (24 bytes per position) is reached through a file mapping, so the OS pages
+// it in and out as needed.
+struct StreamBuildOptions {
+    size_t      memoryBudget = size_t(1) << 30; // bytes of working memory
+    std::string tempDir;                        // spill files; empty = system temp dir
+    uint32_t    numThreads = 0;                 // threads for parsing (0 = all workers)
+};
+
+struct StreamBuildStats {
+    uint64_t numPositions  = 0;
+    uint64_t numTriangles  = 0;
+    uint64_t numClusters   = 0;
+    uint64_t numBuckets    = 0;     // buckets built (after splitting)
+    uint64_t numSplits     = 0;     // oversized buckets split into octants
+    uint64_t maxBucketTris = 0;
+    uint64_t spillBytes    = 0;     // total bytes written to the bucket spill
+};
+
+// Receives each finished leaf cluster and the pool holding its geometry.
+// Clusters arrive in spatial (Morton) order and are destroyed after the call
+// returns.
+using ClusterSink = std::function<void(const Cluster&, const ClusterGeometryPool&)>;
+
+// Stream the OBJ file at `objPath` into leaf clusters with buildLeafClusters
+// semantics (Morton-sorted runs of DefaultClusterConfig::CLUSTER_SIZE
+// triangles, per-cluster boundary edges). Unlike the in-memory build,
+// clusters never span a bucket border, so the last cluster of each bucket
+// may be partially filled.
+// Returns false on error.
+bool buildLeafClustersStreaming(const std::string& objPath, const ClusterSink& sink,
+                                const StreamBuildOptions& options = {},
+                                StreamBuildStats* outStats = nullptr);
+
+// Cluster file (.nclusters): a header followed by one record per cluster
+// (scalar fields, vertices, local indices, boundary edge flags).
+constexpr uint32_t NCLUSTERS_VERSION = 2;   // 2: normal cones
+
+// Sequential writer; usable as a ClusterSink via
+// [&](const Cluster& c, const ClusterGeometryPool& g) { writer.write(c, g); }
+class ClusterFileWriter {
+public:
+    ClusterFileWriter() = default;
+    ~ClusterFileWriter();
+
+    ClusterFileWriter(const ClusterFileWriter&) = delete;
+    ClusterFileWriter& operator=(const ClusterFileWriter&) = delete;
+
+    bool open(const std::string& path);
+    bool write(const Cluster& cluster, const ClusterGeometryPool& geometry);
+    // Patch the cluster count into the header and close. Returns false if
+    // any write failed.
+    bool close();
+
+    uint64_t numClusters() const { return count_; }
+
+private:
+    FILE*    file_  = nullptr;
+    uint64_t count_ = 0;
+    bool     ok_    = true;
+};
+
+// Read every cluster of a .nclusters file, appending their geometry to
+// outGeometry. Returns false on error.
+bool readClusterFile(const std::string& path, ClusterGeometryPool& outGeometry,
+                     std::vector<Cluster>& outClusters);
+
+} // namespace nanite
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace nanite {
+
+// Dynamically sized bit array packed into 64-bit words, for per-edge and
+// per-vertex flags. Unlike std::vector<bool> it exposes its words, so
+// whole-array operations (clear, count) run a word at a time.
+class BitSet {
+public:
+    BitSet() = default;
+    explicit BitSet(size_t count, bool value = false) { assign(count, value); }
+
+    void assign(size_t count, bool value) {
+        size_ = count;
+        words_.assign((count + 63) / 64, value ? ~0ull : 0ull);
+        trimLastWord();
+    }
+    void clear() { assign(0, false); }
+    // Keeps the first min(size(), count) bits; new bits are zero.
+    void resize(size_t count) {
+        size_ = count;
+        words_.resize((count + 63) / 64, 0ull);
+        trimLastWord();
+    }
+    void reserve(size_t count) { words_.reserve((count + 63) / 64); }
+
+    size_t size() const { return size_; }
+    bool   empty() const { return size_ == 0; }
+
+    bool operator[](size_t i) const { return (words_[i >> 6] >> (i & 63)) & 1; }
+    void set(size_t i)   { words_[i >> 6] |= 1ull << (i & 63); }
+    void reset(size_t i) { words_[i >> 6] &= ~(1ull << (i & 63)); }
+    void set(size_t i, bool value) { value ? set(i) : reset(i); }
+
+    // Number of set bits.
+    size_t count() const {
+        size_t n = 0;
+        for (uint64_t w : words_) n += popcount(w);
+        return n;
+    }
+
+    const std::vector<uint64_t>& words() const { return words_; }
+
+private:
+    std::vector<uint64_t> words_;
+    size_t                size_ = 0;
+
+    static size_t popcount(uint64_t w) {
+        w = w - ((w >> 1) & 0x5555555555555555ull);
+        w = (w & 0x3333333333333333ull) + ((w >> 2) & 0x3333333333333333ull);
+        w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+        return (size_t)((w * 0x0101010101010101ull) >> 56);
+    }
+
+    // Bits past size() stay zero so count() and words() need no masking.
+    void trimLastWord() {
+        if (size_ & 63) words_.back() &= (1ull << (size_ & 63)) - 1;
+    }
+};
+
+} // namespace nanite
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+namespace nanite {
+
+// Open-addressing hash map from 64-bit keys to 32-bit values (linear probing).
+//
+// Keys and values live in two flat arrays (12 bytes per slot, no per-entry
+// allocation), so a pre-sized table costs a single allocation and a lookup
+// touches one or two cache lines. ~0 marks empty slots; an entry with that key
+// (e.g. a packed (INVALID_INDEX, INVALID_INDEX) pair) is kept outside the table.
+class FlatHashMap64 {
+public:
+    static constexpr uint64_t EMPTY_KEY = ~0ull;
+
+    FlatHashMap64() = default;
+    explicit FlatHashMap64(size_t expectedCount) { reserve(expectedCount); }
+
+    // Size the table for `expectedCount` entries without rehashing.
+    void reserve(size_t expectedCount) {
+        size_t needed = expectedCount + expectedCount / 2 + 1; // max load ~2/3
+        if (needed <= keys.size()) return;
+        size_t capacity = 16;
+        while (capacity < needed) capacity <<= 1;
+        rehash(capacity);
+    }
+
+    void clear() {
+        std::fill(keys.begin(), keys.end(), EMPTY_KEY);
+        count = 0;
+        hasEmptyKey = false;
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return keys.size(); }
+    size_t memoryBytes() const { return keys.capacity() * sizeof(uint64_t) + values.capacity() * sizeof(uint32_t); }
+
+    // Return the value stored for `key`, inserting `value` first if the key is new.
+    // `inserted` reports which case happened. One probe sequence either way.
+    uint32_t findOrInsert(uint64_t key, uint32_t value, bool& inserted) {
+        if (key == EMPTY_KEY) {
+            inserted = !hasEmptyKey;
+            if (inserted) {
+                hasEmptyKey = true;
+                emptyKeyValue = value;
+                count++;
+            }
+            return emptyKeyValue;
+        }
+        if ((count + 1) * 3 > keys.size() * 2) rehash(keys.empty() ? 16 : keys.size() * 2);
+        size_t mask = keys.size() - 1;
+        for (size_t slot = hash(key) & mask;; slot = (slot + 1) & mask) {
+            if (keys[slot] == key) {
+                inserted = false;
+                return values[slot];
+            }
+            if (keys[slot] == EMPTY_KEY) {
+                keys[slot] = key;
+                values[slot] = value;
+                count++;
+                inserted = true;
+                return value;
+            }
+        }
+    }
+
+    // Pointer to the value stored for `key`, or nullptr.
+    const uint32_t* find(uint64_t key) const {
+        if (key == EMPTY_KEY) return hasEmptyKey ? &emptyKeyValue : nullptr;
+        if (keys.empty()) return nullptr;
+        size_t mask = keys.size() - 1;
+        for (size_t slot = hash(key) & mask;; slot = (slot + 1) & mask) {
+            if (keys[slot] == key) return &values[slot];
+            if (keys[slot] == EMPTY_KEY) return nullptr;
+        }
+    }
+
+    // 64-bit finalizer (MurmurHash3 fmix64): spreads structured keys such as
+    // packed index pairs or quantized coordinates over all table bits.
+    static uint64_t hash(uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdull;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ull;
+        k ^= k >> 33;
+        return k;
+    }
+
+private:
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> values;
+    size_t                count = 0;
+    bool                  hasEmptyKey = false; // entry for key EMPTY_KEY, counted in count
+    uint32_t              emptyKeyValue = 0;
+
+    void rehash(size_t newCapacity) {
+        std::vector<uint64_t> oldKeys = std::move(keys);
+        std::vector<uint32_t> oldValues = std::move(values);
+        keys.assign(newCapacity, EMPTY_KEY);
+        values.assign(newCapacity, 0);
+        count = hasEmptyKey ? 1 : 0;
+        for (size_t i = 0; i < oldKeys.size(); i++) {
+            if (oldKeys[i] == EMPTY_KEY) continue;
+            bool inserted;
+            findOrInsert(oldKeys[i], oldValues[i], inserted);
+        }
+    }
+};
+
+} // namespace nanite
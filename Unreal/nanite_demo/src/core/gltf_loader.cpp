@@ -0,0 +1,386 @@
+#include "mesh_loader.h"
+#include "mapped_file.h"
+#include "parallel.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+namespace nanite {
+
+// ---------- Minimal JSON ----------
+
+// Just enough JSON for a glTF scene description: objects, arrays, numbers,
+// strings (escapes other than \" \\ \/ are kept verbatim), true/false/null.
+struct JsonValue {
+    enum class Type : uint8_t { Null, Bool, Number, String, Array, Object };
+    Type                                         type = Type::Null;
+    double                                       number = 0.0;
+    std::string                                  string;
+    std::vector<JsonValue>                       array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    const JsonValue* get(const char* key) const {
+        for (const auto& kv : object)
+            if (kv.first == key) return &kv.second;
+        return nullptr;
+    }
+    const JsonValue* at(size_t i) const { return i < array.size() ? &array[i] : nullptr; }
+    // Array elements of `key`, or an empty list
+    const std::vector<JsonValue>& getArray(const char* key) const {
+        static const std::vector<JsonValue> empty;
+        const JsonValue* v = get(key);
+        return (v && v->type == Type::Array) ? v->array : empty;
+    }
+    double getNumber(const char* key, double fallback) const {
+        const JsonValue* v = get(key);
+        return (v && v->type == Type::Number) ? v->number : fallback;
+    }
+};
+
+struct JsonParser {
+    const char* p;
+    const char* end;
+
+    void skipWhitespace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    }
+
+    bool parseString(std::string& out) {
+        if (p >= end || *p != '"') return false;
+        p++;
+        while (p < end && *p != '"') {
+            if (*p == '\\' && p + 1 < end) {
+                p++;
+                if (*p != '"' && *p != '\\' && *p != '/') out.push_back('\\');
+            }
+            out.push_back(*p++);
+        }
+        if (p >= end) return false;
+        p++;
+        return true;
+    }
+
+    bool parseValue(JsonValue& v, int depth) {
+        if (depth > 64) return false;
+        skipWhitespace();
+        if (p >= end) return false;
+        char c = *p;
+        if (c == '{') {
+            v.type = JsonValue::Type::Object;
+            p++;
+            skipWhitespace();
+            if (p < end && *p == '}') { p++; return true; }
+            while (true) {
+                skipWhitespace();
+                std::pair<std::string, JsonValue> kv;
+                if (!parseString(kv.first)) return false;
+                skipWhitespace();
+                if (p >= end || *p != ':') return false;
+                p++;
+                if (!parseValue(kv.second, depth + 1)) return false;
+                v.object.push_back(std::move(kv));
+                skipWhitespace();
+                if (p < end && *p == ',') { p++; continue; }
+                if (p < end && *p == '}') { p++; return true; }
+                return false;
+            }
+        }
+        if (c == '[') {
+            v.type = JsonValue::Type::Array;
+            p++;
+            skipWhitespace();
+            if (p < end && *p == ']') { p++; return true; }
+            while (true) {
+                v.array.emplace_back();
+                if (!parseValue(v.array.back(), depth + 1)) return false;
+                skipWhitespace();
+                if (p < end && *p == ',') { p++; continue; }
+                if (p < end && *p == ']') { p++; return true; }
+                return false;
+            }
+        }
+        if (c == '"') {
+            v.type = JsonValue::Type::String;
+            return parseString(v.string);
+        }
+        if (c == 't' || c == 'f' || c == 'n') {
+            const char* word = (c == 't') ? "true" : (c == 'f') ? "false" : "null";
+            size_t len = strlen(word);
+            if ((size_t)(end - p) < len || memcmp(p, word, len) != 0) return false;
+            p += len;
+            v.type = (c == 'n') ? JsonValue::Type::Null : JsonValue::Type::Bool;
+            v.number = (c == 't') ? 1.0 : 0.0;
+            return true;
+        }
+        // Number: strtod needs a terminated string
+        char buf[64];
+        size_t len = 0;
+        while (p + len < end && len < sizeof(buf) - 1 && strchr("+-.0123456789eE", p[len])) len++;
+        if (len == 0) return false;
+        memcpy(buf, p, len);
+        buf[len] = '\0';
+        v.type = JsonValue::Type::Number;
+        v.number = strtod(buf, nullptr);
+        p += len;
+        return true;
+    }
+};
+
+// ---------- Accessors ----------
+
+static constexpr uint32_t GLB_MAGIC       = 0x46546C67; // "glTF"
+static constexpr uint32_t GLB_CHUNK_JSON  = 0x4E4F534A; // "JSON"
+static constexpr uint32_t GLB_CHUNK_BIN   = 0x004E4942; // "BIN\0"
+
+// componentType / mode enums (same values as the GL constants)
+static constexpr int GLTF_UNSIGNED_BYTE  = 5121;
+static constexpr int GLTF_UNSIGNED_SHORT = 5123;
+static constexpr int GLTF_UNSIGNED_INT   = 5125;
+static constexpr int GLTF_FLOAT          = 5126;
+static constexpr int GLTF_TRIANGLES      = 4;
+
+// An accessor resolved to a pointer into the mapped BIN chunk
+struct GltfView {
+    const char* data   = nullptr;
+    uint32_t    count  = 0;
+    uint32_t    stride = 0;      // bytes between elements
+    int         componentType = 0;
+    bool        hasBounds = false;
+    glm::vec3   min = glm::vec3(0.0f), max = glm::vec3(0.0f);
+};
+
+static uint32_t componentSize(int componentType) {
+    switch (componentType) {
+    case 5120: case 5121: return 1;
+    case 5122: case 5123: return 2;
+    case 5125: case 5126: return 4;
+    default: return 0;
+    }
+}
+
+// Resolve accessor `index` of the given element type ("VEC3", "SCALAR") and
+// check that every element lies inside the BIN chunk.
+static bool resolveAccessor(const JsonValue& doc, double index, const char* type,
+                            const char* bin, size_t binSize, GltfView& view)
+{
+    const JsonValue* accessors = doc.get("accessors");
+    const JsonValue* acc = (accessors && index >= 0) ? accessors->at((size_t)index) : nullptr;
+    if (!acc) return false;
+    const JsonValue* accType = acc->get("type");
+    if (!accType || accType->string != type || acc->get("sparse")) return false;
+
+    int numComponents = (strcmp(type, "VEC3") == 0) ? 3 : 1;
+    view.componentType = (int)acc->getNumber("componentType", 0);
+    view.count = (uint32_t)acc->getNumber("count", 0);
+    uint32_t elemSize = componentSize(view.componentType) * numComponents;
+    if (elemSize == 0) return false;
+
+    const JsonValue* views = doc.get("bufferViews");
+    double viewIndex = acc->getNumber("bufferView", -1);
+    const JsonValue* bv = (views && viewIndex >= 0) ? views->at((size_t)viewIndex) : nullptr;
+    if (!bv || bv->getNumber("buffer", 0) != 0) return false; // only the GLB BIN buffer
+
+    size_t viewOffset = (size_t)bv->getNumber("byteOffset", 0);
+    size_t viewLength = (size_t)bv->getNumber("byteLength", 0);
+    size_t accOffset  = (size_t)acc->getNumber("byteOffset", 0);
+    view.stride = (uint32_t)bv->getNumber("byteStride", 0);
+    if (view.stride == 0) view.stride = elemSize;
+
+    if (viewOffset + viewLength > binSize || view.stride < elemSize) return false;
+    if (view.count > 0 && accOffset + (size_t)(view.count - 1) * view.stride + elemSize > viewLength)
+        return false;
+    view.data = bin + viewOffset + accOffset;
+
+    const JsonValue* mn = acc->get("min");
+    const JsonValue* mx = acc->get("max");
+    if (numComponents == 3 && mn && mx && mn->array.size() == 3 && mx->array.size() == 3) {
+        view.hasBounds = true;
+        for (int i = 0; i < 3; i++) {
+            view.min[i] = (float)mn->array[i].number;
+            view.max[i] = (float)mx->array[i].number;
+        }
+    }
+    return true;
+}
+
+// ---------- Loader ----------
+
+struct GltfPrimitive {
+    GltfView position;
+    GltfView normal;          // data == nullptr if absent (normals are generated)
+    GltfView indices;         // data == nullptr if not indexed
+    size_t   vertexBase = 0;  // destination offsets in the merged RawMesh
+    size_t   indexBase  = 0;
+    uint32_t numIndices() const { return indices.data ? indices.count : position.count; }
+    bool hasNormals() const { return normal.data != nullptr; }
+};
+
+// Generate smooth normals for the slice of `mesh` that `prim` was copied to,
+// leaving the rest of the mesh (and its authored normals) untouched.
+static void generatePrimitiveNormals(const GltfPrimitive& prim, RawMesh& mesh) {
+    RawMesh slice;
+    slice.vertices.assign(mesh.vertices.begin() + prim.vertexBase,
+                          mesh.vertices.begin() + prim.vertexBase + prim.position.count);
+    slice.indices.resize(prim.numIndices());
+    uint32_t base = (uint32_t)prim.vertexBase;
+    for (size_t i = 0; i < slice.indices.size(); i++) slice.indices[i] = mesh.indices[prim.indexBase + i] - base;
+    computeVertexNormals(slice);
+    for (size_t i = 0; i < slice.vertices.size(); i++) mesh.vertices[prim.vertexBase + i].normal = slice.vertices[i].normal;
+}
+
+static void copyPrimitive(const GltfPrimitive& prim, RawMesh& outMesh) {
+    Vertex* dst = &outMesh.vertices[prim.vertexBase];
+    const GltfView& pos = prim.position;
+    const GltfView& nrm = prim.normal;
+
+    // Interleaved position+normal with a 24-byte stride is already `Vertex`
+    if (nrm.data && pos.stride == sizeof(Vertex) && nrm.stride == sizeof(Vertex) &&
+        nrm.data == pos.data + sizeof(glm::vec3)) {
+        memcpy(dst, pos.data, (size_t)pos.count * sizeof(Vertex));
+    } else {
+        for (uint32_t i = 0; i < pos.count; i++)
+            memcpy(&dst[i].position, pos.data + (size_t)i * pos.stride, sizeof(glm::vec3));
+        if (nrm.data) {
+            for (uint32_t i = 0; i < pos.count; i++)
+                memcpy(&dst[i].normal, nrm.data + (size_t)i * nrm.stride, sizeof(glm::vec3));
+        } else {
+            for (uint32_t i = 0; i < pos.count; i++) dst[i].normal = glm::vec3(0, 1, 0);
+        }
+    }
+
+    uint32_t* idx = &outMesh.indices[prim.indexBase];
+    uint32_t base = (uint32_t)prim.vertexBase;
+    const GltfView& ind = prim.indices;
+    if (!ind.data) {
+        for (uint32_t i = 0; i < pos.count; i++) idx[i] = base + i;
+    } else if (ind.componentType == GLTF_UNSIGNED_INT) {
+        if (ind.stride == 4) memcpy(idx, ind.data, (size_t)ind.count * 4);
+        else for (uint32_t i = 0; i < ind.count; i++) memcpy(&idx[i], ind.data + (size_t)i * ind.stride, 4);
+        if (base != 0) for (uint32_t i = 0; i < ind.count; i++) idx[i] += base;
+    } else if (ind.componentType == GLTF_UNSIGNED_SHORT) {
+        for (uint32_t i = 0; i < ind.count; i++) {
+            uint16_t v;
+            memcpy(&v, ind.data + (size_t)i * ind.stride, 2);
+            idx[i] = base + v;
+        }
+    } else {
+        for (uint32_t i = 0; i < ind.count; i++)
+            idx[i] = base + (uint8_t)ind.data[(size_t)i * ind.stride];
+    }
+
+    // Out-of-range indices would crash the DAG build; point them at vertex 0
+    for (uint32_t i = 0; i < prim.numIndices(); i++) {
+        if (idx[i] - base >= pos.count) idx[i] = base;
+    }
+}
+
+bool loadGLB(const std::string& filepath, RawMesh& outMesh) {
+    MappedFile file;
+    if (!file.open(filepath)) {
+        fprintf(stderr, "Error: Cannot open glTF file '%s'\n", filepath.c_str());
+        return false;
+    }
+
+    // Header: magic, version, total length; then JSON and BIN chunks
+    uint32_t header[5] = {};
+    if (file.size() >= sizeof(header)) memcpy(header, file.data(), sizeof(header));
+    if (header[0] != GLB_MAGIC || header[1] != 2 || header[2] > file.size() ||
+        header[4] != GLB_CHUNK_JSON || 20 + (size_t)header[3] > header[2]) {
+        fprintf(stderr, "Error: '%s' is not a glTF 2.0 binary (.glb) file\n", filepath.c_str());
+        return false;
+    }
+    const char* json = file.data() + 20;
+    size_t jsonSize = header[3];
+
+    const char* bin = nullptr;
+    size_t binSize = 0;
+    size_t binChunk = 20 + jsonSize;
+    if (binChunk + 8 <= header[2]) {
+        uint32_t chunk[2];
+        memcpy(chunk, file.data() + binChunk, 8);
+        if (chunk[1] == GLB_CHUNK_BIN && binChunk + 8 + (size_t)chunk[0] <= header[2]) {
+            bin = file.data() + binChunk + 8;
+            binSize = chunk[0];
+        }
+    }
+
+    JsonValue doc;
+    JsonParser parser = { json, json + jsonSize };
+    if (!parser.parseValue(doc, 0) || doc.type != JsonValue::Type::Object) {
+        fprintf(stderr, "Error: glTF file '%s' has invalid JSON\n", filepath.c_str());
+        return false;
+    }
+
+    // Collect triangle primitives of every mesh. Node transforms are not
+    // applied: each mesh is loaded once, in its own space.
+    std::vector<GltfPrimitive> prims;
+    uint32_t skipped = 0;
+    size_t numVertices = 0, numIndices = 0;
+    for (const JsonValue& mesh : doc.getArray("meshes")) {
+        for (const JsonValue& p : mesh.getArray("primitives")) {
+            const JsonValue* attributes = p.get("attributes");
+            GltfPrimitive prim;
+            bool ok = attributes && p.getNumber("mode", GLTF_TRIANGLES) == GLTF_TRIANGLES &&
+                      resolveAccessor(doc, attributes->getNumber("POSITION", -1), "VEC3",
+                                      bin, binSize, prim.position) &&
+                      prim.position.componentType == GLTF_FLOAT;
+            if (ok && attributes->get("NORMAL")) {
+                ok = resolveAccessor(doc, attributes->getNumber("NORMAL", -1), "VEC3",
+                                     bin, binSize, prim.normal) &&
+                     prim.normal.componentType == GLTF_FLOAT && prim.normal.count == prim.position.count;
+            }
+            if (ok && p.get("indices")) {
+                ok = resolveAccessor(doc, p.getNumber("indices", -1), "SCALAR", bin, binSize, prim.indices) &&
+                     (prim.indices.componentType == GLTF_UNSIGNED_INT ||
+                      prim.indices.componentType == GLTF_UNSIGNED_SHORT ||
+                      prim.indices.componentType == GLTF_UNSIGNED_BYTE);
+            }
+            if (!ok || prim.numIndices() % 3 != 0 || prim.position.count == 0) {
+                skipped++;
+                continue;
+            }
+            prim.vertexBase = numVertices;
+            prim.indexBase = numIndices;
+            numVertices += prim.position.count;
+            numIndices += prim.numIndices();
+            prims.push_back(prim);
+        }
+    }
+    if (skipped > 0) {
+        fprintf(stderr, "Warning: Skipped %u unsupported glTF primitives in '%s'\n", skipped, filepath.c_str());
+    }
+    if (prims.empty() || numVertices > INVALID_INDEX) {
+        fprintf(stderr, "Error: glTF file '%s' has no usable triangle geometry\n", filepath.c_str());
+        return false;
+    }
+
+    // Every primitive writes its own pre-sized slice of the merged mesh
+    outMesh.vertices.resize(numVertices);
+    outMesh.indices.resize(numIndices);
+    parallelFor((uint32_t)prims.size(), [&](uint32_t i) {
+        copyPrimitive(prims[i], outMesh);
+    });
+
+    outMesh.bounds = {};
+    for (const GltfPrimitive& prim : prims) {
+        if (prim.position.hasBounds) {
+            outMesh.bounds.expand(prim.position.min);
+            outMesh.bounds.expand(prim.position.max);
+        } else {
+            for (size_t i = 0; i < prim.position.count; i++)
+                outMesh.bounds.expand(outMesh.vertices[prim.vertexBase + i].position);
+        }
+    }
+
+    for (const GltfPrimitive& prim : prims) {
+        if (!prim.hasNormals()) generatePrimitiveNormals(prim, outMesh);
+    }
+
+    printf("  glTF loaded: %zu vertices, %u triangles from %zu primitives (%.1f MB)\n",
+           outMesh.vertices.size(), outMesh.numTris(), prims.size(), file.size() / 1e6);
+    return true;
+}
+
+} // namespace nanite
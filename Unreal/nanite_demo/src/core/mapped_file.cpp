@@ -0,0 +1,122 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#endif
+
+namespace nanite {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& filepath, MapAccess access) {
+    close();
+
+    bool writable = (access == MapAccess::ReadWrite);
+    HANDLE file = CreateFileA(filepath.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                              FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              access == MapAccess::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle_    = file;
+    mappingHandle_ = mapping;
+    data_ = static_cast<const char*>(view);
+    size_ = (size_t)fileSize.QuadPart;
+    writable_ = writable;
+    return true;
+}
+
+void MappedFile::release(const char* begin, const char* end) {
+    // Unlocking pages that are not locked removes them from the working set
+    if (begin < end) VirtualUnlock(const_cast<char*>(begin), (SIZE_T)(end - begin));
+}
+
+void MappedFile::close() {
+    if (data_) UnmapViewOfFile(data_);
+    if (mappingHandle_) CloseHandle((HANDLE)mappingHandle_);
+    if (fileHandle_) CloseHandle((HANDLE)fileHandle_);
+    data_ = nullptr;
+    size_ = 0;
+    writable_ = false;
+    mappingHandle_ = nullptr;
+    fileHandle_ = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filepath, MapAccess access) {
+    close();
+
+    bool writable = (access == MapAccess::ReadWrite);
+    int fd = ::open(filepath.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = writable
+        ? mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+        : mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference to the file
+    if (view == MAP_FAILED) return false;
+
+    madvise(view, (size_t)st.st_size, access == MapAccess::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+    data_ = static_cast<const char*>(view);
+    size_ = (size_t)st.st_size;
+    writable_ = writable;
+    return true;
+}
+
+void MappedFile::release(const char* begin, const char* end) {
+    // Whole pages only: the pages holding begin and end may still be in use
+    uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t first = ((uintptr_t)begin + pageSize - 1) & ~(pageSize - 1);
+    uintptr_t last  = (uintptr_t)end & ~(pageSize - 1);
+    if (first < last) madvise((void*)first, last - first, MADV_DONTNEED);
+}
+
+void MappedFile::close() {
+    if (data_) munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+    writable_ = false;
+}
+
+#endif
+
+} // namespace nanite
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace nanite {
+
+// How a mapping will be accessed (access-pattern hint for the OS, and
+// whether the mapped bytes may be written back to the file).
+enum class MapAccess {
+    Sequential,     // read-only, scanned front to back (text parsers)
+    Random,         // read-only, random lookups (spill files)
+    ReadWrite,      // shared writable mapping, random access
+};
+
+// Memory mapping of a whole file.
+// Loaders scan the mapped bytes in place instead of copying them through
+// stream buffers. The mapping is released when the object is destroyed.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map the file at `filepath`. Returns false on error.
+    bool open(const std::string& filepath, MapAccess access = MapAccess::Sequential);
+    void close();
+
+    // Drop the resident pages of a range that has been consumed, so a long
+    // scan does not keep the whole file in the process working set.
+    // Only a hint; the range stays mapped and readable.
+    void release(const char* begin, const char* end);
+
+    const char* data() const { return data_; }
+    char*       mutableData() const { return writable_ ? const_cast<char*>(data_) : nullptr; }
+    size_t      size() const { return size_; }
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t      size_ = 0;
+    bool        writable_ = false;
+#ifdef _WIN32
+    void*       fileHandle_    = nullptr;
+    void*       mappingHandle_ = nullptr;
+#endif
+};
+
+} // namespace nanite
@@ -0,0 +1,149 @@
+#include "mesh_cache.h"
+#include "mapped_file.h"
+#include <filesystem>
+#include <cstdio>
+#include <cstring>
+
+namespace nanite {
+
+namespace fs = std::filesystem;
+
+struct NMeshHeader {
+    char     magic[4];          // "NMSH"
+    uint32_t version;
+    uint32_t vertexStride;      // sizeof(Vertex) when written; guards layout changes
+    uint32_t reserved;
+    uint64_t sourceSize;
+    int64_t  sourceMTime;       // filesystem clock ticks
+    uint64_t sourceHash;        // FNV-1a of the first and last SAMPLE_BYTES of the source
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    float    boundsMin[3];
+    float    boundsMax[3];
+};
+
+static constexpr char   NMESH_MAGIC[4] = { 'N', 'M', 'S', 'H' };
+static constexpr size_t SAMPLE_BYTES   = 64 * 1024;
+
+struct SourceKey {
+    uint64_t size  = 0;
+    int64_t  mtime = 0;
+    uint64_t hash  = 0;
+};
+
+static uint64_t fnv1a(const char* data, size_t size, uint64_t h) {
+    for (size_t i = 0; i < size; i++) {
+        h ^= (uint8_t)data[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Identify the current contents of the source file without reading all of it.
+static bool computeSourceKey(const std::string& sourcePath, SourceKey& key) {
+    std::error_code ec;
+    key.size = (uint64_t)fs::file_size(sourcePath, ec);
+    if (ec) return false;
+    auto mtime = fs::last_write_time(sourcePath, ec);
+    if (ec) return false;
+    key.mtime = (int64_t)mtime.time_since_epoch().count();
+
+    MappedFile file;
+    if (!file.open(sourcePath)) return false;
+    size_t head = std::min(file.size(), SAMPLE_BYTES);
+    size_t tail = std::min(file.size() - head, SAMPLE_BYTES);
+    key.hash = fnv1a(file.data(), head, 14695981039346656037ull);
+    key.hash = fnv1a(file.end() - tail, tail, key.hash);
+    return true;
+}
+
+std::string getMeshCachePath(const std::string& sourcePath) {
+    return sourcePath + ".nmesh";
+}
+
+bool loadMeshCache(const std::string& cachePath, const std::string& sourcePath, RawMesh& outMesh) {
+    SourceKey key;
+    if (!computeSourceKey(sourcePath, key)) return false;
+
+    MappedFile file;
+    if (!file.open(cachePath)) return false;
+    if (file.size() < sizeof(NMeshHeader)) return false;
+
+    NMeshHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, NMESH_MAGIC, 4) != 0 ||
+        header.version != NMESH_VERSION ||
+        header.vertexStride != sizeof(Vertex)) {
+        return false;
+    }
+    if (header.sourceSize != key.size || header.sourceMTime != key.mtime ||
+        header.sourceHash != key.hash) {
+        printf("  Mesh cache '%s' is stale, rebuilding\n", cachePath.c_str());
+        return false;
+    }
+
+    uint64_t vertexBytes = header.vertexCount * sizeof(Vertex);
+    uint64_t indexBytes  = header.indexCount * sizeof(uint32_t);
+    if (file.size() != sizeof(NMeshHeader) + vertexBytes + indexBytes ||
+        header.indexCount % 3 != 0) {
+        fprintf(stderr, "Warning: Mesh cache '%s' is truncated, ignoring it\n", cachePath.c_str());
+        return false;
+    }
+
+    const char* payload = file.data() + sizeof(NMeshHeader);
+    outMesh.vertices.resize((size_t)header.vertexCount);
+    outMesh.indices.resize((size_t)header.indexCount);
+    memcpy(outMesh.vertices.data(), payload, (size_t)vertexBytes);
+    memcpy(outMesh.indices.data(), payload + vertexBytes, (size_t)indexBytes);
+    outMesh.bounds.min = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    outMesh.bounds.max = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+
+    printf("  Mesh cache loaded: %zu vertices, %u triangles (%.1f MB)\n",
+           outMesh.vertices.size(), outMesh.numTris(), file.size() / 1e6);
+    return true;
+}
+
+bool saveMeshCache(const std::string& cachePath, const std::string& sourcePath, const RawMesh& mesh) {
+    SourceKey key;
+    if (!computeSourceKey(sourcePath, key)) return false;
+
+    NMeshHeader header = {};
+    memcpy(header.magic, NMESH_MAGIC, 4);
+    header.version      = NMESH_VERSION;
+    header.vertexStride = sizeof(Vertex);
+    header.sourceSize   = key.size;
+    header.sourceMTime  = key.mtime;
+    header.sourceHash   = key.hash;
+    header.vertexCount  = mesh.vertices.size();
+    header.indexCount   = mesh.indices.size();
+    for (int i = 0; i < 3; i++) {
+        header.boundsMin[i] = mesh.bounds.min[i];
+        header.boundsMax[i] = mesh.bounds.max[i];
+    }
+
+    std::string tmpPath = cachePath + ".tmp";
+    FILE* f = fopen(tmpPath.c_str(), "wb");
+    if (!f) {
+        fprintf(stderr, "Warning: Cannot write mesh cache '%s'\n", tmpPath.c_str());
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    if (ok && !mesh.vertices.empty())
+        ok = fwrite(mesh.vertices.data(), sizeof(Vertex), mesh.vertices.size(), f) == mesh.vertices.size();
+    if (ok && !mesh.indices.empty())
+        ok = fwrite(mesh.indices.data(), sizeof(uint32_t), mesh.indices.size(), f) == mesh.indices.size();
+    ok = (fclose(f) == 0) && ok;
+
+    std::error_code ec;
+    if (ok) fs::rename(tmpPath, cachePath, ec);
+    if (!ok || ec) {
+        fprintf(stderr, "Warning: Failed to write mesh cache '%s'\n", cachePath.c_str());
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+
+    printf("  Mesh cache written: %s\n", cachePath.c_str());
+    return true;
+}
+
+} // namespace nanite
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "mesh_loader.h"
+#include <string>
+
+namespace nanite {
+
+// Binary mesh cache (.nmesh): a sidecar file holding the final RawMesh of a
+// source asset (after parsing, vertex dedup, normal generation and cleanup), so warm
+// starts skip the text parse entirely.
+//
+// Layout: NMeshHeader, then vertexCount Vertex records, then indexCount
+// uint32 indices. Native (little-endian) byte order.
+constexpr uint32_t NMESH_VERSION = 2;
+
+// Default cache location for a source file: "<source>.nmesh"
+std::string getMeshCachePath(const std::string& sourcePath);
+
+// Load `cachePath` if it exists, has the current version and was written for
+// the current contents of `sourcePath` (size, mtime and a sampled content hash).
+// Returns false if the cache is missing, stale or corrupt.
+bool loadMeshCache(const std::string& cachePath, const std::string& sourcePath, RawMesh& outMesh);
+
+// Write `mesh` to `cachePath`, keyed by the current state of `sourcePath`.
+// The file is written to a temporary name and renamed into place.
+bool saveMeshCache(const std::string& cachePath, const std::string& sourcePath, const RawMesh& mesh);
+
+} // namespace nanite
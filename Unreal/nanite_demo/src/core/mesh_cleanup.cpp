@@ -0,0 +1,258 @@
+#include "mesh_cleanup.h"
+#include "flat_hash_map.h"
+#include "parallel.h"
+#include "radix_sort.h"
+
+namespace nanite {
+
+// Items per task below which splitting does not pay off.
+static constexpr uint32_t MIN_TASK_ITEMS = 64 * 1024;
+// Cells are this many weld distances wide, so a vertex is usually far enough
+// from the cell walls to search one or two cells instead of all 27.
+static constexpr float CELL_SIZE_IN_WELD_DISTANCES = 16.0f;
+// Cell coordinates are packed into 21 bits per axis.
+static constexpr uint32_t CELL_BITS = 21;
+static constexpr uint32_t CELL_MAX  = (1u << CELL_BITS) - 1;
+
+// Run fn(begin, end) over [0, count) split into up to `numThreads` ranges.
+template<typename Fn>
+static void parallelRanges(uint32_t count, uint32_t numThreads, Fn&& fn) {
+    uint32_t numTasks = std::min(numThreads, std::max(1u, count / MIN_TASK_ITEMS));
+    parallelFor(numTasks, [&](uint32_t task) {
+        fn((uint32_t)((uint64_t)count * task / numTasks), (uint32_t)((uint64_t)count * (task + 1) / numTasks));
+    });
+}
+
+static inline uint64_t packCell(uint32_t x, uint32_t y, uint32_t z) {
+    return (uint64_t)x | ((uint64_t)y << CELL_BITS) | ((uint64_t)z << (2 * CELL_BITS));
+}
+
+// ---------- Welding ----------
+
+// Spatial hash of the vertices: cell -> first vertex, with the vertices of a
+// cell chained in index order.
+struct WeldGrid {
+    glm::vec3             origin;
+    float                 cellSize;
+    FlatHashMap64         heads;
+    std::vector<uint32_t> cellHead; // per vertex: first vertex of its own cell
+    std::vector<uint32_t> next;
+
+    glm::vec3 cellCoord(const glm::vec3& p) const {
+        return glm::clamp((p - origin) / cellSize, glm::vec3(0.0f), glm::vec3((float)CELL_MAX));
+    }
+};
+
+// Lowest-index vertex within `dist` of v (and with a compatible normal),
+// or v itself. Only the neighbour cells that v lies within `dist` of are searched.
+static uint32_t findWeldTarget(const RawMesh& mesh, const WeldGrid& grid, uint32_t v,
+                               float dist, float normalCos)
+{
+    const Vertex& vert = mesh.vertices[v];
+    glm::vec3 c = grid.cellCoord(vert.position);
+    float margin = dist / grid.cellSize;
+    int lo[3], hi[3];
+    for (int a = 0; a < 3; a++) {
+        float f = c[a] - std::floor(c[a]);
+        lo[a] = (f < margin && c[a] >= 1.0f) ? -1 : 0;
+        hi[a] = (f > 1.0f - margin && c[a] < (float)CELL_MAX) ? 1 : 0;
+    }
+
+    uint32_t best = v;
+    float dist2 = dist * dist;
+    for (int dz = lo[2]; dz <= hi[2]; dz++) {
+        for (int dy = lo[1]; dy <= hi[1]; dy++) {
+            for (int dx = lo[0]; dx <= hi[0]; dx++) {
+                uint32_t head = grid.cellHead[v];
+                if (dx | dy | dz) {
+                    const uint32_t* found = grid.heads.find(packCell((uint32_t)c.x + dx, (uint32_t)c.y + dy, (uint32_t)c.z + dz));
+                    if (!found) continue;
+                    head = *found;
+                }
+                // Chains are in index order: the first match is the lowest in this cell
+                for (uint32_t u = head; u < best; u = grid.next[u]) {
+                    const Vertex& other = mesh.vertices[u];
+                    glm::vec3 d = other.position - vert.position;
+                    if (glm::dot(d, d) > dist2) continue;
+                    if (normalCos > -1.0f && glm::dot(other.normal, vert.normal) < normalCos) continue;
+                    best = u;
+                    break;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+// ---------- Duplicate triangles ----------
+
+// Rotate (a, b, c) so the smallest index comes first; winding is preserved.
+static inline void canonicalTriangle(const uint32_t* tri, uint32_t out[3]) {
+    int first = (tri[1] < tri[0]) ? 1 : 0;
+    if (tri[2] < tri[first]) first = 2;
+    for (int k = 0; k < 3; k++) out[k] = tri[(first + k) % 3];
+}
+
+// ---------- Cleanup ----------
+
+void cleanupMesh(RawMesh& mesh, const MeshCleanupOptions& options, MeshCleanupStats* outStats) {
+    MeshCleanupStats stats;
+    uint32_t numVerts = (uint32_t)mesh.vertices.size();
+    uint32_t numTris = mesh.numTris();
+    stats.verticesIn = numVerts;
+    stats.trianglesIn = numTris;
+    uint32_t numThreads = options.numThreads ? options.numThreads : getNumWorkerThreads();
+
+    AABB bounds;
+    for (const Vertex& v : mesh.vertices) bounds.expand(v.position);
+    float diagonal = bounds.valid() ? glm::length(bounds.max - bounds.min) : 0.0f;
+    float dist = options.weldDistance < 0.0f ? diagonal * 1e-6f : options.weldDistance;
+    stats.weldDistance = dist;
+
+    // 1. Weld: bucket vertices by cell, then each vertex (in parallel) looks
+    //    for the lowest-index match around it. Cells are several `dist` wide,
+    //    and no smaller than the 21-bit coordinate range allows.
+    std::vector<uint32_t> weld(numVerts);
+    if (numVerts > 0) {
+        WeldGrid grid;
+        grid.origin = bounds.min;
+        grid.cellSize = std::max({ dist * CELL_SIZE_IN_WELD_DISTANCES, diagonal / (float)CELL_MAX, 1e-30f });
+        grid.heads.reserve(numVerts);
+        grid.cellHead.resize(numVerts);
+        grid.next.assign(numVerts, INVALID_INDEX);
+        std::vector<uint64_t> cells(numVerts);
+        parallelRanges(numVerts, numThreads, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t v = begin; v < end; v++) {
+                glm::vec3 c = grid.cellCoord(mesh.vertices[v].position);
+                cells[v] = packCell((uint32_t)c.x, (uint32_t)c.y, (uint32_t)c.z);
+            }
+        });
+        std::vector<uint32_t> tail(numVerts);
+        for (uint32_t v = 0; v < numVerts; v++) {
+            bool inserted;
+            uint32_t head = grid.heads.findOrInsert(cells[v], v, inserted);
+            grid.cellHead[v] = head;
+            if (!inserted) grid.next[tail[head]] = v;
+            tail[head] = v;
+        }
+        std::vector<uint64_t>().swap(cells);
+        std::vector<uint32_t>().swap(tail);
+
+        std::vector<uint32_t> target(numVerts);
+        parallelRanges(numVerts, numThreads, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t v = begin; v < end; v++)
+                target[v] = findWeldTarget(mesh, grid, v, dist, options.weldNormalCos);
+        });
+        // Targets always have lower indices, so chains end at a vertex that
+        // targets itself
+        parallelRanges(numVerts, numThreads, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t v = begin; v < end; v++) {
+                uint32_t r = target[v];
+                while (target[r] != r) r = target[r];
+                weld[v] = r;
+            }
+        });
+        for (uint32_t v = 0; v < numVerts; v++) stats.verticesWelded += (weld[v] != v);
+    }
+
+    // 2. Remap corners to welded vertices and flag degenerate triangles
+    std::vector<uint8_t> keep(numTris, 1);
+    parallelRanges(numTris, numThreads, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t t = begin; t < end; t++) {
+            uint32_t* tri = &mesh.indices[(size_t)t * 3];
+            for (int k = 0; k < 3; k++) tri[k] = weld[tri[k]];
+            if (!options.removeDegenerate) continue;
+            if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) {
+                keep[t] = 0;
+                continue;
+            }
+            const glm::vec3& p0 = mesh.vertices[tri[0]].position;
+            const glm::vec3& p1 = mesh.vertices[tri[1]].position;
+            const glm::vec3& p2 = mesh.vertices[tri[2]].position;
+            // Height over the longest edge: |cross| / longest <= dist
+            float longest2 = std::max({ glm::dot(p1 - p0, p1 - p0), glm::dot(p2 - p1, p2 - p1), glm::dot(p0 - p2, p0 - p2) });
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            if (glm::dot(n, n) <= dist * dist * longest2) keep[t] = 0;
+        }
+    });
+    for (uint32_t t = 0; t < numTris; t++) stats.degenerateRemoved += (keep[t] == 0);
+
+    // 3. Duplicates share their smallest vertex: bucket the triangles by it,
+    //    then sort each bucket (in parallel) by the other two vertices of the
+    //    canonical triangle, ties by triangle index, so duplicates are
+    //    adjacent and the first occurrence in triangle order wins.
+    if (options.removeDuplicates && numVerts > 0) {
+        std::vector<uint32_t> bucketStart(numVerts + 1, 0);
+        for (uint32_t t = 0; t < numTris; t++) {
+            if (!keep[t]) continue;
+            const uint32_t* tri = &mesh.indices[(size_t)t * 3];
+            bucketStart[std::min({ tri[0], tri[1], tri[2] }) + 1]++;
+        }
+        for (uint32_t v = 0; v < numVerts; v++) bucketStart[v + 1] += bucketStart[v];
+        std::vector<uint32_t> bucketTris(bucketStart[numVerts]);
+        std::vector<uint32_t> cursor(bucketStart.begin(), bucketStart.end() - 1);
+        for (uint32_t t = 0; t < numTris; t++) {
+            if (!keep[t]) continue;
+            const uint32_t* tri = &mesh.indices[(size_t)t * 3];
+            bucketTris[cursor[std::min({ tri[0], tri[1], tri[2] })]++] = t;
+        }
+        std::vector<uint32_t>().swap(cursor);
+
+        // Each triangle is in exactly one bucket, so keep[] writes never overlap
+        parallelRanges(numVerts, numThreads, [&](uint32_t begin, uint32_t end) {
+            std::vector<RadixSortItem<uint64_t>> sorted;
+            for (uint32_t v = begin; v < end; v++) {
+                if (bucketStart[v + 1] - bucketStart[v] < 2) continue;
+                sorted.clear();
+                for (uint32_t i = bucketStart[v]; i < bucketStart[v + 1]; i++) {
+                    uint32_t tri[3];
+                    canonicalTriangle(&mesh.indices[(size_t)bucketTris[i] * 3], tri);
+                    sorted.push_back({ ((uint64_t)tri[1] << 32) | tri[2], bucketTris[i] });
+                }
+                std::sort(sorted.begin(), sorted.end(), [](const RadixSortItem<uint64_t>& x, const RadixSortItem<uint64_t>& y) {
+                    return x.key != y.key ? x.key < y.key : x.index < y.index;
+                });
+                for (size_t i = 1; i < sorted.size(); i++) {
+                    if (sorted[i].key == sorted[i - 1].key) keep[sorted[i].index] = 0;
+                }
+            }
+        });
+        for (uint32_t t = 0; t < numTris; t++) stats.duplicateRemoved += (keep[t] == 0);
+        stats.duplicateRemoved -= stats.degenerateRemoved;
+    }
+
+    // 4. Compact triangles, then the vertices they still use
+    std::vector<uint32_t> remap(numVerts, INVALID_INDEX);
+    size_t outCorner = 0;
+    for (uint32_t t = 0; t < numTris; t++) {
+        if (!keep[t]) continue;
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = mesh.indices[(size_t)t * 3 + k];
+            remap[v] = 0;
+            mesh.indices[outCorner++] = v;
+        }
+    }
+    mesh.indices.resize(outCorner);
+
+    uint32_t outVerts = 0;
+    mesh.bounds = {};
+    for (uint32_t v = 0; v < numVerts; v++) {
+        if (remap[v] == INVALID_INDEX) {
+            if (weld[v] == v) stats.verticesUnused++;
+            continue;
+        }
+        remap[v] = outVerts;
+        mesh.vertices[outVerts++] = mesh.vertices[v];
+        mesh.bounds.expand(mesh.vertices[remap[v]].position);
+    }
+    mesh.vertices.resize(outVerts);
+    parallelRanges((uint32_t)mesh.indices.size(), numThreads, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t c = begin; c < end; c++) mesh.indices[c] = remap[mesh.indices[c]];
+    });
+
+    stats.verticesOut = outVerts;
+    stats.trianglesOut = mesh.numTris();
+    if (outStats) *outStats = stats;
+}
+
+} // namespace nanite
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "mesh_loader.h"
+
+namespace nanite {
+
+struct MeshCleanupOptions {
+    // Vertices closer than this are welded. Negative: 1e-6 of the bounds
+    // diagonal. 0: only bit-identical positions.
+    float    weldDistance = -1.0f;
+    // Welded vertices must also have normals within this cosine, so hard
+    // edges (split normals on purpose) survive. -1 welds by position only.
+    float    weldNormalCos = 0.99f;
+    // Drop triangles that reference a vertex twice, or whose height is
+    // below the weld distance (zero area).
+    bool     removeDegenerate = true;
+    // Drop repeated triangles (same vertices and winding, any rotation).
+    bool     removeDuplicates = true;
+    // Threads: 0 = all worker threads. The result is identical for every count.
+    uint32_t numThreads = 0;
+};
+
+struct MeshCleanupStats {
+    uint32_t verticesIn       = 0;
+    uint32_t verticesOut      = 0;
+    uint32_t verticesWelded   = 0;   // merged into another vertex
+    uint32_t verticesUnused   = 0;   // not referenced by any remaining triangle
+    uint32_t trianglesIn      = 0;
+    uint32_t trianglesOut     = 0;
+    uint32_t degenerateRemoved = 0;
+    uint32_t duplicateRemoved  = 0;
+    float    weldDistance     = 0.0f; // effective distance used
+};
+
+// Weld nearby vertices through a spatial hash, remove degenerate and duplicate
+// triangles and compact the vertex array. Vertex order is kept (each weld
+// keeps the lowest index), triangle order is kept, bounds are recomputed.
+void cleanupMesh(RawMesh& mesh, const MeshCleanupOptions& options = {},
+                 MeshCleanupStats* outStats = nullptr);
+
+} // namespace nanite
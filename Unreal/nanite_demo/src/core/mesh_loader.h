@@ -13,7 +13,53 @@ struct RawMesh {
     uint32_t numTris() const { return (uint32_t)(indices.size() / 3); }
 };
 
+struct MeshLoadOptions {
+    // Threads used to parse the file: 0 = all worker threads, 1 = serial.
+    // The resulting RawMesh is identical for every thread count.
+    uint32_t numThreads = 0;
+};
+
+// Load a mesh file, picking the format from the extension (.obj, .ply, .stl, .glb).
+// "proc:..." names generate a procedural mesh instead (see procedural_mesh.h).
+// Returns false on error.
+bool loadMesh(const std::string& filepath, RawMesh& outMesh, const MeshLoadOptions& options = {});
+
 // Load a Wavefront OBJ file. Returns false on error.
-bool loadOBJ(const std::string& filepath, RawMesh& outMesh);
+bool loadOBJ(const std::string& filepath, RawMesh& outMesh, const MeshLoadOptions& options = {});
+
+// Load a binary little-endian PLY file: `vertex` elements with x/y/z and
+// optional nx/ny/nz, `face` elements with a vertex index list (polygons are
+// fan-triangulated). Returns false on error.
+bool loadPLY(const std::string& filepath, RawMesh& outMesh);
+
+// Load a binary STL file. STL stores three separate corners per triangle, so
+// corners with identical positions are welded into shared vertices and smooth
+// normals are generated. Returns false on error.
+bool loadSTL(const std::string& filepath, RawMesh& outMesh);
+
+// Load a binary glTF 2.0 file (.glb). Triangle primitives of all meshes are
+// merged into one RawMesh, read from the embedded BIN chunk (float
+// POSITION/NORMAL, 8/16/32-bit indices). Primitives without NORMAL get
+// smooth normals; the others keep theirs. Node transforms are not applied.
+// Returns false on error.
+bool loadGLB(const std::string& filepath, RawMesh& outMesh);
+
+enum class NormalWeighting {
+    Area,   // face normals weighted by triangle area
+    Angle,  // unit face normals weighted by the corner angle at the vertex
+};
+
+struct VertexNormalOptions {
+    NormalWeighting weighting = NormalWeighting::Area;
+    // Threads: 0 = all worker threads, 1 = serial. The result is identical
+    // for every thread count.
+    uint32_t numThreads = 0;
+};
+
+// Replace all vertex normals with normalized, weighted sums of the adjacent
+// face normals. In parallel, each task owns a vertex range: corners are routed
+// to the owner of their vertex and summed there in triangle order, so no two
+// tasks write the same vertex.
+void computeVertexNormals(RawMesh& mesh, const VertexNormalOptions& options = {});
 
 } // namespace nanite
@@ -0,0 +1,332 @@
+#include "obj_parser.h"
+#include "parallel.h"
+#include "flat_hash_map.h"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+namespace nanite {
+
+void ObjParseResult::clear() {
+    positions.clear();
+    normals.clear();
+    faceVerts.clear();
+    faceSizes.clear();
+    relativePosCorners.clear();
+    relativeNormCorners.clear();
+}
+
+// ---------- Tokenizer helpers ----------
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) p++;
+    return p;
+}
+
+static inline const char* skipToken(const char* p, const char* end) {
+    while (p < end && !isBlank(*p)) p++;
+    return p;
+}
+
+// Parse a float at p. std::from_chars is locale-free and correctly rounded,
+// so the result is bit-identical to the previous istream extraction.
+// On failure out is set to 0 (same as a failed stream extraction).
+static inline const char* parseFloat(const char* p, const char* end, float& out) {
+    p = skipBlanks(p, end);
+    if (p < end && *p == '+') p++; // from_chars rejects an explicit '+'
+    auto res = std::from_chars(p, end, out);
+    if (res.ec != std::errc()) {
+        out = 0.0f;
+        return skipToken(p, end);
+    }
+    return res.ptr;
+}
+
+// Parse a signed decimal integer. Returns nullptr if no digits were found.
+static inline const char* parseInt(const char* p, const char* end, int64_t& out) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    if (p >= end || (unsigned)(*p - '0') > 9) return nullptr;
+
+    // Saturates well past the 32-bit index range instead of overflowing
+    int64_t value = 0;
+    while (p < end && (unsigned)(*p - '0') <= 9) {
+        if (value < ((int64_t)1 << 40)) value = value * 10 + (*p - '0');
+        p++;
+    }
+    out = negative ? -value : value;
+    return p;
+}
+
+// OBJ indices are 1-based; negative values count back from the last element.
+// 0 and indices beyond the 32-bit range address nothing: INVALID_INDEX.
+// A relative index reaching before the first element wraps around, because a
+// chunk parsed on its own is shifted into place afterwards (see
+// relativePosCorners); validateOBJIndices rejects what is still out of range.
+static inline bool isRelativeIndex(int64_t idx) {
+    return idx < 0 && idx > -(int64_t)INVALID_INDEX;
+}
+
+static inline uint32_t resolveIndex(int64_t idx, size_t count) {
+    if (idx > 0) return idx <= (int64_t)INVALID_INDEX ? (uint32_t)(idx - 1) : INVALID_INDEX;
+    if (!isRelativeIndex(idx)) return INVALID_INDEX;
+    return (uint32_t)((int64_t)count + idx);
+}
+
+// ---------- Record parsers ----------
+
+static inline const char* parseVec3(const char* p, const char* end, glm::vec3& v) {
+    p = parseFloat(p, end, v.x);
+    p = parseFloat(p, end, v.y);
+    p = parseFloat(p, end, v.z);
+    return p;
+}
+
+// Face corner formats: v, v/vt, v/vt/vn, v//vn
+static void parseFace(const char* p, const char* end, ObjParseResult& out) {
+    size_t firstCorner = out.faceVerts.size();
+
+    while (true) {
+        p = skipBlanks(p, end);
+        if (p >= end || *p == '#') break;
+
+        int64_t v = 0;
+        const char* q = parseInt(p, end, v);
+        if (!q) {
+            p = skipToken(p, end);
+            continue;
+        }
+
+        uint32_t corner = (uint32_t)out.faceVerts.size();
+        if (isRelativeIndex(v)) out.relativePosCorners.push_back(corner);
+
+        ObjFaceVert fv = { resolveIndex(v, out.positions.size()), INVALID_INDEX };
+        if (q < end && *q == '/') {
+            q++;
+            int64_t vt = 0;
+            if (const char* r = parseInt(q, end, vt)) q = r; // texcoords are unused
+            if (q < end && *q == '/') {
+                q++;
+                int64_t vn = 0;
+                if (const char* r = parseInt(q, end, vn)) {
+                    if (isRelativeIndex(vn)) out.relativeNormCorners.push_back(corner);
+                    fv.vn = resolveIndex(vn, out.normals.size());
+                    q = r;
+                }
+            }
+        }
+        out.faceVerts.push_back(fv);
+        p = skipToken(q, end);
+    }
+
+    size_t numCorners = out.faceVerts.size() - firstCorner;
+    if (numCorners >= 3) {
+        out.faceSizes.push_back((uint32_t)numCorners);
+    } else {
+        out.faceVerts.resize(firstCorner);
+        while (!out.relativePosCorners.empty() && out.relativePosCorners.back() >= firstCorner)
+            out.relativePosCorners.pop_back();
+        while (!out.relativeNormCorners.empty() && out.relativeNormCorners.back() >= firstCorner)
+            out.relativeNormCorners.pop_back();
+    }
+}
+
+void parseOBJ(const char* begin, const char* end, ObjParseResult& out) {
+    const char* p = begin;
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', (size_t)(end - p)));
+        if (!lineEnd) lineEnd = end;
+
+        p = skipBlanks(p, lineEnd);
+        if (p < lineEnd && *p != '#') {
+            const char* keyEnd = skipToken(p, lineEnd);
+            size_t keyLen = (size_t)(keyEnd - p);
+
+            if (keyLen == 1 && p[0] == 'v') {
+                glm::vec3 pos;
+                parseVec3(keyEnd, lineEnd, pos);
+                out.positions.push_back(pos);
+            } else if (keyLen == 2 && p[0] == 'v' && p[1] == 'n') {
+                glm::vec3 n;
+                parseVec3(keyEnd, lineEnd, n);
+                out.normals.push_back(n);
+            } else if (keyLen == 1 && p[0] == 'f') {
+                parseFace(keyEnd, lineEnd, out);
+            }
+        }
+
+        p = lineEnd + 1;
+    }
+}
+
+// ---------- Chunked parallel parse ----------
+
+// Chunks smaller than this are not worth a task of their own.
+static constexpr size_t MIN_CHUNK_BYTES = 4u << 20;
+
+static const char* nextLineStart(const char* p, const char* begin, const char* end) {
+    if (p <= begin) return begin;
+    // p may already sit at a line start; check the byte before it
+    const char* nl = static_cast<const char*>(memchr(p - 1, '\n', (size_t)(end - (p - 1))));
+    return nl ? nl + 1 : end;
+}
+
+void parseOBJParallel(const char* begin, const char* end, ObjParseResult& out,
+                      uint32_t numThreads)
+{
+    size_t size = (size_t)(end - begin);
+    if (numThreads == 0) numThreads = getNumWorkerThreads();
+    uint32_t numChunks = (uint32_t)std::min<size_t>(numThreads, std::max<size_t>(1, size / MIN_CHUNK_BYTES));
+    if (numChunks <= 1) {
+        parseOBJ(begin, end, out);
+        return;
+    }
+
+    // Split at line boundaries
+    std::vector<const char*> bounds(numChunks + 1);
+    bounds[0] = begin;
+    bounds[numChunks] = end;
+    for (uint32_t i = 1; i < numChunks; i++) {
+        bounds[i] = nextLineStart(begin + size * i / numChunks, begin, end);
+        if (bounds[i] < bounds[i - 1]) bounds[i] = bounds[i - 1];
+    }
+
+    std::vector<ObjParseResult> chunks(numChunks);
+    parallelFor(numChunks, [&](uint32_t i) {
+        parseOBJ(bounds[i], bounds[i + 1], chunks[i]);
+    });
+
+    // Stitch: element offsets of each chunk in the concatenated arrays
+    struct ChunkBase { size_t pos, norm, corner, face; };
+    std::vector<ChunkBase> base(numChunks + 1);
+    base[0] = { out.positions.size(), out.normals.size(), out.faceVerts.size(), out.faceSizes.size() };
+    for (uint32_t i = 0; i < numChunks; i++) {
+        base[i + 1].pos    = base[i].pos    + chunks[i].positions.size();
+        base[i + 1].norm   = base[i].norm   + chunks[i].normals.size();
+        base[i + 1].corner = base[i].corner + chunks[i].faceVerts.size();
+        base[i + 1].face   = base[i].face   + chunks[i].faceSizes.size();
+    }
+    out.positions.resize(base[numChunks].pos);
+    out.normals.resize(base[numChunks].norm);
+    out.faceVerts.resize(base[numChunks].corner);
+    out.faceSizes.resize(base[numChunks].face);
+
+    parallelFor(numChunks, [&](uint32_t i) {
+        ObjParseResult& c = chunks[i];
+        const ChunkBase& b = base[i];
+
+        // Relative indices were resolved against chunk-local counts; shifting
+        // them by the elements of all earlier chunks makes them global.
+        // (Wrap-around of a "negative" local result is intended.)
+        for (uint32_t corner : c.relativePosCorners)  c.faceVerts[corner].v  += (uint32_t)b.pos;
+        for (uint32_t corner : c.relativeNormCorners) c.faceVerts[corner].vn += (uint32_t)b.norm;
+
+        std::copy(c.positions.begin(), c.positions.end(), out.positions.begin() + b.pos);
+        std::copy(c.normals.begin(),   c.normals.end(),   out.normals.begin()   + b.norm);
+        std::copy(c.faceVerts.begin(), c.faceVerts.end(), out.faceVerts.begin() + b.corner);
+        std::copy(c.faceSizes.begin(), c.faceSizes.end(), out.faceSizes.begin() + b.face);
+    });
+
+    // Report relative corners like parseOBJ does, for callers that parse a
+    // file window by window and shift them once more
+    for (uint32_t i = 0; i < numChunks; i++) {
+        for (uint32_t corner : chunks[i].relativePosCorners)
+            out.relativePosCorners.push_back(corner + (uint32_t)base[i].corner);
+        for (uint32_t corner : chunks[i].relativeNormCorners)
+            out.relativeNormCorners.push_back(corner + (uint32_t)base[i].corner);
+    }
+}
+
+size_t validateOBJIndices(ObjParseResult& obj) {
+    const size_t numPositions = obj.positions.size();
+    const size_t numNormals   = obj.normals.size();
+    size_t changed = 0;
+    for (ObjFaceVert& fv : obj.faceVerts) {
+        if (fv.v != INVALID_INDEX && fv.v >= numPositions) {
+            fv.v = INVALID_INDEX;
+            changed++;
+        }
+        if (fv.vn != INVALID_INDEX && fv.vn >= numNormals) {
+            fv.vn = INVALID_INDEX;
+            changed++;
+        }
+    }
+    return changed;
+}
+
+// ---------- Triangulation ----------
+
+// Dedup key: (position index, normal index) packed into 64 bits
+static inline uint64_t packVertexKey(uint32_t posIdx, uint32_t normIdx) {
+    return ((uint64_t)posIdx << 32) | normIdx;
+}
+
+void triangulateOBJ(const ObjParseResult& obj, RawMesh& outMesh) {
+    const std::vector<glm::vec3>& positions = obj.positions;
+    const std::vector<glm::vec3>& normals   = obj.normals;
+
+    // Corners usually share one (v, vn) pair per position, so the position or
+    // normal count is a good estimate of the unique vertex count.
+    size_t expectedVerts = std::max(positions.size(), normals.size());
+    FlatHashMap64 vertMap(expectedVerts);
+    outMesh.vertices.clear();
+    outMesh.indices.clear();
+    outMesh.bounds = {};
+
+    size_t numTriCorners = 0;
+    for (uint32_t faceSize : obj.faceSizes) numTriCorners += (faceSize - 2) * 3;
+    outMesh.indices.reserve(numTriCorners);
+    outMesh.vertices.reserve(expectedVerts);
+
+    size_t skippedFaces = 0;
+    size_t faceStart = 0;
+    for (uint32_t faceSize : obj.faceSizes) {
+        const ObjFaceVert* face = obj.faceVerts.data() + faceStart;
+        faceStart += faceSize;
+
+        // A face with a corner outside the position array cannot be placed
+        bool valid = true;
+        for (uint32_t i = 0; i < faceSize; i++) valid &= face[i].v < positions.size();
+        if (!valid) {
+            skippedFaces++;
+            continue;
+        }
+
+        // Triangulate polygon as a fan
+        for (size_t i = 1; i + 1 < faceSize; i++) {
+            ObjFaceVert tri[3] = { face[0], face[i], face[i + 1] };
+            for (int j = 0; j < 3; j++) {
+                // An out-of-range normal reference counts as none
+                uint32_t normIdx = tri[j].vn < normals.size() ? tri[j].vn : INVALID_INDEX;
+                uint32_t newIdx = (uint32_t)outMesh.vertices.size();
+                bool inserted;
+                uint32_t idx = vertMap.findOrInsert(packVertexKey(tri[j].v, normIdx), newIdx, inserted);
+                outMesh.indices.push_back(idx);
+                if (inserted) {
+                    Vertex vert;
+                    vert.position = positions[tri[j].v];
+                    if (normIdx != INVALID_INDEX) {
+                        vert.normal = normals[normIdx];
+                    } else {
+                        vert.normal = glm::vec3(0, 1, 0); // placeholder
+                    }
+                    outMesh.vertices.push_back(vert);
+                    outMesh.bounds.expand(vert.position);
+                }
+            }
+        }
+    }
+
+    if (skippedFaces > 0) {
+        fprintf(stderr, "Warning: Skipped %zu OBJ faces with out-of-range position indices\n", skippedFaces);
+    }
+}
+
+} // namespace nanite
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "types.h"
+#include "mesh_loader.h"
+
+namespace nanite {
+
+// One face corner with 0-based indices into the position/normal arrays.
+// vn is INVALID_INDEX when the corner has no normal reference.
+struct ObjFaceVert {
+    uint32_t v;
+    uint32_t vn;
+};
+
+// Raw records of an OBJ file (or a byte range of one), before triangulation.
+struct ObjParseResult {
+    std::vector<glm::vec3>   positions;
+    std::vector<glm::vec3>   normals;
+    std::vector<ObjFaceVert> faceVerts;   // corners of all faces, concatenated
+    std::vector<uint32_t>    faceSizes;   // corner count per face (always >= 3)
+
+    // Corners whose v / vn index was relative (negative) in the file.
+    // Those indices were resolved against the counts local to this result,
+    // so a chunk parsed on its own must shift them by the number of elements
+    // that precede it (see parseOBJParallel).
+    std::vector<uint32_t>    relativePosCorners;
+    std::vector<uint32_t>    relativeNormCorners;
+
+    void clear();
+};
+
+// Parse the `v`, `vn` and `f` records in [begin, end) and append them to `out`.
+// Scans the bytes in place: no per-line strings or streams are created.
+// Relative (negative) face indices resolve against the elements already in `out`.
+void parseOBJ(const char* begin, const char* end, ObjParseResult& out);
+
+// Parse [begin, end) on up to `numThreads` threads (0 = all workers).
+// The range is split into chunks at line boundaries, each chunk is parsed
+// independently and the results are concatenated in file order, so the output
+// is identical to parseOBJ regardless of the thread count.
+void parseOBJParallel(const char* begin, const char* end, ObjParseResult& out,
+                      uint32_t numThreads = 0);
+
+// Set the face corner indices of a whole-file result that address no element
+// of `obj` to INVALID_INDEX, once relative corners are shifted into place.
+// parseOBJ and parseOBJParallel resolve indices without knowing the rest of
+// the file (a window may reference earlier windows), so they leave this to
+// callers that hold the complete arrays. Returns the number of corners changed.
+size_t validateOBJIndices(ObjParseResult& obj);
+
+// Fan-triangulate the parsed faces into `outMesh` (vertices, indices, bounds).
+// Corners sharing the same (v, vn) pair become one vertex; corners without a
+// normal reference (or an out-of-range one) get a placeholder normal (0, 1, 0).
+// Faces with an out-of-range position index are skipped with a warning.
+void triangulateOBJ(const ObjParseResult& obj, RawMesh& outMesh);
+
+} // namespace nanite
@@ -0,0 +1,140 @@
+#include "parallel.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <vector>
+
+namespace nanite {
+
+// Set while a thread is executing parallelFor tasks; nested calls run inline.
+static thread_local bool tInsideParallelFor = false;
+
+class ThreadPool {
+public:
+    ThreadPool() {
+        uint32_t hw = std::thread::hardware_concurrency();
+        uint32_t numWorkers = hw > 1 ? hw - 1 : 0;
+        for (uint32_t i = 0; i < numWorkers; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    uint32_t numThreads() const { return (uint32_t)workers.size() + 1; }
+
+    void run(uint32_t count, const std::function<void(uint32_t)>& fn) {
+        std::lock_guard<std::mutex> submitLock(submitMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobCount = count;
+            nextTask.store(0);
+            activeWorkers = (uint32_t)workers.size();
+            generation++;
+        }
+        wake.notify_all();
+
+        runTasks(fn, count);
+
+        std::exception_ptr failure;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return activeWorkers == 0; });
+            job = nullptr;
+            failure = error;
+            error = nullptr;
+        }
+        if (failure) std::rethrow_exception(failure);
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex               submitMutex; // one parallelFor in flight at a time
+    std::mutex               mutex;
+    std::condition_variable  wake;
+    std::condition_variable  done;
+
+    const std::function<void(uint32_t)>* job = nullptr;
+    uint32_t              jobCount = 0;
+    std::atomic<uint32_t> nextTask{ 0 };
+    uint32_t              activeWorkers = 0;
+    uint64_t              generation = 0;
+    bool                  stop = false;
+    std::exception_ptr    error;      // first exception thrown by a task of the current job
+
+    struct InsideParallelForScope {
+        bool previous = tInsideParallelFor;
+        InsideParallelForScope()  { tInsideParallelFor = true; }
+        ~InsideParallelForScope() { tInsideParallelFor = previous; }
+    };
+
+    // Never throws: a failing task records its exception for run() to rethrow
+    // on the calling thread and makes the remaining tasks of the job skip, so
+    // every thread still reaches the join.
+    void runTasks(const std::function<void(uint32_t)>& fn, uint32_t count) {
+        InsideParallelForScope scope;
+        for (uint32_t i = nextTask.fetch_add(1); i < count; i = nextTask.fetch_add(1)) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) error = std::current_exception();
+                nextTask.store(count);
+            }
+        }
+    }
+
+    void workerLoop() {
+        uint64_t seenGeneration = 0;
+        while (true) {
+            const std::function<void(uint32_t)>* fn;
+            uint32_t count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stop || generation != seenGeneration; });
+                if (stop) return;
+                seenGeneration = generation;
+                fn = job;
+                count = jobCount;
+            }
+
+            runTasks(*fn, count);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                activeWorkers--;
+            }
+            done.notify_one();
+        }
+    }
+};
+
+static ThreadPool& getThreadPool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+uint32_t getNumWorkerThreads() {
+    return getThreadPool().numThreads();
+}
+
+void parallelFor(uint32_t count, const std::function<void(uint32_t)>& fn) {
+    if (count == 0) return;
+    if (count == 1 || tInsideParallelFor || getThreadPool().numThreads() == 1) {
+        for (uint32_t i = 0; i < count; i++) fn(i);
+        return;
+    }
+    getThreadPool().run(count, fn);
+}
+
+} // namespace nanite
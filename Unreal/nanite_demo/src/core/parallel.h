@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace nanite {
+
+// Number of threads parallelFor can run tasks on (including the caller).
+uint32_t getNumWorkerThreads();
+
+// Run fn(i) for every i in [0, count) on a shared, persistent thread pool and
+// block until all tasks are done. The calling thread executes tasks as well.
+// Calls made from inside a task run serially on that thread.
+// If a task throws, the tasks not yet started are skipped and the first
+// exception is rethrown on the calling thread once all threads are done.
+void parallelFor(uint32_t count, const std::function<void(uint32_t)>& fn);
+
+} // namespace nanite
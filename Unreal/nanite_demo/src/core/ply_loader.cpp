@@ -0,0 +1,374 @@
+#include "mesh_loader.h"
+#include "mapped_file.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace nanite {
+
+// ---------- Header ----------
+
+enum class PlyType : uint8_t { Invalid, Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+struct PlyProperty {
+    std::string name;
+    PlyType     type      = PlyType::Invalid;  // value type (list element type for lists)
+    PlyType     countType = PlyType::Invalid;  // list length type; Invalid for scalars
+    uint32_t    offset    = 0;                 // byte offset inside a fixed-size element
+    bool isList() const { return countType != PlyType::Invalid; }
+};
+
+struct PlyElement {
+    std::string              name;
+    uint64_t                 count = 0;
+    std::vector<PlyProperty> properties;
+    uint32_t                 stride = 0;       // bytes per element; 0 if it has list properties
+
+    const PlyProperty* find(const char* propName) const {
+        for (const PlyProperty& p : properties)
+            if (p.name == propName) return &p;
+        return nullptr;
+    }
+};
+
+static PlyType parsePlyType(const std::string& s) {
+    if (s == "char"   || s == "int8")    return PlyType::Int8;
+    if (s == "uchar"  || s == "uint8")   return PlyType::UInt8;
+    if (s == "short"  || s == "int16")   return PlyType::Int16;
+    if (s == "ushort" || s == "uint16")  return PlyType::UInt16;
+    if (s == "int"    || s == "int32")   return PlyType::Int32;
+    if (s == "uint"   || s == "uint32")  return PlyType::UInt32;
+    if (s == "float"  || s == "float32") return PlyType::Float32;
+    if (s == "double" || s == "float64") return PlyType::Float64;
+    return PlyType::Invalid;
+}
+
+static uint32_t plyTypeSize(PlyType t) {
+    switch (t) {
+    case PlyType::Int8:  case PlyType::UInt8:   return 1;
+    case PlyType::Int16: case PlyType::UInt16:  return 2;
+    case PlyType::Int32: case PlyType::UInt32:  case PlyType::Float32: return 4;
+    case PlyType::Float64: return 8;
+    default: return 0;
+    }
+}
+
+// Read one little-endian scalar (unaligned) as double / as unsigned integer.
+static double readPlyFloat(const char* p, PlyType t) {
+    switch (t) {
+    case PlyType::Int8:    { int8_t v;   memcpy(&v, p, 1); return v; }
+    case PlyType::UInt8:   { uint8_t v;  memcpy(&v, p, 1); return v; }
+    case PlyType::Int16:   { int16_t v;  memcpy(&v, p, 2); return v; }
+    case PlyType::UInt16:  { uint16_t v; memcpy(&v, p, 2); return v; }
+    case PlyType::Int32:   { int32_t v;  memcpy(&v, p, 4); return v; }
+    case PlyType::UInt32:  { uint32_t v; memcpy(&v, p, 4); return v; }
+    case PlyType::Float32: { float v;    memcpy(&v, p, 4); return v; }
+    case PlyType::Float64: { double v;   memcpy(&v, p, 8); return v; }
+    default: return 0.0;
+    }
+}
+
+static uint32_t readPlyUInt(const char* p, PlyType t) {
+    switch (t) {
+    case PlyType::Int8:  case PlyType::UInt8:  { uint8_t v;  memcpy(&v, p, 1); return v; }
+    case PlyType::Int16: case PlyType::UInt16: { uint16_t v; memcpy(&v, p, 2); return v; }
+    case PlyType::Int32: case PlyType::UInt32: { uint32_t v; memcpy(&v, p, 4); return v; }
+    default: return (uint32_t)readPlyFloat(p, t);
+    }
+}
+
+// Parse the ASCII header. On success `payload` points at the first byte after
+// "end_header\n".
+static bool parsePlyHeader(const char* begin, const char* end, std::vector<PlyElement>& elements,
+                           const char*& payload, std::string& error)
+{
+    if (end - begin < 4 || memcmp(begin, "ply", 3) != 0) {
+        error = "missing 'ply' magic";
+        return false;
+    }
+
+    bool binaryLE = false;
+    const char* p = begin;
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', (size_t)(end - p)));
+        if (!lineEnd) break;
+        std::string line(p, lineEnd);
+        p = lineEnd + 1;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        char word[64] = {}, a[64] = {}, b[64] = {}, c[64] = {};
+        int n = sscanf(line.c_str(), "%63s %63s %63s %63s", word, a, b, c);
+        if (n <= 0) continue;
+        std::string key = word;
+
+        if (key == "format") {
+            if (strcmp(a, "binary_little_endian") != 0) {
+                error = std::string("unsupported format '") + a + "' (only binary_little_endian)";
+                return false;
+            }
+            binaryLE = true;
+        } else if (key == "element" && n >= 3) {
+            PlyElement e;
+            e.name = a;
+            e.count = strtoull(b, nullptr, 10);
+            elements.push_back(e);
+        } else if (key == "property" && n >= 3) {
+            if (elements.empty()) {
+                error = "property before element";
+                return false;
+            }
+            PlyProperty prop;
+            if (strcmp(a, "list") == 0 && n >= 4) {
+                prop.countType = parsePlyType(b);
+                prop.type = parsePlyType(c);
+                char name[64] = {};
+                sscanf(line.c_str(), "%*s %*s %*s %*s %63s", name);
+                prop.name = name;
+                if (prop.countType == PlyType::Invalid || prop.type == PlyType::Invalid) {
+                    error = "bad list property '" + line + "'";
+                    return false;
+                }
+            } else {
+                prop.type = parsePlyType(a);
+                prop.name = b;
+                if (prop.type == PlyType::Invalid) {
+                    error = "bad property '" + line + "'";
+                    return false;
+                }
+            }
+            elements.back().properties.push_back(prop);
+        } else if (key == "end_header") {
+            if (!binaryLE) {
+                error = "missing format line";
+                return false;
+            }
+            payload = p;
+            break;
+        }
+        // comment / obj_info lines are ignored
+    }
+    if (!payload) {
+        error = "missing end_header";
+        return false;
+    }
+
+    // Fixed-size elements get a stride and per-property offsets
+    for (PlyElement& e : elements) {
+        uint32_t offset = 0;
+        bool fixed = true;
+        for (PlyProperty& prop : e.properties) {
+            if (prop.isList()) { fixed = false; break; }
+            prop.offset = offset;
+            offset += plyTypeSize(prop.type);
+        }
+        e.stride = fixed ? offset : 0;
+    }
+    return true;
+}
+
+// Byte size of one variable-size element starting at p, or 0 if it runs past end.
+static size_t plyElementSize(const PlyElement& e, const char* p, const char* end) {
+    const char* q = p;
+    for (const PlyProperty& prop : e.properties) {
+        if (prop.isList()) {
+            uint32_t countSize = plyTypeSize(prop.countType);
+            if (q + countSize > end) return 0;
+            uint32_t count = readPlyUInt(q, prop.countType);
+            q += countSize + (size_t)count * plyTypeSize(prop.type);
+        } else {
+            q += plyTypeSize(prop.type);
+        }
+        if (q > end) return 0;
+    }
+    return (size_t)(q - p);
+}
+
+// ---------- Elements ----------
+
+static bool readPlyVertices(const PlyElement& e, const char*& p, const char* end, RawMesh& outMesh,
+                            bool& hasNormals)
+{
+    const PlyProperty* x  = e.find("x");
+    const PlyProperty* y  = e.find("y");
+    const PlyProperty* z  = e.find("z");
+    const PlyProperty* nx = e.find("nx");
+    const PlyProperty* ny = e.find("ny");
+    const PlyProperty* nz = e.find("nz");
+    if (!x || !y || !z || e.stride == 0) return false;
+    hasNormals = nx && ny && nz;
+
+    size_t count = (size_t)e.count;
+    if ((size_t)(end - p) / e.stride < count) return false;
+    outMesh.vertices.resize(count);
+
+    auto isFloatAt = [](const PlyProperty* prop, uint32_t offset) {
+        return prop && prop->type == PlyType::Float32 && prop->offset == offset;
+    };
+    bool floatXYZ = isFloatAt(x, 0) && isFloatAt(y, 4) && isFloatAt(z, 8);
+
+    if (floatXYZ && hasNormals && e.stride == sizeof(Vertex) &&
+        isFloatAt(nx, 12) && isFloatAt(ny, 16) && isFloatAt(nz, 20)) {
+        // The file layout is exactly `Vertex`: one bulk copy
+        static_assert(sizeof(Vertex) == 24, "Vertex is expected to be position + normal");
+        memcpy(outMesh.vertices.data(), p, count * sizeof(Vertex));
+    } else if (floatXYZ && !hasNormals) {
+        const char* src = p;
+        for (size_t i = 0; i < count; i++, src += e.stride) {
+            memcpy(&outMesh.vertices[i].position, src, 3 * sizeof(float));
+            outMesh.vertices[i].normal = glm::vec3(0, 1, 0);
+        }
+    } else {
+        const char* src = p;
+        for (size_t i = 0; i < count; i++, src += e.stride) {
+            Vertex& v = outMesh.vertices[i];
+            v.position = glm::vec3((float)readPlyFloat(src + x->offset, x->type),
+                                   (float)readPlyFloat(src + y->offset, y->type),
+                                   (float)readPlyFloat(src + z->offset, z->type));
+            v.normal = hasNormals
+                ? glm::vec3((float)readPlyFloat(src + nx->offset, nx->type),
+                            (float)readPlyFloat(src + ny->offset, ny->type),
+                            (float)readPlyFloat(src + nz->offset, nz->type))
+                : glm::vec3(0, 1, 0);
+        }
+    }
+    p += count * e.stride;
+
+    for (const Vertex& v : outMesh.vertices) outMesh.bounds.expand(v.position);
+    return true;
+}
+
+static bool readPlyFaces(const PlyElement& e, const char*& p, const char* end, RawMesh& outMesh) {
+    const PlyProperty* list = e.find("vertex_indices");
+    if (!list) list = e.find("vertex_index");
+    if (!list || !list->isList()) return false;
+
+    uint32_t countSize = plyTypeSize(list->countType);
+    uint32_t indexSize = plyTypeSize(list->type);
+    bool onlyList = e.properties.size() == 1;
+    bool u32Index = list->type == PlyType::Int32 || list->type == PlyType::UInt32;
+    uint32_t numVerts = (uint32_t)outMesh.vertices.size();
+
+    // Most files are all triangles; reserve for that
+    outMesh.indices.reserve((size_t)e.count * 3);
+    uint32_t poly[256];
+    uint64_t skipped = 0;
+
+    for (uint64_t f = 0; f < e.count; f++) {
+        if (onlyList && u32Index && countSize == 1 && p < end) {
+            // Common layout: uchar count + int32 indices, nothing else
+            uint32_t n = (uint8_t)*p;
+            if ((size_t)(end - p) < 1 + (size_t)n * 4) return false;
+            if (n == 3) {
+                size_t base = outMesh.indices.size();
+                outMesh.indices.resize(base + 3);
+                memcpy(&outMesh.indices[base], p + 1, 12);
+                p += 13;
+                if (outMesh.indices[base] >= numVerts || outMesh.indices[base + 1] >= numVerts ||
+                    outMesh.indices[base + 2] >= numVerts) {
+                    outMesh.indices.resize(base);
+                    skipped++;
+                }
+                continue;
+            }
+        }
+
+        if (plyElementSize(e, p, end) == 0) return false;
+        for (const PlyProperty& prop : e.properties) {
+            if (&prop != list) {
+                p += prop.isList() ? plyTypeSize(prop.countType) +
+                                     (size_t)readPlyUInt(p, prop.countType) * plyTypeSize(prop.type)
+                                   : plyTypeSize(prop.type);
+                continue;
+            }
+            uint32_t n = readPlyUInt(p, prop.countType);
+            p += countSize;
+            bool valid = n >= 3 && n <= 256;
+            for (uint32_t i = 0; i < n; i++, p += indexSize) {
+                if (i < 256) poly[i] = readPlyUInt(p, prop.type);
+                if (i < 256 && poly[i] >= numVerts) valid = false;
+            }
+            if (!valid) {
+                skipped++;
+                continue;
+            }
+            // Triangulate polygon as a fan
+            for (uint32_t i = 1; i + 1 < n; i++) {
+                outMesh.indices.push_back(poly[0]);
+                outMesh.indices.push_back(poly[i]);
+                outMesh.indices.push_back(poly[i + 1]);
+            }
+        }
+    }
+    if (skipped > 0) {
+        fprintf(stderr, "Warning: Skipped %llu invalid PLY faces\n", (unsigned long long)skipped);
+    }
+    return true;
+}
+
+// ---------- Loader ----------
+
+bool loadPLY(const std::string& filepath, RawMesh& outMesh) {
+    MappedFile file;
+    if (!file.open(filepath)) {
+        fprintf(stderr, "Error: Cannot open PLY file '%s'\n", filepath.c_str());
+        return false;
+    }
+
+    std::vector<PlyElement> elements;
+    const char* p = nullptr;
+    std::string error;
+    if (!parsePlyHeader(file.begin(), file.end(), elements, p, error)) {
+        fprintf(stderr, "Error: PLY file '%s': %s\n", filepath.c_str(), error.c_str());
+        return false;
+    }
+
+    outMesh.vertices.clear();
+    outMesh.indices.clear();
+    outMesh.bounds = {};
+
+    const char* end = file.end();
+    bool hasVertices = false, hasNormals = false;
+    for (const PlyElement& e : elements) {
+        bool ok = true;
+        if (e.name == "vertex") {
+            ok = readPlyVertices(e, p, end, outMesh, hasNormals);
+            hasVertices = ok;
+        } else if (e.name == "face") {
+            if (!hasVertices) {
+                fprintf(stderr, "Error: PLY file '%s' has faces before vertices\n", filepath.c_str());
+                return false;
+            }
+            ok = readPlyFaces(e, p, end, outMesh);
+        } else if (e.stride > 0) {
+            // Unused fixed-size element (edges, materials, ...)
+            if ((size_t)(end - p) / e.stride < e.count) ok = false;
+            else p += (size_t)e.count * e.stride;
+        } else {
+            for (uint64_t i = 0; i < e.count && ok; i++) {
+                size_t size = plyElementSize(e, p, end);
+                ok = size > 0;
+                p += size;
+            }
+        }
+        if (!ok) {
+            fprintf(stderr, "Error: PLY file '%s' has a truncated or unsupported '%s' element\n",
+                    filepath.c_str(), e.name.c_str());
+            return false;
+        }
+    }
+
+    if (outMesh.vertices.empty() || outMesh.indices.empty()) {
+        fprintf(stderr, "Error: PLY file '%s' has no geometry\n", filepath.c_str());
+        return false;
+    }
+
+    if (!hasNormals) {
+        computeVertexNormals(outMesh);
+    }
+
+    printf("  PLY loaded: %zu vertices, %u triangles (%.1f MB)\n",
+           outMesh.vertices.size(), outMesh.numTris(), file.size() / 1e6);
+    return true;
+}
+
+} // namespace nanite
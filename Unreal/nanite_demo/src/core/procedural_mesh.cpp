@@ -0,0 +1,353 @@
+#include "procedural_mesh.h"
+#include "parallel.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace nanite {
+
+// Largest triangle count whose index array still fits 32-bit corner offsets.
+static constexpr uint64_t MAX_PROCEDURAL_TRIS = 0xFFFFFFFFull / 3;
+
+static constexpr uint32_t TERRAIN_OCTAVES = 8;
+static constexpr float    TERRAIN_HEIGHT  = 0.3f;
+
+// City buildings: 5 faces (no bottom), each split into segments x segments quads.
+static constexpr uint32_t CITY_BOX_FACES     = 5;
+static constexpr uint32_t CITY_FACE_SEGMENTS = 8;
+static constexpr uint32_t CITY_FACE_VERTS    = (CITY_FACE_SEGMENTS + 1) * (CITY_FACE_SEGMENTS + 1);
+static constexpr uint32_t CITY_BOX_VERTS     = CITY_BOX_FACES * CITY_FACE_VERTS;
+static constexpr uint32_t CITY_BOX_TRIS      = CITY_BOX_FACES * 2 * CITY_FACE_SEGMENTS * CITY_FACE_SEGMENTS;
+
+// Run fn(begin, end) over [0, count) split into one range per thread.
+template<typename Fn>
+static void parallelRanges(uint32_t count, uint32_t numThreads, Fn&& fn) {
+    uint32_t numTasks = std::max(1u, std::min(numThreads, count));
+    parallelFor(numTasks, [&](uint32_t task) {
+        fn((uint32_t)((uint64_t)count * task / numTasks), (uint32_t)((uint64_t)count * (task + 1) / numTasks));
+    });
+}
+
+// Uniform float in [0, 1) from integer coordinates (fmix64 of the packed input).
+static inline float random01(uint32_t x, uint32_t y, uint32_t seed) {
+    uint64_t k = (((uint64_t)x << 32) | y) ^ ((uint64_t)seed * 0x9e3779b97f4a7c15ull);
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return (float)(k >> 40) * (1.0f / 16777216.0f);
+}
+
+static bool allocateMesh(uint64_t numVerts, uint64_t numTris, RawMesh& outMesh) {
+    if (numTris > MAX_PROCEDURAL_TRIS || numVerts >= INVALID_INDEX) {
+        fprintf(stderr, "Error: Procedural mesh of %llu triangles does not fit 32-bit indices\n",
+                (unsigned long long)numTris);
+        return false;
+    }
+    outMesh.vertices.clear();
+    outMesh.indices.clear();
+    outMesh.vertices.resize((size_t)numVerts);
+    outMesh.indices.resize((size_t)numTris * 3);
+    return true;
+}
+
+static void computeBounds(RawMesh& mesh, uint32_t numThreads) {
+    std::vector<AABB> taskBounds(numThreads);
+    uint32_t numVerts = (uint32_t)mesh.vertices.size();
+    parallelFor(numThreads, [&](uint32_t task) {
+        uint32_t end = (uint32_t)((uint64_t)numVerts * (task + 1) / numThreads);
+        for (uint32_t v = (uint32_t)((uint64_t)numVerts * task / numThreads); v < end; v++)
+            taskBounds[task].expand(mesh.vertices[v].position);
+    });
+    mesh.bounds = {};
+    for (const AABB& b : taskBounds) mesh.bounds.expand(b);
+}
+
+// ---------- Icosphere ----------
+
+static const float kIcoT = 1.6180339887f; // golden ratio
+static const glm::vec3 kIcoCorners[12] = {
+    { -1, kIcoT, 0 }, { 1, kIcoT, 0 }, { -1, -kIcoT, 0 }, { 1, -kIcoT, 0 },
+    { 0, -1, kIcoT }, { 0, 1, kIcoT }, { 0, -1, -kIcoT }, { 0, 1, -kIcoT },
+    { kIcoT, 0, -1 }, { kIcoT, 0, 1 }, { -kIcoT, 0, -1 }, { -kIcoT, 0, 1 },
+};
+// Counter-clockwise seen from outside
+static const uint32_t kIcoFaces[20][3] = {
+    { 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+    { 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+    { 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+    { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 },
+};
+
+// Each icosahedron face is a triangular lattice of n x n triangles, point
+// (i, j) = A + (B - A) i/n + (C - A) j/n. Vertices on the 12 corners and 30
+// edges are shared between faces: corners first, then n - 1 per edge (from
+// its lower corner), then each face's interior points.
+static bool generateIcosphere(const ProceduralMeshOptions& options, uint32_t numThreads, RawMesh& outMesh) {
+    uint32_t n = (uint32_t)std::max(1.0, std::round(std::sqrt((double)options.targetTris / 20.0)));
+    uint64_t numVerts = 10ull * n * n + 2;
+    if (!allocateMesh(numVerts, 20ull * n * n, outMesh)) return false;
+
+    uint32_t edges[30][2];
+    uint32_t faceEdges[20][3]; // edge of (A,B), (B,C), (A,C)
+    uint32_t numEdges = 0;
+    auto edgeOf = [&](uint32_t a, uint32_t b) {
+        if (a > b) std::swap(a, b);
+        for (uint32_t e = 0; e < numEdges; e++)
+            if (edges[e][0] == a && edges[e][1] == b) return e;
+        edges[numEdges][0] = a;
+        edges[numEdges][1] = b;
+        return numEdges++;
+    };
+    for (uint32_t f = 0; f < 20; f++) {
+        faceEdges[f][0] = edgeOf(kIcoFaces[f][0], kIcoFaces[f][1]);
+        faceEdges[f][1] = edgeOf(kIcoFaces[f][1], kIcoFaces[f][2]);
+        faceEdges[f][2] = edgeOf(kIcoFaces[f][0], kIcoFaces[f][2]);
+    }
+
+    const uint32_t edgeBase = 12;
+    const uint32_t interiorBase = edgeBase + 30 * (n - 1);
+    const uint32_t interiorPerFace = (n >= 2) ? (n - 1) * (n - 2) / 2 : 0;
+    auto setVertex = [&](uint32_t v, const glm::vec3& p) {
+        glm::vec3 unit = glm::normalize(p);
+        outMesh.vertices[v] = { unit, unit };
+    };
+    // k steps of n from corner `from` towards corner `to` along their edge
+    auto edgeVertex = [&](uint32_t e, uint32_t from, uint32_t k) {
+        return edgeBase + e * (n - 1) + (from == edges[e][0] ? k : n - k) - 1;
+    };
+
+    for (uint32_t c = 0; c < 12; c++) setVertex(c, kIcoCorners[c]);
+    parallelFor(30, [&](uint32_t e) {
+        const glm::vec3& a = kIcoCorners[edges[e][0]];
+        const glm::vec3& b = kIcoCorners[edges[e][1]];
+        for (uint32_t k = 1; k < n; k++) setVertex(edgeBase + e * (n - 1) + k - 1, glm::mix(a, b, (float)k / (float)n));
+    });
+
+    // Tasks cover row ranges of one face; rows shrink with j, so split them by
+    // triangle count. Row j starts at triangle 2nj - j^2 of its face.
+    uint32_t rangesPerFace = std::max(1u, std::min(n, (numThreads * 4 + 19) / 20));
+    std::vector<uint32_t> rowStart(rangesPerFace + 1, n);
+    for (uint32_t r = 0, j = 0; r < rangesPerFace; r++) {
+        uint64_t firstTri = (uint64_t)n * n * r / rangesPerFace;
+        while (2ull * n * j - (uint64_t)j * j < firstTri) j++;
+        rowStart[r] = j;
+    }
+
+    parallelFor(20 * rangesPerFace, [&](uint32_t task) {
+        uint32_t f = task / rangesPerFace, range = task % rangesPerFace;
+        uint32_t A = kIcoFaces[f][0], B = kIcoFaces[f][1], C = kIcoFaces[f][2];
+        glm::vec3 pa = kIcoCorners[A], ab = kIcoCorners[B] - pa, ac = kIcoCorners[C] - pa;
+        uint32_t faceInterior = interiorBase + f * interiorPerFace;
+        auto lattice = [&](uint32_t i, uint32_t j) -> uint32_t {
+            if (i == 0 && j == 0) return A;
+            if (j == 0) return i == n ? B : edgeVertex(faceEdges[f][0], A, i);
+            if (i == 0) return j == n ? C : edgeVertex(faceEdges[f][2], A, j);
+            if (i + j == n) return edgeVertex(faceEdges[f][1], B, j);
+            // Interior rows j = 1 .. n-2 hold i = 1 .. n-1-j
+            return faceInterior + (j - 1) * (n - 1) - (j - 1) * j / 2 + (i - 1);
+        };
+
+        uint32_t rowBegin = rowStart[range], rowEnd = rowStart[range + 1];
+        uint32_t* tri = &outMesh.indices[((size_t)f * n * n + 2ull * n * rowBegin - (size_t)rowBegin * rowBegin) * 3];
+        for (uint32_t j = rowBegin; j < rowEnd; j++) {
+            for (uint32_t i = 1; j > 0 && i + j < n; i++)
+                setVertex(lattice(i, j), pa + ab * ((float)i / (float)n) + ac * ((float)j / (float)n));
+            for (uint32_t i = 0; i + j < n; i++) {
+                *tri++ = lattice(i, j); *tri++ = lattice(i + 1, j); *tri++ = lattice(i, j + 1);
+                if (i + j + 1 < n) {
+                    *tri++ = lattice(i + 1, j); *tri++ = lattice(i + 1, j + 1); *tri++ = lattice(i, j + 1);
+                }
+            }
+        }
+    });
+    outMesh.bounds = {};
+    outMesh.bounds.expand(glm::vec3(-1.0f));
+    outMesh.bounds.expand(glm::vec3(1.0f));
+    return true;
+}
+
+// ---------- Terrain ----------
+
+static float valueNoise(float x, float y, uint32_t seed) {
+    float fx = std::floor(x), fy = std::floor(y);
+    uint32_t ix = (uint32_t)(int32_t)fx, iy = (uint32_t)(int32_t)fy;
+    float tx = x - fx, ty = y - fy;
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    ty = ty * ty * (3.0f - 2.0f * ty);
+    float v00 = random01(ix, iy, seed), v10 = random01(ix + 1, iy, seed);
+    float v01 = random01(ix, iy + 1, seed), v11 = random01(ix + 1, iy + 1, seed);
+    return glm::mix(glm::mix(v00, v10, tx), glm::mix(v01, v11, tx), ty);
+}
+
+static float terrainHeight(float x, float z, uint32_t seed) {
+    float h = 0.0f, amplitude = 0.5f, frequency = 2.0f;
+    for (uint32_t octave = 0; octave < TERRAIN_OCTAVES; octave++) {
+        h += amplitude * (valueNoise(x * frequency, z * frequency, seed + octave) * 2.0f - 1.0f);
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+    return h * TERRAIN_HEIGHT;
+}
+
+// (n+1) x (n+1) vertex grid over [-1, 1]^2 in XZ, two triangles per cell,
+// facing +Y. Normals are central differences of the neighbouring heights.
+static bool generateTerrain(const ProceduralMeshOptions& options, uint32_t numThreads, RawMesh& outMesh) {
+    uint32_t n = (uint32_t)std::max(1.0, std::round(std::sqrt((double)options.targetTris / 2.0)));
+    uint32_t row = n + 1;
+    if (!allocateMesh((uint64_t)row * row, 2ull * n * n, outMesh)) return false;
+    float step = 2.0f / (float)n;
+
+    parallelRanges(row, numThreads, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t z = begin; z < end; z++) {
+            for (uint32_t x = 0; x < row; x++) {
+                float px = -1.0f + step * (float)x, pz = -1.0f + step * (float)z;
+                outMesh.vertices[(size_t)z * row + x].position = glm::vec3(px, terrainHeight(px, pz, options.seed), pz);
+            }
+        }
+    });
+    parallelRanges(row, numThreads, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t z = begin; z < end; z++) {
+            for (uint32_t x = 0; x < row; x++) {
+                uint32_t x0 = x > 0 ? x - 1 : x, x1 = x < n ? x + 1 : x;
+                uint32_t z0 = z > 0 ? z - 1 : z, z1 = z < n ? z + 1 : z;
+                float dx = outMesh.vertices[(size_t)z * row + x1].position.y - outMesh.vertices[(size_t)z * row + x0].position.y;
+                float dz = outMesh.vertices[(size_t)z1 * row + x].position.y - outMesh.vertices[(size_t)z0 * row + x].position.y;
+                glm::vec3 normal(-dx / (step * (float)(x1 - x0)), 1.0f, -dz / (step * (float)(z1 - z0)));
+                outMesh.vertices[(size_t)z * row + x].normal = glm::normalize(normal);
+            }
+        }
+    });
+    parallelRanges(n, numThreads, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t z = begin; z < end; z++) {
+            uint32_t* tri = &outMesh.indices[(size_t)z * n * 6];
+            for (uint32_t x = 0; x < n; x++) {
+                uint32_t v00 = z * row + x, v10 = v00 + 1, v01 = v00 + row, v11 = v01 + 1;
+                *tri++ = v00; *tri++ = v01; *tri++ = v10;
+                *tri++ = v10; *tri++ = v01; *tri++ = v11;
+            }
+        }
+    });
+    computeBounds(outMesh, numThreads);
+    return true;
+}
+
+// ---------- City ----------
+
+// g x g buildings on [-1, 1]^2 in XZ, standing on y = 0. Each building is a
+// box with its own vertices per face (flat normals) and mostly low heights
+// with a few towers.
+static bool generateCity(const ProceduralMeshOptions& options, uint32_t numThreads, RawMesh& outMesh) {
+    uint32_t g = (uint32_t)std::max(1.0, std::round(std::sqrt((double)options.targetTris / CITY_BOX_TRIS)));
+    uint64_t numBoxes = (uint64_t)g * g;
+    if (!allocateMesh(numBoxes * CITY_BOX_VERTS, numBoxes * CITY_BOX_TRIS, outMesh)) return false;
+    float cell = 2.0f / (float)g;
+
+    parallelRanges(g, numThreads, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t bz = begin; bz < end; bz++) {
+            for (uint32_t bx = 0; bx < g; bx++) {
+                float r = random01(bx, bz, options.seed);
+                float height = cell * (0.5f + 8.0f * r * r * r);
+                glm::vec3 lo(-1.0f + cell * ((float)bx + 0.15f), 0.0f, -1.0f + cell * ((float)bz + 0.15f));
+                glm::vec3 hi(-1.0f + cell * ((float)bx + 0.85f), height, -1.0f + cell * ((float)bz + 0.85f));
+                glm::vec3 d = hi - lo;
+                // Per face: origin and two edge vectors with cross(u, v) pointing outward
+                const glm::vec3 faces[CITY_BOX_FACES][3] = {
+                    { { hi.x, lo.y, hi.z }, { 0, 0, -d.z }, { 0, d.y, 0 } },  // +X
+                    { { lo.x, lo.y, lo.z }, { 0, 0,  d.z }, { 0, d.y, 0 } },  // -X
+                    { { lo.x, lo.y, hi.z }, {  d.x, 0, 0 }, { 0, d.y, 0 } },  // +Z
+                    { { hi.x, lo.y, lo.z }, { -d.x, 0, 0 }, { 0, d.y, 0 } },  // -Z
+                    { { lo.x, hi.y, hi.z }, {  d.x, 0, 0 }, { 0, 0, -d.z } }, // +Y
+                };
+
+                uint32_t box = bz * g + bx;
+                uint32_t* tri = &outMesh.indices[(size_t)box * CITY_BOX_TRIS * 3];
+                for (uint32_t f = 0; f < CITY_BOX_FACES; f++) {
+                    const glm::vec3& origin = faces[f][0];
+                    const glm::vec3& u = faces[f][1];
+                    const glm::vec3& v = faces[f][2];
+                    glm::vec3 normal = glm::normalize(glm::cross(u, v));
+                    uint32_t base = box * CITY_BOX_VERTS + f * CITY_FACE_VERTS;
+                    for (uint32_t b = 0; b <= CITY_FACE_SEGMENTS; b++) {
+                        for (uint32_t a = 0; a <= CITY_FACE_SEGMENTS; a++) {
+                            glm::vec3 p = origin + u * ((float)a / CITY_FACE_SEGMENTS) + v * ((float)b / CITY_FACE_SEGMENTS);
+                            outMesh.vertices[base + b * (CITY_FACE_SEGMENTS + 1) + a] = { p, normal };
+                        }
+                    }
+                    for (uint32_t b = 0; b < CITY_FACE_SEGMENTS; b++) {
+                        for (uint32_t a = 0; a < CITY_FACE_SEGMENTS; a++) {
+                            uint32_t v00 = base + b * (CITY_FACE_SEGMENTS + 1) + a;
+                            uint32_t v10 = v00 + 1, v01 = v00 + CITY_FACE_SEGMENTS + 1, v11 = v01 + 1;
+                            *tri++ = v00; *tri++ = v10; *tri++ = v01;
+                            *tri++ = v10; *tri++ = v11; *tri++ = v01;
+                        }
+                    }
+                }
+            }
+        }
+    });
+    computeBounds(outMesh, numThreads);
+    return true;
+}
+
+// ---------- Entry points ----------
+
+static const char* PROCEDURAL_PREFIX = "proc:";
+
+bool isProceduralMeshSpec(const std::string& path) {
+    return path.compare(0, strlen(PROCEDURAL_PREFIX), PROCEDURAL_PREFIX) == 0;
+}
+
+bool parseProceduralMeshSpec(const std::string& spec, ProceduralMeshOptions& outOptions) {
+    auto fail = [&]() {
+        fprintf(stderr, "Error: Bad procedural mesh '%s' (expected proc:<icosphere|terrain|city>:<triangles>[:seed])\n",
+                spec.c_str());
+        return false;
+    };
+    if (!isProceduralMeshSpec(spec)) return fail();
+
+    std::vector<std::string> parts;
+    size_t start = strlen(PROCEDURAL_PREFIX);
+    while (true) {
+        size_t colon = spec.find(':', start);
+        parts.push_back(spec.substr(start, colon == std::string::npos ? std::string::npos : colon - start));
+        if (colon == std::string::npos) break;
+        start = colon + 1;
+    }
+    if (parts.size() < 2 || parts.size() > 3) return fail();
+
+    ProceduralMeshOptions options = outOptions;
+    if (parts[0] == "icosphere")    options.shape = ProceduralShape::Icosphere;
+    else if (parts[0] == "terrain") options.shape = ProceduralShape::Terrain;
+    else if (parts[0] == "city")    options.shape = ProceduralShape::City;
+    else return fail();
+
+    char* end = nullptr;
+    double count = strtod(parts[1].c_str(), &end);
+    if (end == parts[1].c_str()) return fail();
+    if (*end == 'K' || *end == 'k') { count *= 1e3; end++; }
+    else if (*end == 'M' || *end == 'm') { count *= 1e6; end++; }
+    else if (*end == 'G' || *end == 'g') { count *= 1e9; end++; }
+    if (*end != '\0' || count < 1.0) return fail();
+    options.targetTris = (uint64_t)count;
+
+    if (parts.size() == 3) {
+        options.seed = (uint32_t)strtoul(parts[2].c_str(), &end, 10);
+        if (parts[2].empty() || *end != '\0') return fail();
+    }
+    outOptions = options;
+    return true;
+}
+
+bool generateProceduralMesh(const ProceduralMeshOptions& options, RawMesh& outMesh) {
+    uint32_t numThreads = options.numThreads ? options.numThreads : getNumWorkerThreads();
+    switch (options.shape) {
+    case ProceduralShape::Icosphere: return generateIcosphere(options, numThreads, outMesh);
+    case ProceduralShape::Terrain:   return generateTerrain(options, numThreads, outMesh);
+    case ProceduralShape::City:      return generateCity(options, numThreads, outMesh);
+    }
+    return false;
+}
+
+} // namespace nanite
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "mesh_loader.h"
+
+namespace nanite {
+
+enum class ProceduralShape {
+    Icosphere,  // unit sphere: icosahedron with each face split into n x n triangles
+    Terrain,    // fBm value-noise heightfield over [-1, 1] x [-1, 1]
+    City,       // grid of boxes of random height, each face tessellated
+};
+
+struct ProceduralMeshOptions {
+    ProceduralShape shape = ProceduralShape::Icosphere;
+    // Approximate triangle count; the generator picks the nearest resolution
+    // its shape allows.
+    uint64_t        targetTris = 1000000;
+    uint32_t        seed = 1;
+    // Threads: 0 = all worker threads. The result is identical for every count.
+    uint32_t        numThreads = 0;
+};
+
+// Procedural meshes are named like files so every tool that takes a mesh
+// path can use them: "proc:<icosphere|terrain|city>:<triangles>[:seed]",
+// where the count may end in K, M or G (e.g. "proc:terrain:100M").
+bool isProceduralMeshSpec(const std::string& path);
+
+// Parse a "proc:..." name. Returns false (with a message) if it is malformed.
+bool parseProceduralMeshSpec(const std::string& spec, ProceduralMeshOptions& outOptions);
+
+// Fill `outMesh` directly (no file I/O), vertices and triangles written in
+// parallel into preallocated arrays. Vertices are shared, normals are exact
+// (sphere, flat box faces) or from height differences (terrain), and the
+// mesh is already clean: no duplicate vertices or degenerate triangles.
+// Returns false if the requested size does not fit 32-bit indices.
+bool generateProceduralMesh(const ProceduralMeshOptions& options, RawMesh& outMesh);
+
+} // namespace nanite
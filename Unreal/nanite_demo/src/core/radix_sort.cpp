@@ -0,0 +1,177 @@
+#include "radix_sort.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstring>
+
+namespace nanite {
+
+// LSD digit width; MSD digits widen up to MAX_MSD_BITS on large ranges so a
+// single split reaches cache-sized buckets.
+static constexpr uint32_t RADIX_BITS = 8;
+static constexpr uint32_t RADIX_BUCKETS = 1u << RADIX_BITS;
+static constexpr uint32_t MAX_MSD_BITS = 12;
+// At or below this many items an insertion sort beats the histogram passes.
+static constexpr uint32_t INSERTION_SORT_MAX = 64;
+// Ranges up to this many items (and their scratch) stay in L2, where LSD
+// passes are cheap. Larger ranges are first split by their top digit.
+static constexpr uint32_t CACHE_SORT_MAX = 16 * 1024;
+// Ranges needing more LSD passes than this are split by their top digit
+// instead: a few MSD levels get them down to insertion-sort size sooner.
+static constexpr uint32_t LSD_MAX_DIGITS = 2;
+// Items per task below which splitting does not pay off.
+static constexpr uint32_t MIN_TASK_ITEMS = 64 * 1024;
+
+template<typename Key>
+static uint32_t digitOf(Key key, uint32_t shift, uint32_t mask) {
+    return (uint32_t)(key >> shift) & mask;
+}
+
+// Number of low bits in which the keys of a range differ from `reference`.
+template<typename Key>
+static uint32_t differingBits(const RadixSortItem<Key>* items, uint32_t count, Key reference) {
+    Key diff = 0;
+    for (uint32_t i = 0; i < count; i++) diff |= items[i].key ^ reference;
+    uint32_t bits = 0;
+    for (; diff != 0; diff >>= 1) bits++;
+    return bits;
+}
+
+// Width of the MSD digit for a range: enough for cache-sized buckets.
+static uint32_t msdDigitBits(uint32_t count, uint32_t bits) {
+    uint32_t width = RADIX_BITS;
+    while (width < MAX_MSD_BITS && (count >> width) > CACHE_SORT_MAX) width++;
+    return std::min(width, bits);
+}
+
+template<typename Key>
+static void insertionSort(RadixSortItem<Key>* items, uint32_t count) {
+    for (uint32_t i = 1; i < count; i++) {
+        RadixSortItem<Key> item = items[i];
+        uint32_t j = i;
+        for (; j > 0 && items[j - 1].key > item.key; j--) items[j] = items[j - 1];
+        items[j] = item;
+    }
+}
+
+// Stable counting-sort pass by the digit at `shift`, given its histogram.
+// `offsets` (numBuckets entries) is scratch.
+template<typename Key>
+static void scatterPass(const RadixSortItem<Key>* src, RadixSortItem<Key>* dst, uint32_t count,
+                        uint32_t shift, uint32_t numBuckets, const uint32_t* histogram, uint32_t* offsets)
+{
+    for (uint32_t b = 0, offset = 0; b < numBuckets; b++) {
+        offsets[b] = offset;
+        offset += histogram[b];
+    }
+    for (uint32_t i = 0; i < count; i++) dst[offsets[digitOf(src[i].key, shift, numBuckets - 1)]++] = src[i];
+}
+
+// Sort `data` by the low `bits` bits of its keys (the higher bits are equal),
+// using `scratch` (same size). The result ends up in `data`.
+template<typename Key>
+static void sortRange(RadixSortItem<Key>* data, RadixSortItem<Key>* scratch, uint32_t count, uint32_t bits) {
+    if (count <= INSERTION_SORT_MAX) {
+        insertionSort(data, count);
+        return;
+    }
+    bits = std::min(bits, differingBits(data, count, data[0].key));
+    if (bits == 0) return;
+
+    if (bits > LSD_MAX_DIGITS * RADIX_BITS || (count > CACHE_SORT_MAX && bits > RADIX_BITS)) {
+        // MSD: split by the top digit, then sort each bucket (in cache once small)
+        uint32_t width = msdDigitBits(count, bits);
+        uint32_t shift = bits - width, numBuckets = 1u << width;
+        std::vector<uint32_t> histogram(numBuckets, 0), offsets(numBuckets);
+        for (uint32_t i = 0; i < count; i++) histogram[digitOf(data[i].key, shift, numBuckets - 1)]++;
+        scatterPass(data, scratch, count, shift, numBuckets, histogram.data(), offsets.data());
+        for (uint32_t b = 0, start = 0; b < numBuckets; start += histogram[b++]) {
+            sortRange(scratch + start, data + start, histogram[b], shift);
+        }
+        memcpy(data, scratch, sizeof(RadixSortItem<Key>) * count);
+        return;
+    }
+
+    // LSD over the digits that are not the same in every key
+    uint32_t numDigits = (bits + RADIX_BITS - 1) / RADIX_BITS;
+    uint32_t histograms[LSD_MAX_DIGITS][RADIX_BUCKETS] = {};
+    uint32_t offsets[RADIX_BUCKETS];
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t d = 0; d < numDigits; d++) histograms[d][digitOf(data[i].key, d * RADIX_BITS, RADIX_BUCKETS - 1)]++;
+    }
+    RadixSortItem<Key>* src = data;
+    RadixSortItem<Key>* dst = scratch;
+    for (uint32_t d = 0; d < numDigits; d++) {
+        if (histograms[d][digitOf(src[0].key, d * RADIX_BITS, RADIX_BUCKETS - 1)] == count) continue;
+        scatterPass(src, dst, count, d * RADIX_BITS, RADIX_BUCKETS, histograms[d], offsets);
+        std::swap(src, dst);
+    }
+    if (src != data) memcpy(data, src, sizeof(RadixSortItem<Key>) * count);
+}
+
+template<typename Key>
+void radixSort(std::vector<RadixSortItem<Key>>& items, uint32_t numThreads) {
+    uint32_t count = (uint32_t)items.size();
+    if (count <= INSERTION_SORT_MAX) {
+        insertionSort(items.data(), count);
+        return;
+    }
+    if (numThreads == 0) numThreads = getNumWorkerThreads();
+    uint32_t numTasks = std::max(1u, std::min(numThreads, count / MIN_TASK_ITEMS));
+    std::vector<RadixSortItem<Key>> scratch(count);
+    if (numTasks == 1) {
+        sortRange(items.data(), scratch.data(), count, (uint32_t)sizeof(Key) * 8);
+        return;
+    }
+
+    // Parallel MSD pass: each task counts its range, then scatters it to
+    // offsets ordered by (digit, task), which keeps equal keys in input order
+    auto taskBegin = [&](uint32_t task) { return (uint32_t)((uint64_t)count * task / numTasks); };
+    std::vector<uint32_t> taskBits(numTasks);
+    parallelFor(numTasks, [&](uint32_t task) {
+        uint32_t begin = taskBegin(task);
+        taskBits[task] = differingBits(&items[begin], taskBegin(task + 1) - begin, items[0].key);
+    });
+    uint32_t bits = *std::max_element(taskBits.begin(), taskBits.end());
+    if (bits <= RADIX_BITS) {
+        sortRange(items.data(), scratch.data(), count, bits);
+        return;
+    }
+    uint32_t width = msdDigitBits(count, bits);
+    uint32_t shift = bits - width, numBuckets = 1u << width;
+
+    std::vector<uint32_t> histograms((size_t)numTasks * numBuckets, 0);
+    parallelFor(numTasks, [&](uint32_t task) {
+        uint32_t* histogram = &histograms[(size_t)task * numBuckets];
+        for (uint32_t i = taskBegin(task), end = taskBegin(task + 1); i < end; i++)
+            histogram[digitOf(items[i].key, shift, numBuckets - 1)]++;
+    });
+    std::vector<uint32_t> offsets((size_t)numTasks * numBuckets);
+    std::vector<uint32_t> bucketStart(numBuckets + 1);
+    uint32_t offset = 0;
+    for (uint32_t b = 0; b < numBuckets; b++) {
+        bucketStart[b] = offset;
+        for (uint32_t task = 0; task < numTasks; task++) {
+            offsets[(size_t)task * numBuckets + b] = offset;
+            offset += histograms[(size_t)task * numBuckets + b];
+        }
+    }
+    bucketStart[numBuckets] = count;
+    parallelFor(numTasks, [&](uint32_t task) {
+        uint32_t* taskOffsets = &offsets[(size_t)task * numBuckets];
+        for (uint32_t i = taskBegin(task), end = taskBegin(task + 1); i < end; i++)
+            scratch[taskOffsets[digitOf(items[i].key, shift, numBuckets - 1)]++] = items[i];
+    });
+
+    // Buckets are independent: sort each one and copy it back
+    parallelFor(numBuckets, [&](uint32_t b) {
+        uint32_t start = bucketStart[b], size = bucketStart[b + 1] - start;
+        if (size == 0) return;
+        sortRange(scratch.data() + start, items.data() + start, size, shift);
+        memcpy(items.data() + start, scratch.data() + start, sizeof(RadixSortItem<Key>) * size);
+    });
+}
+
+template void radixSort<uint32_t>(std::vector<RadixSortItem<uint32_t>>&, uint32_t);
+template void radixSort<uint64_t>(std::vector<RadixSortItem<uint64_t>>&, uint32_t);
+
+} // namespace nanite
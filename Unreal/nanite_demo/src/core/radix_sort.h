@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace nanite {
+
+// Sort key with the index of the item it belongs to.
+template<typename Key>
+struct RadixSortItem {
+    Key      key;
+    uint32_t index;
+};
+
+// Stable radix sort by key, equal to std::stable_sort by key and identical
+// for every thread count. Only the low bits in which keys differ are sorted.
+// Large ranges are split by their top digit (MSD, widened up to 12 bits so
+// buckets reach cache size; in parallel at the top level: each task counts
+// its range, then scatters it to offsets ordered by (digit, task)); buckets
+// with at most two 8-bit digits left are finished with in-cache LSD passes,
+// small ones with an insertion sort.
+// numThreads: 0 = all worker threads. Implemented for uint32_t and uint64_t keys.
+template<typename Key>
+void radixSort(std::vector<RadixSortItem<Key>>& items, uint32_t numThreads = 0);
+
+} // namespace nanite
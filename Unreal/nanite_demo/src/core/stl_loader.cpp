@@ -0,0 +1,96 @@
+#include "mesh_loader.h"
+#include "mapped_file.h"
+#include "flat_hash_map.h"
+#include <cstdio>
+#include <cstring>
+
+namespace nanite {
+
+// Binary STL: 80-byte header, uint32 triangle count, then per triangle
+// 50 bytes: facet normal (3 floats), 3 corner positions (9 floats), uint16 attribute.
+static constexpr size_t STL_HEADER_BYTES   = 84;
+static constexpr size_t STL_TRIANGLE_BYTES = 50;
+
+// 64-bit key for a position. Distinct positions can share a key, so a hit
+// is confirmed by comparing positions and a mismatch moves on to a derived key.
+static inline uint64_t positionKey(const glm::vec3& p) {
+    uint32_t bits[3];
+    memcpy(bits, &p, sizeof(bits));
+    uint64_t h = FlatHashMap64::hash(((uint64_t)bits[0] << 32) | bits[1]);
+    h = FlatHashMap64::hash(h ^ bits[2]);
+    return h == FlatHashMap64::EMPTY_KEY ? 0 : h;
+}
+
+// Weld corners with bit-identical positions (-0.0 and 0.0 are treated as
+// equal). Vertices are numbered in order of first use.
+static void weldCorners(const std::vector<glm::vec3>& corners, RawMesh& outMesh) {
+    size_t numCorners = corners.size();
+    // Closed surfaces have about half as many vertices as triangles
+    FlatHashMap64 vertMap(numCorners / 6 + 16);
+    outMesh.indices.resize(numCorners);
+    outMesh.vertices.clear();
+    outMesh.vertices.reserve(numCorners / 6 + 16);
+
+    for (size_t i = 0; i < numCorners; i++) {
+        glm::vec3 pos = corners[i] + glm::vec3(0.0f); // folds -0.0f into 0.0f
+        uint32_t newIdx = (uint32_t)outMesh.vertices.size();
+        uint32_t idx;
+        // On a key collision retry with a rehashed key (made even, so never EMPTY_KEY)
+        for (uint64_t key = positionKey(pos);; key = FlatHashMap64::hash(key) & ~1ull) {
+            bool inserted;
+            idx = vertMap.findOrInsert(key, newIdx, inserted);
+            if (inserted) {
+                Vertex v;
+                v.position = pos;
+                v.normal = glm::vec3(0, 1, 0);
+                outMesh.vertices.push_back(v);
+                outMesh.bounds.expand(pos);
+                break;
+            }
+            if (outMesh.vertices[idx].position == pos) break;
+        }
+        outMesh.indices[i] = idx;
+    }
+}
+
+bool loadSTL(const std::string& filepath, RawMesh& outMesh) {
+    MappedFile file;
+    if (!file.open(filepath)) {
+        fprintf(stderr, "Error: Cannot open STL file '%s'\n", filepath.c_str());
+        return false;
+    }
+
+    uint32_t numTris = 0;
+    if (file.size() >= STL_HEADER_BYTES) memcpy(&numTris, file.data() + 80, 4);
+    if (file.size() < STL_HEADER_BYTES || file.size() != STL_HEADER_BYTES + (size_t)numTris * STL_TRIANGLE_BYTES) {
+        bool ascii = file.size() >= 5 && memcmp(file.data(), "solid", 5) == 0;
+        fprintf(stderr, "Error: STL file '%s' is %s\n", filepath.c_str(),
+                ascii ? "ASCII (only binary STL is supported)" : "truncated or not a binary STL");
+        return false;
+    }
+    if (numTris == 0) {
+        fprintf(stderr, "Error: STL file '%s' has no geometry\n", filepath.c_str());
+        return false;
+    }
+
+    // Corner positions, 36 contiguous bytes per triangle
+    std::vector<glm::vec3> corners((size_t)numTris * 3);
+    const char* src = file.data() + STL_HEADER_BYTES + 12; // skip the facet normal
+    for (uint32_t t = 0; t < numTris; t++, src += STL_TRIANGLE_BYTES) {
+        memcpy(&corners[(size_t)t * 3], src, 9 * sizeof(float));
+    }
+
+    outMesh.vertices.clear();
+    outMesh.indices.clear();
+    outMesh.bounds = {};
+    weldCorners(corners, outMesh);
+
+    // Facet normals would give flat shading; the DAG wants smooth vertex normals
+    computeVertexNormals(outMesh);
+
+    printf("  STL loaded: %zu vertices (welded from %zu corners), %u triangles\n",
+           outMesh.vertices.size(), corners.size(), outMesh.numTris());
+    return true;
+}
+
+} // namespace nanite
@@ -13,13 +13,51 @@
 namespace nanite {
 
 // --- Constants (matching UE5 Nanite conventions) ---
-constexpr uint32_t CLUSTER_SIZE       = 128;   // Max triangles per cluster
-constexpr uint32_t MIN_CLUSTER_SIZE   = 64;    // Min triangles per cluster when splitting
-constexpr uint32_t MIN_GROUP_SIZE     = 4;     // Min clusters per group
-constexpr uint32_t MAX_GROUP_SIZE     = 32;    // Max clusters per group
-constexpr float    MAX_PIXELS_PER_EDGE = 1.0f; // Default screen-space error threshold
+constexpr uint32_t MAX_CLUSTER_VERTICES = 256; // Max vertices per cluster (8-bit local indices)
+constexpr float    MAX_PIXELS_PER_EDGE = 2.0f; // Default screen-space error threshold
 constexpr uint32_t INVALID_INDEX      = 0xFFFFFFFF;
 
+// --- Cluster size configurations ---
+// Build parameters that scale with the cluster size, as a compile-time
+// policy: the build kernels are instantiated per configuration, so their
+// per-cluster stack buffers and loop bounds are constants. The encoding
+// (8-bit local indices) is the same for all of them.
+template<uint32_t MaxTris>
+struct ClusterConfig {
+    static constexpr uint32_t CLUSTER_SIZE     = MaxTris;      // Max triangles per cluster
+    static constexpr uint32_t MIN_CLUSTER_SIZE = MaxTris / 2;  // Min triangles per cluster when splitting
+    // Max vertices per cluster: two per triangle leaves room for ragged
+    // borders, up to the 8-bit index limit
+    static constexpr uint32_t MAX_VERTICES     = std::min(MaxTris * 2, MAX_CLUSTER_VERTICES);
+    static constexpr uint32_t MIN_GROUP_SIZE   = 4;            // Min clusters per group
+    static constexpr uint32_t MAX_GROUP_SIZE   = 32;           // Max clusters per group
+};
+
+// The configurations built in; an asset picks one at runtime.
+enum class ClusterSize : uint32_t {
+    Tris64  = 64,
+    Tris128 = 128,   // default (matches UE5 Nanite)
+    Tris256 = 256,
+};
+using DefaultClusterConfig = ClusterConfig<128>;
+
+// ClusterSize with `tris` triangles per cluster; false if none has that many.
+inline bool clusterSizeFromTris(uint32_t tris, ClusterSize& out) {
+    if (tris != 64 && tris != 128 && tris != 256) return false;
+    out = (ClusterSize)tris;
+    return true;
+}
+
+// Call fn(ClusterConfig<N>{}) with the configuration of `size`.
+template<typename Fn>
+decltype(auto) withClusterConfig(ClusterSize size, Fn&& fn) {
+    switch (size) {
+    case ClusterSize::Tris64:  return fn(ClusterConfig<64>{});
+    case ClusterSize::Tris256: return fn(ClusterConfig<256>{});
+    default:                   return fn(ClusterConfig<128>{});
+    }
+}
+
 // --- Axis-Aligned Bounding Box ---
 struct AABB {
     glm::vec3 min = glm::vec3( std::numeric_limits<float>::max());
@@ -64,26 +102,97 @@ struct BoundingSphere {
         return s;
     }
 
-    static BoundingSphere fromSpheres(const BoundingSphere* spheres, uint32_t count) {
+    // Enclosing sphere of sphere(0) .. sphere(count - 1) (points are spheres
+    // of radius 0), Ritter-style: start from the widest of the pairs of
+    // extremes along x, y and z, then grow just enough to take in each sphere
+    // still outside. Typically within a few percent of the minimal sphere.
+    static constexpr int REFINE_STEPS = 16;
+    template<typename GetSphere>
+    static BoundingSphere enclose(uint32_t count, const GetSphere& sphere) {
         if (count == 0) return {};
-        BoundingSphere result = spheres[0];
+        uint32_t lo[3] = { 0, 0, 0 }, hi[3] = { 0, 0, 0 };
         for (uint32_t i = 1; i < count; i++) {
-            result = merge(result, spheres[i]);
+            BoundingSphere s = sphere(i);
+            for (int a = 0; a < 3; a++) {
+                BoundingSphere l = sphere(lo[a]), h = sphere(hi[a]);
+                if (s.center[a] - s.radius < l.center[a] - l.radius) lo[a] = i;
+                if (s.center[a] + s.radius > h.center[a] + h.radius) hi[a] = i;
+            }
+        }
+        int widest = 0;
+        float widestSpan = -1.0f;
+        for (int a = 0; a < 3; a++) {
+            BoundingSphere l = sphere(lo[a]), h = sphere(hi[a]);
+            float span = glm::distance(l.center, h.center) + l.radius + h.radius;
+            if (span > widestSpan) { widestSpan = span; widest = a; }
+        }
+
+        BoundingSphere result = sphere(lo[widest]);
+        auto grow = [&](const BoundingSphere& s) {
+            glm::vec3 d = s.center - result.center;
+            float dist = glm::length(d);
+            if (dist + s.radius <= result.radius) return;                // inside
+            if (dist + result.radius <= s.radius) { result = s; return; } // encloses result
+            float newRadius = (dist + result.radius + s.radius) * 0.5f;
+            result.center += d * ((newRadius - result.radius) / dist);
+            result.radius = newRadius;
+        };
+        grow(sphere(hi[widest]));
+        for (uint32_t i = 0; i < count; i++) grow(sphere(i));
+
+        // Exact radius about a center (growth steps round); also returns the
+        // farthest point of the spheres
+        auto radiusAbout = [&](const glm::vec3& center, glm::vec3& farthest) {
+            float radius = -1.0f;
+            for (uint32_t i = 0; i < count; i++) {
+                BoundingSphere s = sphere(i);
+                glm::vec3 d = s.center - center;
+                float dist = glm::length(d);
+                if (dist + s.radius > radius) {
+                    radius = dist + s.radius;
+                    farthest = dist > 0.0f ? s.center + d * (s.radius / dist) : s.center;
+                }
+            }
+            return radius;
+        };
+        glm::vec3 farthest = result.center;
+        result.radius = radiusAbout(result.center, farthest);
+
+        // Ritter's sphere is off-center toward the spheres taken in last: pull
+        // the center toward the farthest point in shrinking steps (as in
+        // Badoiu-Clarkson) and keep the best
+        glm::vec3 center = result.center;
+        for (int k = 0; k < REFINE_STEPS; k++) {
+            center += (farthest - center) * (1.0f / (float)(k + 4));
+            float radius = radiusAbout(center, farthest);
+            if (radius < result.radius) result = { center, radius };
         }
         return result;
     }
 
-    static BoundingSphere fromPoints(const glm::vec3* points, uint32_t count) {
-        if (count == 0) return {};
-        // Simple bounding sphere: center = centroid, radius = max distance
-        glm::vec3 c(0.0f);
-        for (uint32_t i = 0; i < count; i++) c += points[i];
-        c /= (float)count;
-        float r = 0.0f;
-        for (uint32_t i = 0; i < count; i++) {
-            r = std::max(r, glm::distance(c, points[i]));
-        }
-        return { c, r };
+    static BoundingSphere fromSpheres(const BoundingSphere* spheres, uint32_t count) {
+        return enclose(count, [&](uint32_t i) { return spheres[i]; });
+    }
+
+    // Points are read `stride` bytes apart (e.g. the positions of Vertex[]).
+    static BoundingSphere fromPoints(const glm::vec3* points, uint32_t count, size_t stride = sizeof(glm::vec3)) {
+        return enclose(count, [&](uint32_t i) {
+            return BoundingSphere{ *(const glm::vec3*)((const char*)points + i * stride), 0.0f };
+        });
+    }
+};
+
+// --- Normal Cone ---
+// Bounds the facing of a set of triangles: seen from any eye inside the cone
+// (apex, axis, cutoff = cos of the half-angle), every triangle shows its back.
+struct NormalCone {
+    glm::vec3 apex   = glm::vec3(0.0f);
+    glm::vec3 axis   = glm::vec3(0.0f, 0.0f, 1.0f);
+    float     cutoff = 1.0f;    // 1 = empty cone (triangles face too many ways)
+
+    bool backfacing(const glm::vec3& eye) const {
+        glm::vec3 d = apex - eye;
+        return cutoff < 1.0f && glm::dot(d, axis) >= cutoff * glm::length(d);
     }
 };
 
@@ -0,0 +1,174 @@
+#include "mesh_loader.h"
+#include "parallel.h"
+
+namespace nanite {
+
+// Triangles (or vertices) per task below which splitting does not pay off.
+static constexpr uint32_t MIN_TASK_TRIS = 64 * 1024;
+// The parallel path does about four times the work of the serial scatter
+// (face normals are stored, corners routed to their owners), so it needs
+// this many tasks to come out clearly ahead.
+static constexpr uint32_t MIN_PARALLEL_TASKS = 8;
+// Triangles per block. Edge vectors are gathered into flat float arrays
+// first, so the cross product and angle loops over a block vectorize.
+static constexpr uint32_t BLOCK = 64;
+
+// Weighted face normals of one block of triangles.
+// Area weighting: the unnormalized cross product, one vector per triangle (index i).
+// Angle weighting: the unit normal scaled by the interior angle at each
+// corner, one vector per corner (index i * 3 + k).
+struct FaceBlock {
+    alignas(32) float x[BLOCK * 3];
+    alignas(32) float y[BLOCK * 3];
+    alignas(32) float z[BLOCK * 3];
+};
+
+static void computeFaceBlock(const RawMesh& mesh, uint32_t t0, uint32_t n, bool angleWeights,
+                             FaceBlock& out)
+{
+    alignas(32) float ax[BLOCK], ay[BLOCK], az[BLOCK];  // p1 - p0
+    alignas(32) float bx[BLOCK], by[BLOCK], bz[BLOCK];  // p2 - p0
+    const uint32_t* idx = &mesh.indices[(size_t)t0 * 3];
+    for (uint32_t i = 0; i < n; i++) {
+        const glm::vec3& p0 = mesh.vertices[idx[i * 3 + 0]].position;
+        const glm::vec3& p1 = mesh.vertices[idx[i * 3 + 1]].position;
+        const glm::vec3& p2 = mesh.vertices[idx[i * 3 + 2]].position;
+        ax[i] = p1.x - p0.x; ay[i] = p1.y - p0.y; az[i] = p1.z - p0.z;
+        bx[i] = p2.x - p0.x; by[i] = p2.y - p0.y; bz[i] = p2.z - p0.z;
+    }
+    // Same operand order as glm::cross, so the sums match a scalar loop bit for bit
+    for (uint32_t i = 0; i < n; i++) {
+        out.x[i] = ay[i] * bz[i] - by[i] * az[i];
+        out.y[i] = az[i] * bx[i] - bz[i] * ax[i];
+        out.z[i] = ax[i] * by[i] - bx[i] * ay[i];
+    }
+    if (!angleWeights) return;
+
+    alignas(32) float w0[BLOCK], w1[BLOCK], w2[BLOCK];
+    for (uint32_t i = 0; i < n; i++) {
+        // Corner angles from the edges a = p1 - p0, b = p2 - p0, c = p2 - p1
+        float cx = bx[i] - ax[i], cy = by[i] - ay[i], cz = bz[i] - az[i];
+        float aa = ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i];
+        float bb = bx[i] * bx[i] + by[i] * by[i] + bz[i] * bz[i];
+        float cc = cx * cx + cy * cy + cz * cz;
+        float ab = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+        float ac = ax[i] * cx + ay[i] * cy + az[i] * cz;
+        float bc = bx[i] * cx + by[i] * cy + bz[i] * cz;
+        float d0 = std::sqrt(aa * bb), d1 = std::sqrt(aa * cc), d2 = std::sqrt(bb * cc);
+        w0[i] = d0 > 0.0f ? std::acos(std::clamp( ab / d0, -1.0f, 1.0f)) : 0.0f;
+        w1[i] = d1 > 0.0f ? std::acos(std::clamp(-ac / d1, -1.0f, 1.0f)) : 0.0f;
+        w2[i] = d2 > 0.0f ? std::acos(std::clamp( bc / d2, -1.0f, 1.0f)) : 0.0f;
+    }
+    // Expand to per-corner vectors, back to front so no input is overwritten early
+    for (uint32_t i = n; i-- > 0;) {
+        float len = std::sqrt(out.x[i] * out.x[i] + out.y[i] * out.y[i] + out.z[i] * out.z[i]);
+        float inv = len > 0.0f ? 1.0f / len : 0.0f;
+        float ux = out.x[i] * inv, uy = out.y[i] * inv, uz = out.z[i] * inv;
+        const float w[3] = { w0[i], w1[i], w2[i] };
+        for (uint32_t k = 0; k < 3; k++) {
+            out.x[i * 3 + k] = ux * w[k];
+            out.y[i * 3 + k] = uy * w[k];
+            out.z[i * 3 + k] = uz * w[k];
+        }
+    }
+}
+
+// Normalize the accumulated normals of vertices [begin, end); zero-length
+// sums get the placeholder (0, 1, 0).
+static void normalizeNormals(RawMesh& mesh, uint32_t begin, uint32_t end) {
+    for (uint32_t v = begin; v < end; v++) {
+        glm::vec3& n = mesh.vertices[v].normal;
+        float len = glm::length(n);
+        if (len > 1e-8f) n /= len;
+        else n = glm::vec3(0, 1, 0);
+    }
+}
+
+void computeVertexNormals(RawMesh& mesh, const VertexNormalOptions& options) {
+    uint32_t numVerts = (uint32_t)mesh.vertices.size();
+    uint32_t numTris = mesh.numTris();
+    bool angleWeights = options.weighting == NormalWeighting::Angle;
+    uint32_t perTri = angleWeights ? 3 : 1;  // weighted normals per triangle
+    uint32_t numThreads = options.numThreads ? options.numThreads : getNumWorkerThreads();
+    uint32_t numTasks = std::min(numThreads, std::max(1u, std::min(numTris, numVerts) / MIN_TASK_TRIS));
+
+    for (auto& v : mesh.vertices) v.normal = glm::vec3(0.0f);
+
+    if (numTasks < MIN_PARALLEL_TASKS) {
+        if (!angleWeights) {
+            // Plain scatter: the loop is bound by the vertex loads and stores,
+            // so staging blocks for SIMD does not pay off here
+            for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+                Vertex& v0 = mesh.vertices[mesh.indices[i + 0]];
+                Vertex& v1 = mesh.vertices[mesh.indices[i + 1]];
+                Vertex& v2 = mesh.vertices[mesh.indices[i + 2]];
+                glm::vec3 fn = glm::cross(v1.position - v0.position, v2.position - v0.position);
+                v0.normal += fn;
+                v1.normal += fn;
+                v2.normal += fn;
+            }
+        } else {
+            FaceBlock block;
+            for (uint32_t t0 = 0; t0 < numTris; t0 += BLOCK) {
+                uint32_t n = std::min(BLOCK, numTris - t0);
+                computeFaceBlock(mesh, t0, n, true, block);
+                const uint32_t* idx = &mesh.indices[(size_t)t0 * 3];
+                for (uint32_t c = 0; c < n * 3; c++)
+                    mesh.vertices[idx[c]].normal += glm::vec3(block.x[c], block.y[c], block.z[c]);
+            }
+        }
+        normalizeNormals(mesh, 0, numVerts);
+        return;
+    }
+
+    // Task t owns the vertices [t * vertsPerTask, (t + 1) * vertsPerTask) and
+    // is the only one to write them. Each triangle range routes its corners to
+    // the owners of their vertices; owners replay them in triangle order, so
+    // the sums equal the serial scatter for every thread count.
+    // Owned ranges are a power of two long, so the owner of a vertex is a shift
+    uint32_t ownerShift = 0;
+    while (((uint64_t)numTasks << ownerShift) < numVerts) ownerShift++;
+    uint32_t vertsPerTask = 1u << ownerShift;
+    auto triBegin = [&](uint32_t task) { return (uint32_t)((uint64_t)numTris * task / numTasks); };
+    auto bucket = [&](uint32_t src, uint32_t dst) { return (size_t)dst * numTasks + src; };
+
+    // 1. Weighted face normals, and the number of corners each triangle range
+    //    sends to each owner. Buckets are ordered by (owner, source range).
+    std::vector<glm::vec3> faceNormals((size_t)numTris * perTri);
+    std::vector<uint32_t> bucketStart((size_t)numTasks * numTasks + 1, 0);
+    parallelFor(numTasks, [&](uint32_t src) {
+        FaceBlock block;
+        for (uint32_t t0 = triBegin(src); t0 < triBegin(src + 1); t0 += BLOCK) {
+            uint32_t n = std::min(BLOCK, triBegin(src + 1) - t0);
+            computeFaceBlock(mesh, t0, n, angleWeights, block);
+            glm::vec3* dst = &faceNormals[(size_t)t0 * perTri];
+            for (uint32_t j = 0; j < n * perTri; j++) dst[j] = glm::vec3(block.x[j], block.y[j], block.z[j]);
+        }
+        std::vector<uint32_t> count(numTasks, 0);
+        for (size_t c = (size_t)triBegin(src) * 3; c < (size_t)triBegin(src + 1) * 3; c++)
+            count[(mesh.indices[c] >> ownerShift)]++;
+        for (uint32_t dst = 0; dst < numTasks; dst++) bucketStart[bucket(src, dst) + 1] = count[dst];
+    });
+    for (size_t b = 0; b < (size_t)numTasks * numTasks; b++) bucketStart[b + 1] += bucketStart[b];
+
+    // 2. Route corner ids into their buckets
+    std::vector<uint32_t> corners((size_t)numTris * 3);
+    parallelFor(numTasks, [&](uint32_t src) {
+        std::vector<uint32_t> next(numTasks);
+        for (uint32_t dst = 0; dst < numTasks; dst++) next[dst] = bucketStart[bucket(src, dst)];
+        for (size_t c = (size_t)triBegin(src) * 3; c < (size_t)triBegin(src + 1) * 3; c++)
+            corners[next[(mesh.indices[c] >> ownerShift)]++] = (uint32_t)c;
+    });
+
+    // 3. Each owner sums its corners and normalizes its vertex range
+    parallelFor(numTasks, [&](uint32_t dst) {
+        for (size_t i = bucketStart[bucket(0, dst)]; i < bucketStart[bucket(0, dst + 1)]; i++) {
+            uint32_t c = corners[i];
+            mesh.vertices[mesh.indices[c]].normal += faceNormals[angleWeights ? c : c / 3];
+        }
+        normalizeNormals(mesh, (uint32_t)std::min<uint64_t>((uint64_t)dst * vertsPerTask, numVerts),
+                         (uint32_t)std::min<uint64_t>((uint64_t)(dst + 1) * vertsPerTask, numVerts));
+    });
+}
+
+} // namespace nanite
@@ -1,16 +1,15 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-#include "core/mesh_loader.h"
-#include "build/cluster_dag.h"
+#include "build/async_build.h"
 #include "runtime/packed_view.h"
 #include "runtime/dag_traversal.h"
 #include "runtime/rasterizer.h"
 #include "render/display.h"
 #include "render/camera.h"
 
-#include <chrono>
 #include <cstdio>
+#include <cstdlib>
 #include <string>
 
 using namespace nanite;
@@ -21,7 +20,7 @@ static bool      gMouseCaptured = false;
 static float     gLastMouseX = 0.0f, gLastMouseY = 0.0f;
 static bool      gFirstMouse = true;
 static RenderMode gRenderMode = RenderMode::LODColors;
-static float     gMaxPixelsPerEdge = 1.0f;
+static float     gMaxPixelsPerEdge = MAX_PIXELS_PER_EDGE;
 static bool      gKeysPressed[512] = {};
 
 // --- GLFW Callbacks ---
@@ -107,56 +106,52 @@ int main(int argc, char** argv) {
     printf("=== Nanite Demo - Simplified Virtualized Geometry ===\n\n");
 
     // Parse arguments
-    std::string meshPath = (argc > 1) ? argv[1] : "assets/bunny.obj";
+    std::string meshPath = "assets/bunny.obj";
+    bool useMeshCache = true;
+    LeafClusterOptions leafOptions;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--no-cache") useMeshCache = false;
+        else if (arg == "--graph-clusters") leafOptions.mode = LeafClustering::GraphPartition;
+        else if (arg == "--cluster-size" && i + 1 < argc) {
+            if (!clusterSizeFromTris((uint32_t)atoi(argv[++i]), leafOptions.size)) {
+                fprintf(stderr, "--cluster-size must be 64, 128 or 256\n");
+                return 1;
+            }
+        }
+        else meshPath = arg;
+    }
     int width  = 1280;
     int height = 720;
 
-    // 1. Load mesh
-    printf("Loading mesh: %s\n", meshPath.c_str());
-    RawMesh mesh;
-    if (!loadOBJ(meshPath, mesh)) {
-        fprintf(stderr, "Failed to load mesh. Usage: NaniteDemo <path_to.obj>\n");
-        return 1;
-    }
-    printf("Mesh: %zu vertices, %u triangles\n",
-           mesh.vertices.size(), mesh.numTris());
-
-    // 2. Build Nanite DAG (offline build pipeline)
-    printf("\n--- Building Cluster DAG ---\n");
-    ClusterDAG dag;
-    auto buildStart = std::chrono::high_resolution_clock::now();
-    dag.build(mesh);
-    auto buildEnd = std::chrono::high_resolution_clock::now();
-    float buildMs = std::chrono::duration<float, std::milli>(buildEnd - buildStart).count();
-    printf("Build complete: %.1f ms\n", buildMs);
-
-    int32_t maxMipLevel = dag.getMaxMipLevel();
-
-    // Position camera close to mesh surface so LOD transitions are visible
-    glm::vec3 meshCenter = dag.totalBounds.center();
-    glm::vec3 meshExtent = dag.totalBounds.extent();
-    float meshRadius = glm::length(meshExtent);
-    gCamera.position = meshCenter + glm::vec3(0, 0, meshRadius * 1.2f);
-    gCamera.front = glm::normalize(meshCenter - gCamera.position);
-    gCamera.speed = meshRadius * 0.5f;
-
-    // 3. Init display
+    // 1. Init display first: loading and building run in the background
     Display display;
     if (!display.init(width, height, "Nanite Demo - Simplified Virtualized Geometry")) {
         return 1;
     }
 
+    // 2. Load mesh and build Nanite DAG on a worker thread
+    AsyncMeshBuild meshBuild;
+    meshBuild.start(meshPath, useMeshCache, leafOptions);
+    AsyncBuildState shownState = AsyncBuildState::Loading;
+    bool cameraPlaced = false;
+    float meshRadius = 1.0f;
+    int32_t maxMipLevel = 0;
+    Cluster boundsProxy;
+    ClusterGeometryPool boundsProxyGeometry;
+    PackedDAG packedDAG;
+
     // Set callbacks
     GLFWwindow* win = display.getWindow();
     glfwSetKeyCallback(win, keyCallback);
     glfwSetCursorPosCallback(win, mouseCallback);
     glfwSetScrollCallback(win, scrollCallback);
 
-    // 4. Create framebuffer
+    // 3. Create framebuffer
     Framebuffer fb;
     fb.resize(width, height);
 
-    // 5. Main loop
+    // 4. Main loop
     printf("\n--- Controls ---\n");
     printf("  Tab:       Toggle mouse capture\n");
     printf("  WASD/QE:   Move camera\n");
@@ -180,6 +175,35 @@ int main(int argc, char** argv) {
         glfwPollEvents();
         processInput(deltaTime);
 
+        AsyncBuildSnapshot build = meshBuild.snapshot();
+        if (build.state == AsyncBuildState::Failed) {
+            fprintf(stderr, "Failed to load mesh. Usage: NaniteDemo [--no-cache] [--graph-clusters] [--cluster-size 64|128|256] <mesh.obj|.ply|.stl|.glb|proc:<icosphere|terrain|city>:<tris>>\n");
+            display.shutdown();
+            return 1;
+        }
+        if (build.state != shownState) {
+            shownState = build.state;
+            std::string title = "Nanite Demo - Simplified Virtualized Geometry";
+            if (shownState != AsyncBuildState::Ready) title += std::string(" (") + asyncBuildStateName(shownState) + "...)";
+            glfwSetWindowTitle(win, title.c_str());
+            if (build.dag) {
+                packedDAG.pack(*build.dag);
+                maxMipLevel = packedDAG.maxMipLevel;
+            }
+        }
+
+        // Position camera close to mesh surface so LOD transitions are visible,
+        // as soon as the mesh bounds are known
+        if (!cameraPlaced && build.bounds.valid()) {
+            glm::vec3 meshCenter = build.bounds.center();
+            meshRadius = std::max(glm::length(build.bounds.extent()), 1e-3f);
+            gCamera.position = meshCenter + glm::vec3(0, 0, meshRadius * 1.2f);
+            gCamera.front = glm::normalize(meshCenter - gCamera.position);
+            gCamera.speed = meshRadius * 0.5f;
+            boundsProxy = makeBoundsProxyCluster(build.bounds, boundsProxyGeometry);
+            cameraPlaced = true;
+        }
+
         // Setup view
         PackedView view;
         view.setup(
@@ -191,15 +215,31 @@ int main(int argc, char** argv) {
             gMaxPixelsPerEdge
         );
 
-        // Traverse DAG - select visible clusters
         std::vector<VisibleCluster> visible;
         TraversalStats traversalStats;
-        traverseDAG(dag, view, visible, traversalStats);
-
-        // Rasterize
-        fb.clear();
         RasterStats rasterStats;
-        rasterize(dag.clusters, visible, view, fb, gRenderMode, rasterStats, maxMipLevel);
+        fb.clear();
+        if (build.dag) {
+            // Traverse DAG - select visible clusters, then rasterize
+            traverseDAG(packedDAG, view, visible, traversalStats);
+            if (build.geometry) {
+                rasterize(*build.geometry, visible, view, fb, gRenderMode, rasterStats, maxMipLevel);
+            } else {
+                rasterize(build.dag->geometry, build.dag->clusters, visible, view, fb, gRenderMode, rasterStats, maxMipLevel);
+            }
+        } else if (build.preview) {
+            // Coarsest level built so far, drawn whole
+            for (uint32_t ci = 0; ci < (uint32_t)build.preview->clusters.size(); ci++) {
+                visible.push_back({ ci, build.preview->mipLevel });
+            }
+            traversalStats.clustersSelected = (uint32_t)visible.size();
+            traversalStats.totalTriangles = build.preview->numTris;
+            rasterize(build.preview->geometry, build.preview->clusters, visible, view, fb, gRenderMode, rasterStats, build.preview->mipLevel);
+        } else if (cameraPlaced) {
+            // Mesh loaded but no level small enough yet: draw its bounds
+            visible.push_back({ 0, 0 });
+            rasterize(boundsProxyGeometry, { boundsProxy }, visible, view, fb, RenderMode::Wireframe, rasterStats, 0);
+        }
 
         // Display
         display.present(fb);
@@ -209,13 +249,15 @@ int main(int argc, char** argv) {
         statTimer += deltaTime;
         if (statTimer >= 1.0f) {
             float fps = (float)frameCount / statTimer;
-            printf("\r[%s] FPS: %.1f | Clusters: %u/%zu visible | Tris: %u | Culled: %u | PxPerEdge: %.2f   ",
+            printf("\r[%s] %s | FPS: %.1f | Clusters: %u/%zu visible | Tris: %u | Culled: %u+%u | PxPerEdge: %.2f   ",
                    renderModeName(gRenderMode),
+                   asyncBuildStateName(build.state),
                    fps,
                    traversalStats.clustersSelected,
-                   dag.clusters.size(),
+                   build.dag ? build.dag->clusters.size() : (build.preview ? build.preview->clusters.size() : 0),
                    traversalStats.totalTriangles,
                    traversalStats.clustersFrustumCulled,
+                   traversalStats.clustersBackfaceCulled,
                    gMaxPixelsPerEdge);
             fflush(stdout);
             frameCount = 0;
@@ -224,6 +266,7 @@ int main(int argc, char** argv) {
     }
 
     printf("\n\nShutting down...\n");
+    meshBuild.cancel();
     display.shutdown();
     return 0;
 }
@@ -31,10 +31,15 @@ static bool frustumTestAABB(const PackedView& view, const AABB& box) {
 //   projected_error_pixels = pixelsPerUnit * lodError
 //   pixelsPerUnit = (0.5 * proj[1][1] * viewHeight) / depth
 //   Accept coarse LOD if projected_error_pixels <= maxPixelsPerEdge
+//
+// depth is that of the sphere's nearest point, so the error bounds every
+// part of the group; a camera inside the sphere always refines. This
+// projects more error than the center depth did, hence the default
+// MAX_PIXELS_PER_EDGE of 2.
 static float computeProjectedError(const PackedView& view, const BoundingSphere& sphere, float lodError) {
     // Transform sphere center to view space
     glm::vec4 viewPos = view.viewMatrix * glm::vec4(sphere.center, 1.0f);
-    float z = -viewPos.z; // depth (positive into screen)
+    float z = -viewPos.z - sphere.radius; // nearest depth (positive into screen)
 
     if (z <= view.nearPlane * 0.5f) {
         // Very close or behind camera: force maximum refinement
@@ -47,7 +52,7 @@ static float computeProjectedError(const PackedView& view, const BoundingSphere&
 }
 
 void traverseDAG(
-    const ClusterDAG& dag,
+    const PackedDAG& dag,
     const PackedView& view,
     std::vector<VisibleCluster>& outVisible,
     TraversalStats& outStats)
@@ -55,25 +60,30 @@ void traverseDAG(
     outVisible.clear();
     outStats = {};
 
-    int32_t maxLevel = dag.getMaxMipLevel();
-    outStats.clustersByLevel.resize(maxLevel + 1, 0);
+    outStats.clustersByLevel.resize(dag.maxMipLevel + 1, 0);
 
-    // Get root groups as starting points
-    std::vector<uint32_t> rootGroups = dag.getRootGroupIndices();
-    if (rootGroups.empty()) return;
+    // Root groups are the starting points
+    if (dag.rootGroups.empty()) return;
 
-    // Stack-based traversal of the group hierarchy
+    // Stack-based traversal of the group hierarchy. The parents of one group
+    // can land in several groups, so a group is reachable along many paths:
+    // visit each one once (the decision only depends on the group itself).
     std::stack<uint32_t> groupStack;
-    for (uint32_t gi : rootGroups) {
+    BitSet visitedGroups(dag.groups.size());
+    for (uint32_t gi : dag.rootGroups) {
         groupStack.push(gi);
     }
 
     while (!groupStack.empty()) {
         uint32_t gi = groupStack.top();
         groupStack.pop();
+        if (visitedGroups[gi]) continue;
+        visitedGroups.set(gi);
 
-        const ClusterGroup& group = dag.groups[gi];
-        outStats.totalClustersVisited += (uint32_t)group.children.size();
+        const PackedGroup& group = dag.groups[gi];
+        const uint32_t* children = &dag.groupClusters[group.firstCluster];
+        const uint32_t* parents = children + group.numChildren;
+        outStats.totalClustersVisited += group.numChildren;
 
         // LOD Decision:
         // Compute the projected error (in pixels) if we use the parent clusters.
@@ -84,7 +94,7 @@ void traverseDAG(
         float projectedError = computeProjectedError(view, group.lodBounds, group.parentLODError);
         bool useParentLevel;
 
-        if (group.parentLODError <= 0.0f || group.parentClusters.empty()) {
+        if (group.parentLODError <= 0.0f || group.numParents == 0) {
             // No parent clusters or leaf level: must descend to children
             useParentLevel = false;
         } else {
@@ -93,14 +103,19 @@ void traverseDAG(
 
         if (useParentLevel) {
             // Render the parent clusters generated by this group (coarser LOD)
-            for (uint32_t ci : group.parentClusters) {
-                const Cluster& cluster = dag.clusters[ci];
+            for (uint32_t p = 0; p < group.numParents; p++) {
+                uint32_t ci = parents[p];
+                const PackedCluster& cluster = dag.clusters[ci];
 
                 // Frustum cull
                 if (!frustumTestAABB(view, cluster.bounds)) {
                     outStats.clustersFrustumCulled++;
                     continue;
                 }
+                if (dag.cones[ci].backfacing(view.viewOrigin)) {
+                    outStats.clustersBackfaceCulled++;
+                    continue;
+                }
 
                 outVisible.push_back({ ci, cluster.mipLevel });
                 outStats.clustersSelected++;
@@ -111,8 +126,9 @@ void traverseDAG(
             }
         } else {
             // Need finer detail: process child clusters
-            for (uint32_t ci : group.children) {
-                const Cluster& cluster = dag.clusters[ci];
+            for (uint32_t c = 0; c < group.numChildren; c++) {
+                uint32_t ci = children[c];
+                const PackedCluster& cluster = dag.clusters[ci];
 
                 // Frustum cull first
                 if (!frustumTestAABB(view, cluster.bounds)) {
@@ -122,8 +138,12 @@ void traverseDAG(
 
                 // If this child cluster was produced by reducing a finer group,
                 // descend into that group for further LOD evaluation.
-                if (cluster.generatingGroupIndex != INVALID_INDEX) {
-                    groupStack.push(cluster.generatingGroupIndex);
+                if (cluster.generatingGroup != INVALID_INDEX) {
+                    groupStack.push(cluster.generatingGroup);
+                } else if (dag.cones[ci].backfacing(view.viewOrigin)) {
+                    // Leaf cluster facing away. (A cluster with a finer level
+                    // is never cone culled: its children face other ways.)
+                    outStats.clustersBackfaceCulled++;
                 } else {
                     // Leaf cluster: no finer level exists. Render it.
                     outVisible.push_back({ ci, cluster.mipLevel });
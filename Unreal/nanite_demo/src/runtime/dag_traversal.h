@@ -1,7 +1,7 @@
 #pragma once
 
 #include "../core/types.h"
-#include "../build/cluster_dag.h"
+#include "packed_dag.h"
 #include "packed_view.h"
 
 namespace nanite {
@@ -10,6 +10,7 @@ struct TraversalStats {
     uint32_t totalClustersVisited = 0;
     uint32_t clustersSelected     = 0;
     uint32_t clustersFrustumCulled = 0;
+    uint32_t clustersBackfaceCulled = 0;    // all triangles facing away
     uint32_t totalTriangles       = 0;
     std::vector<uint32_t> clustersByLevel;  // count per mipLevel
 };
@@ -24,9 +25,11 @@ struct VisibleCluster {
 //   - Start at root groups
 //   - Compute projected screen-space error
 //   - If error acceptable, render current level; else descend
-//   - Apply frustum culling per cluster
+//   - Apply frustum culling per cluster, and normal cone culling to the
+//     clusters selected for rendering
+// Reads only the packed traversal data (see PackedDAG::pack).
 void traverseDAG(
-    const ClusterDAG& dag,
+    const PackedDAG& dag,
     const PackedView& view,
     std::vector<VisibleCluster>& outVisible,
     TraversalStats& outStats
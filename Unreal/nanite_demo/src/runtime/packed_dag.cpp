@@ -0,0 +1,56 @@
+#include "packed_dag.h"
+#include <algorithm>
+#include <cmath>
+
+namespace nanite {
+
+void PackedCone::pack(const NormalCone& cone) {
+    *this = {};
+    if (cone.cutoff >= 1.0f) return;
+    apex = cone.apex;
+    // A unit view direction u has dot(u, q) <= dot(u, axis) + sum|q - axis|
+    // for the rounded axis q, so raising the cutoff by that sum (rounded up,
+    // plus a step of slack) keeps every culled eye inside the float cone
+    float axisError = 0.0f;
+    for (int a = 0; a < 3; a++) {
+        float q = std::round(std::max(-1.0f, std::min(1.0f, cone.axis[a])) * 127.0f);
+        axis[a] = (int8_t)q;
+        axisError += std::abs(q / 127.0f - cone.axis[a]);
+    }
+    float q = std::ceil((cone.cutoff + axisError) * 127.0f) + 1.0f;
+    cutoff = (int8_t)std::min(127.0f, q);
+}
+
+void PackedDAG::pack(const ClusterDAG& dag) {
+    clusters.resize(dag.clusters.size());
+    cones.resize(dag.clusters.size());
+    maxMipLevel = 0;
+    for (size_t i = 0; i < dag.clusters.size(); i++) {
+        const Cluster& c = dag.clusters[i];
+        PackedCluster& pc = clusters[i];
+        pc.bounds          = c.bounds;
+        pc.generatingGroup = c.generatingGroupIndex;
+        pc.numTris         = (uint16_t)c.numTris;   // at most ClusterConfig::CLUSTER_SIZE
+        pc.mipLevel        = (int16_t)c.mipLevel;
+        cones[i].pack(c.normalCone);
+        maxMipLevel = std::max(maxMipLevel, c.mipLevel);
+    }
+
+    groups.resize(dag.groups.size());
+    groupClusters.clear();
+    rootGroups.clear();
+    for (uint32_t gi = 0; gi < (uint32_t)dag.groups.size(); gi++) {
+        const ClusterGroup& g = dag.groups[gi];
+        PackedGroup& pg = groups[gi];
+        pg.lodBounds      = g.lodBounds;
+        pg.parentLODError = g.parentLODError;
+        pg.firstCluster   = (uint32_t)groupClusters.size();
+        pg.numChildren    = (uint32_t)g.children.size();
+        pg.numParents     = (uint32_t)g.parentClusters.size();
+        groupClusters.insert(groupClusters.end(), g.children.begin(), g.children.end());
+        groupClusters.insert(groupClusters.end(), g.parentClusters.begin(), g.parentClusters.end());
+        if (g.isRoot) rootGroups.push_back(gi);
+    }
+}
+
+} // namespace nanite
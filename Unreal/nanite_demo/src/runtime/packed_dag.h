@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../core/types.h"
+#include "../build/cluster_dag.h"
+
+namespace nanite {
+
+// Traversal-critical fields of one Cluster, two per cache line. The index
+// is the same as in ClusterDAG::clusters, which holds the geometry
+// (ClusterGeometryPool offsets) and the cold build metadata.
+struct alignas(32) PackedCluster {
+    AABB     bounds;
+    uint32_t generatingGroup = INVALID_INDEX; // INVALID_INDEX for leaves
+    uint16_t numTris  = 0;
+    int16_t  mipLevel = 0;
+};
+static_assert(sizeof(PackedCluster) == 32, "PackedCluster should stay half a cache line");
+
+// A cluster's NormalCone with the axis and cutoff as 8-bit snorm, rounded
+// so the cone only shrinks: backfacing() may keep a cluster the float cone
+// would cull, never the reverse. Only read for clusters about to be
+// selected, so it lives in its own array.
+struct PackedCone {
+    glm::vec3 apex = glm::vec3(0.0f);
+    int8_t    axis[3] = { 0, 0, 127 };
+    int8_t    cutoff  = 127;            // 127 = never culled
+
+    void pack(const NormalCone& cone);
+
+    bool backfacing(const glm::vec3& eye) const {
+        if (cutoff >= 127) return false;
+        glm::vec3 d = apex - eye;
+        return d.x * axis[0] + d.y * axis[1] + d.z * axis[2] >= (float)cutoff * glm::length(d);
+    }
+};
+static_assert(sizeof(PackedCone) == 16, "PackedCone should stay 16 bytes");
+
+// Traversal-critical fields of one ClusterGroup (same index as in
+// ClusterDAG::groups). Its children are PackedDAG::groupClusters[
+// firstCluster ..+ numChildren), directly followed by its numParents
+// parent clusters.
+struct alignas(32) PackedGroup {
+    BoundingSphere lodBounds;
+    float          parentLODError = 0.0f;
+    uint32_t       firstCluster = 0;
+    uint32_t       numChildren  = 0;
+    uint32_t       numParents   = 0;
+};
+static_assert(sizeof(PackedGroup) == 32, "PackedGroup should stay half a cache line");
+
+// Runtime copy of a ClusterDAG holding only what traverseDAG reads, so a
+// traversal streams through a few compact arrays instead of loading whole
+// Cluster and ClusterGroup objects (and their vectors).
+struct PackedDAG {
+    std::vector<PackedCluster> clusters;
+    std::vector<PackedCone>    cones;       // parallel to clusters
+    std::vector<PackedGroup>   groups;
+    std::vector<uint32_t>      groupClusters;
+    std::vector<uint32_t>      rootGroups;
+    int32_t                    maxMipLevel = 0;
+
+    // Rebuild from `dag` (once per finished build, not per frame)
+    void pack(const ClusterDAG& dag);
+};
+
+} // namespace nanite
@@ -18,7 +18,7 @@ struct PackedView {
     int   viewHeight = 720;
 
     float lodScale = 1.0f;            // LOD selection scale factor
-    float maxPixelsPerEdge = 1.0f;    // quality control
+    float maxPixelsPerEdge = MAX_PIXELS_PER_EDGE; // quality control
 
     // 6 frustum planes: left, right, bottom, top, near, far
     // (a, b, c, d) where ax + by + cz + d >= 0 is inside
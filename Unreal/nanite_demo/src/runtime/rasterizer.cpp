@@ -84,167 +84,230 @@ struct ScreenVertex {
     glm::vec3 normal;
 };
 
-void rasterize(
-    const std::vector<Cluster>& clusters,
-    const std::vector<VisibleCluster>& visible,
-    const PackedView& view,
-    Framebuffer& fb,
-    RenderMode mode,
-    RasterStats& stats,
-    int32_t maxMipLevel)
-{
-    stats = {};
-
+// Per-call state, and per-cluster screen-space vertices reused across clusters
+struct RasterContext {
+    const PackedView& view;
+    Framebuffer&      fb;
+    RenderMode        mode;
+    RasterStats&      stats;
+    int32_t           maxMipLevel;
     // Simple directional light for shading
-    glm::vec3 lightDir = glm::normalize(glm::vec3(0.3f, 0.8f, 0.5f));
-
-    for (const auto& vc : visible) {
-        const Cluster& cluster = clusters[vc.clusterIndex];
-
-        // Transform all cluster vertices to screen space
-        std::vector<ScreenVertex> screenVerts(cluster.vertices.size());
-        std::vector<bool> vertVisible(cluster.vertices.size(), true);
+    glm::vec3         lightDir = glm::normalize(glm::vec3(0.3f, 0.8f, 0.5f));
 
-        for (size_t v = 0; v < cluster.vertices.size(); v++) {
-            glm::vec4 clip = view.viewProjMatrix * glm::vec4(cluster.vertices[v].position, 1.0f);
+    std::vector<ScreenVertex> screenVerts;
+    std::vector<uint8_t>      vertVisible;
 
-            if (clip.w <= 0.0f) {
-                vertVisible[v] = false;
-                continue;
-            }
+    RasterContext(const PackedView& v, Framebuffer& f, RenderMode m, RasterStats& s, int32_t maxMip)
+        : view(v), fb(f), mode(m), stats(s), maxMipLevel(maxMip) {}
 
-            // Perspective divide -> NDC
-            float invW = 1.0f / clip.w;
-            float ndcX = clip.x * invW;
-            float ndcY = clip.y * invW;
-            float ndcZ = clip.z * invW;
-
-            // NDC [-1, 1] -> screen [0, width/height]
-            screenVerts[v].x = (ndcX * 0.5f + 0.5f) * (float)fb.width;
-            screenVerts[v].y = (1.0f - (ndcY * 0.5f + 0.5f)) * (float)fb.height; // flip Y
-            screenVerts[v].z = ndcZ * 0.5f + 0.5f; // [0, 1] depth
-            screenVerts[v].normal = cluster.vertices[v].normal;
+    void beginCluster(uint32_t numVertices) {
+        if (screenVerts.size() < numVertices) {
+            screenVerts.resize(numVertices);
+            vertVisible.resize(numVertices);
         }
+    }
 
-        // Rasterize each triangle
-        for (uint32_t t = 0; t < cluster.numTris; t++) {
-            uint32_t i0 = cluster.indices[t * 3 + 0];
-            uint32_t i1 = cluster.indices[t * 3 + 1];
-            uint32_t i2 = cluster.indices[t * 3 + 2];
+    // Transform one cluster vertex (position with w = 1) to screen space
+    void projectVertex(uint32_t v, const glm::vec4& position, const glm::vec3& normal) {
+        glm::vec4 clip = view.viewProjMatrix * position;
 
-            if (!vertVisible[i0] || !vertVisible[i1] || !vertVisible[i2]) continue;
+        vertVisible[v] = clip.w > 0.0f;
+        if (!vertVisible[v]) return;
 
-            const ScreenVertex& sv0 = screenVerts[i0];
-            const ScreenVertex& sv1 = screenVerts[i1];
-            const ScreenVertex& sv2 = screenVerts[i2];
+        // Perspective divide -> NDC
+        float invW = 1.0f / clip.w;
+        float ndcX = clip.x * invW;
+        float ndcY = clip.y * invW;
+        float ndcZ = clip.z * invW;
 
-            // Signed area (2x) for backface culling
-            float signedArea2 = (sv1.x - sv0.x) * (sv2.y - sv0.y)
-                              - (sv2.x - sv0.x) * (sv1.y - sv0.y);
+        // NDC [-1, 1] -> screen [0, width/height]
+        screenVerts[v].x = (ndcX * 0.5f + 0.5f) * (float)fb.width;
+        screenVerts[v].y = (1.0f - (ndcY * 0.5f + 0.5f)) * (float)fb.height; // flip Y
+        screenVerts[v].z = ndcZ * 0.5f + 0.5f; // [0, 1] depth
+        screenVerts[v].normal = normal;
+    }
+};
 
-            if (signedArea2 >= 0.0f) {
-                stats.trianglesBackfaceCulled++;
-                continue; // backface
-            }
+// Rasterize the triangles of one cluster whose vertices were projected
+template<typename Index>
+static void rasterizeTriangles(RasterContext& ctx, const VisibleCluster& vc, const Index* indices, uint32_t numTris) {
+    Framebuffer& fb = ctx.fb;
+    RasterStats& stats = ctx.stats;
+    const RenderMode mode = ctx.mode;
+    const int32_t maxMipLevel = ctx.maxMipLevel;
+    const glm::vec3 lightDir = ctx.lightDir;
+    const ScreenVertex* screenVerts = ctx.screenVerts.data();
+    const uint8_t* vertVisible = ctx.vertVisible.data();
+
+    // Rasterize each triangle
+    for (uint32_t t = 0; t < numTris; t++) {
+        uint32_t i0 = indices[t * 3 + 0];
+        uint32_t i1 = indices[t * 3 + 1];
+        uint32_t i2 = indices[t * 3 + 2];
+
+        if (!vertVisible[i0] || !vertVisible[i1] || !vertVisible[i2]) continue;
+
+        const ScreenVertex& sv0 = screenVerts[i0];
+        const ScreenVertex& sv1 = screenVerts[i1];
+        const ScreenVertex& sv2 = screenVerts[i2];
+
+        // Signed area (2x) for backface culling
+        float signedArea2 = (sv1.x - sv0.x) * (sv2.y - sv0.y)
+                          - (sv2.x - sv0.x) * (sv1.y - sv0.y);
+
+        if (signedArea2 >= 0.0f) {
+            stats.trianglesBackfaceCulled++;
+            continue; // backface
+        }
 
-            float invArea = 1.0f / signedArea2;
+        float invArea = 1.0f / signedArea2;
 
-            // Bounding box (clipped to framebuffer)
-            int minX = std::max(0, (int)std::floor(std::min({ sv0.x, sv1.x, sv2.x })));
-            int maxX = std::min(fb.width - 1, (int)std::ceil(std::max({ sv0.x, sv1.x, sv2.x })));
-            int minY = std::max(0, (int)std::floor(std::min({ sv0.y, sv1.y, sv2.y })));
-            int maxY = std::min(fb.height - 1, (int)std::ceil(std::max({ sv0.y, sv1.y, sv2.y })));
+        // Bounding box (clipped to framebuffer)
+        int minX = std::max(0, (int)std::floor(std::min({ sv0.x, sv1.x, sv2.x })));
+        int maxX = std::min(fb.width - 1, (int)std::ceil(std::max({ sv0.x, sv1.x, sv2.x })));
+        int minY = std::max(0, (int)std::floor(std::min({ sv0.y, sv1.y, sv2.y })));
+        int maxY = std::min(fb.height - 1, (int)std::ceil(std::max({ sv0.y, sv1.y, sv2.y })));
 
-            if (minX > maxX || minY > maxY) continue;
+        if (minX > maxX || minY > maxY) continue;
 
-            stats.trianglesRasterized++;
+        stats.trianglesRasterized++;
 
-            for (int py = minY; py <= maxY; py++) {
-                for (int px = minX; px <= maxX; px++) {
-                    float x = (float)px + 0.5f;
-                    float y = (float)py + 0.5f;
+        for (int py = minY; py <= maxY; py++) {
+            for (int px = minX; px <= maxX; px++) {
+                float x = (float)px + 0.5f;
+                float y = (float)py + 0.5f;
 
-                    // Barycentric coordinates via edge functions
-                    float w0 = ((sv1.x - x) * (sv2.y - y) - (sv2.x - x) * (sv1.y - y)) * invArea;
-                    float w1 = ((sv2.x - x) * (sv0.y - y) - (sv0.x - x) * (sv2.y - y)) * invArea;
-                    float w2 = 1.0f - w0 - w1;
+                // Barycentric coordinates via edge functions
+                float w0 = ((sv1.x - x) * (sv2.y - y) - (sv2.x - x) * (sv1.y - y)) * invArea;
+                float w1 = ((sv2.x - x) * (sv0.y - y) - (sv0.x - x) * (sv2.y - y)) * invArea;
+                float w2 = 1.0f - w0 - w1;
 
-                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+                if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
 
-                    // Interpolate depth
-                    float depth = w0 * sv0.z + w1 * sv1.z + w2 * sv2.z;
+                // Interpolate depth
+                float depth = w0 * sv0.z + w1 * sv1.z + w2 * sv2.z;
 
-                    // Depth test
-                    int fbIdx = py * fb.width + px;
-                    if (depth >= fb.depth[fbIdx]) continue;
+                // Depth test
+                int fbIdx = py * fb.width + px;
+                if (depth >= fb.depth[fbIdx]) continue;
 
-                    fb.depth[fbIdx] = depth;
-                    fb.visBuffer[fbIdx] = { vc.clusterIndex, t };
-                    stats.pixelsWritten++;
+                fb.depth[fbIdx] = depth;
+                fb.visBuffer[fbIdx] = { vc.clusterIndex, t };
+                stats.pixelsWritten++;
 
-                    // Compute color based on render mode
-                    uint8_t r = 128, g = 128, b = 128;
+                // Compute color based on render mode
+                uint8_t r = 128, g = 128, b = 128;
 
-                    switch (mode) {
-                    case RenderMode::Solid:
-                    case RenderMode::Wireframe: {
-                        // Interpolate normal and do basic N.L shading
-                        glm::vec3 normal = glm::normalize(
-                            w0 * sv0.normal + w1 * sv1.normal + w2 * sv2.normal);
-                        float ndotl = std::max(0.0f, glm::dot(normal, lightDir));
-                        float ambient = 0.15f;
-                        float shade = ambient + (1.0f - ambient) * ndotl;
-                        r = g = b = (uint8_t)(shade * 230.0f);
+                switch (mode) {
+                case RenderMode::Solid:
+                case RenderMode::Wireframe: {
+                    // Interpolate normal and do basic N.L shading
+                    glm::vec3 normal = glm::normalize(
+                        w0 * sv0.normal + w1 * sv1.normal + w2 * sv2.normal);
+                    float ndotl = std::max(0.0f, glm::dot(normal, lightDir));
+                    float ambient = 0.15f;
+                    float shade = ambient + (1.0f - ambient) * ndotl;
+                    r = g = b = (uint8_t)(shade * 230.0f);
 
-                        if (mode == RenderMode::Wireframe) {
-                            float minBary = std::min({ w0, w1, w2 });
-                            if (minBary < 0.02f) { r = 0; g = 255; b = 100; }
-                        }
-                        break;
-                    }
-                    case RenderMode::LODColors: {
-                        lodColor(vc.mipLevel, maxMipLevel, r, g, b);
-                        // Apply some shading on top
-                        glm::vec3 normal = glm::normalize(
-                            w0 * sv0.normal + w1 * sv1.normal + w2 * sv2.normal);
-                        float shade = 0.3f + 0.7f * std::max(0.0f, glm::dot(normal, lightDir));
-                        r = (uint8_t)(r * shade);
-                        g = (uint8_t)(g * shade);
-                        b = (uint8_t)(b * shade);
-                        break;
-                    }
-                    case RenderMode::ClusterColors: {
-                        clusterColor(vc.clusterIndex, r, g, b);
-                        glm::vec3 normal = glm::normalize(
-                            w0 * sv0.normal + w1 * sv1.normal + w2 * sv2.normal);
-                        float shade = 0.3f + 0.7f * std::max(0.0f, glm::dot(normal, lightDir));
-                        r = (uint8_t)(r * shade);
-                        g = (uint8_t)(g * shade);
-                        b = (uint8_t)(b * shade);
-                        break;
-                    }
-                    case RenderMode::VisBuffer: {
-                        // Encode clusterID and triID as color
-                        r = (uint8_t)(vc.clusterIndex & 0xFF);
-                        g = (uint8_t)((vc.clusterIndex >> 8) & 0xFF);
-                        b = (uint8_t)(t & 0xFF);
-                        break;
+                    if (mode == RenderMode::Wireframe) {
+                        float minBary = std::min({ w0, w1, w2 });
+                        if (minBary < 0.02f) { r = 0; g = 255; b = 100; }
                     }
-                    case RenderMode::Depth: {
-                        // Map depth [0..1] to grayscale (with gamma for visibility)
-                        float d = std::pow(depth, 0.3f);
-                        uint8_t val = (uint8_t)(d * 255.0f);
-                        r = g = b = val;
-                        break;
-                    }
-                    default: break;
-                    }
-
-                    fb.setPixel(px, py, r, g, b);
+                    break;
+                }
+                case RenderMode::LODColors: {
+                    lodColor(vc.mipLevel, maxMipLevel, r, g, b);
+                    // Apply some shading on top
+                    glm::vec3 normal = glm::normalize(
+                        w0 * sv0.normal + w1 * sv1.normal + w2 * sv2.normal);
+                    float shade = 0.3f + 0.7f * std::max(0.0f, glm::dot(normal, lightDir));
+                    r = (uint8_t)(r * shade);
+                    g = (uint8_t)(g * shade);
+                    b = (uint8_t)(b * shade);
+                    break;
+                }
+                case RenderMode::ClusterColors: {
+                    clusterColor(vc.clusterIndex, r, g, b);
+                    glm::vec3 normal = glm::normalize(
+                        w0 * sv0.normal + w1 * sv1.normal + w2 * sv2.normal);
+                    float shade = 0.3f + 0.7f * std::max(0.0f, glm::dot(normal, lightDir));
+                    r = (uint8_t)(r * shade);
+                    g = (uint8_t)(g * shade);
+                    b = (uint8_t)(b * shade);
+                    break;
+                }
+                case RenderMode::VisBuffer: {
+                    // Encode clusterID and triID as color
+                    r = (uint8_t)(vc.clusterIndex & 0xFF);
+                    g = (uint8_t)((vc.clusterIndex >> 8) & 0xFF);
+                    b = (uint8_t)(t & 0xFF);
+                    break;
+                }
+                case RenderMode::Depth: {
+                    // Map depth [0..1] to grayscale (with gamma for visibility)
+                    float d = std::pow(depth, 0.3f);
+                    uint8_t val = (uint8_t)(d * 255.0f);
+                    r = g = b = val;
+                    break;
+                }
+                default: break;
                 }
+
+                fb.setPixel(px, py, r, g, b);
             }
         }
     }
 }
 
+void rasterize(
+    const ClusterGeometryPool& geometry,
+    const std::vector<Cluster>& clusters,
+    const std::vector<VisibleCluster>& visible,
+    const PackedView& view,
+    Framebuffer& fb,
+    RenderMode mode,
+    RasterStats& stats,
+    int32_t maxMipLevel)
+{
+    stats = {};
+    RasterContext ctx(view, fb, mode, stats, maxMipLevel);
+    for (const auto& vc : visible) {
+        const Cluster& cluster = clusters[vc.clusterIndex];
+        const Vertex* vertices = geometry.clusterVertices(cluster);
+
+        // Transform all cluster vertices to screen space
+        ctx.beginCluster(cluster.numVertices);
+        for (uint32_t v = 0; v < cluster.numVertices; v++) {
+            ctx.projectVertex(v, glm::vec4(vertices[v].position, 1.0f), vertices[v].normal);
+        }
+        rasterizeTriangles(ctx, vc, geometry.clusterIndices(cluster), cluster.numTris);
+    }
+}
+
+void rasterize(
+    const EncodedGeometry& geometry,
+    const std::vector<VisibleCluster>& visible,
+    const PackedView& view,
+    Framebuffer& fb,
+    RenderMode mode,
+    RasterStats& stats,
+    int32_t maxMipLevel)
+{
+    stats = {};
+    RasterContext ctx(view, fb, mode, stats, maxMipLevel);
+    std::vector<glm::vec4> positions(MAX_CLUSTER_VERTICES);
+    for (const auto& vc : visible) {
+        const EncodedCluster& cluster = geometry.clusters[vc.clusterIndex];
+        const EncodedVertex* vertices = geometry.clusterVertices(cluster);
+
+        // Decode positions in one pass, normals while projecting
+        geometry.decodePositions(cluster, positions.data());
+        ctx.beginCluster(cluster.numVertices);
+        for (uint32_t v = 0; v < cluster.numVertices; v++) {
+            ctx.projectVertex(v, positions[v], decodeOctahedral(vertices[v].normalX, vertices[v].normalY));
+        }
+        rasterizeTriangles(ctx, vc, geometry.clusterIndices(cluster), cluster.numTris);
+    }
+}
+
 } // namespace nanite
@@ -2,6 +2,7 @@
 
 #include "../core/types.h"
 #include "../build/cluster.h"
+#include "../build/cluster_encoding.h"
 #include "packed_view.h"
 #include "dag_traversal.h"
 
@@ -38,8 +39,10 @@ struct RasterStats {
     uint32_t pixelsWritten = 0;
 };
 
-// Rasterize visible clusters into the framebuffer.
+// Rasterize visible clusters (with their geometry in `geometry`) into the
+// framebuffer.
 void rasterize(
+    const ClusterGeometryPool& geometry,
     const std::vector<Cluster>& clusters,
     const std::vector<VisibleCluster>& visible,
     const PackedView& view,
@@ -49,4 +52,16 @@ void rasterize(
     int32_t maxMipLevel
 );
 
+// Rasterize visible clusters from their encoded geometry (the same clusters
+// as above: geometry.clusters[clusterIndex]), decoding them on the fly.
+void rasterize(
+    const EncodedGeometry& geometry,
+    const std::vector<VisibleCluster>& visible,
+    const PackedView& view,
+    Framebuffer& fb,
+    RenderMode mode,
+    RasterStats& stats,
+    int32_t maxMipLevel
+);
+
 } // namespace nanite